@@ -0,0 +1,172 @@
+#include "acpi.h"
+#include "memory/memory.h"
+#include "string/string.h"
+#include "status.h"
+#include <stddef.h>
+
+static struct acpi_madt_info madt_info;
+static bool madt_found = false;
+
+static bool acpi_checksum_valid(void *ptr, int size)
+{
+    uint8_t sum = 0;
+    uint8_t *bytes = ptr;
+    for (int i = 0; i < size; i++)
+    {
+        sum += bytes[i];
+    }
+    return sum == 0;
+}
+
+static struct acpi_rsdp *acpi_find_rsdp_in(uint32_t start, uint32_t end)
+{
+    // The RSDP is always on a 16 byte boundary
+    for (uint32_t addr = start; addr < end; addr += 16)
+    {
+        struct acpi_rsdp *rsdp = (struct acpi_rsdp *)addr;
+        if (memcmp(rsdp->signature, ACPI_RSDP_SIGNATURE, sizeof(rsdp->signature)) == 0 &&
+            acpi_checksum_valid(rsdp, sizeof(struct acpi_rsdp)))
+        {
+            return rsdp;
+        }
+    }
+
+    return 0;
+}
+
+static struct acpi_rsdp *acpi_find_rsdp()
+{
+    // The first kilobyte of the extended BIOS data area is searched first
+    uint32_t ebda = (uint32_t)(*(uint16_t *)ACPI_EBDA_SEGMENT_POINTER) << 4;
+    struct acpi_rsdp *rsdp = 0;
+    if (ebda)
+    {
+        rsdp = acpi_find_rsdp_in(ebda, ebda + 1024);
+    }
+
+    if (!rsdp)
+    {
+        rsdp = acpi_find_rsdp_in(ACPI_BIOS_AREA_START, ACPI_BIOS_AREA_END);
+    }
+
+    return rsdp;
+}
+
+static struct acpi_madt *acpi_find_madt(struct acpi_rsdp *rsdp)
+{
+    struct acpi_sdt_header *rsdt = (struct acpi_sdt_header *)rsdp->rsdt_address;
+    if (!acpi_checksum_valid(rsdt, rsdt->length))
+    {
+        return 0;
+    }
+
+    int total_tables = (rsdt->length - sizeof(struct acpi_sdt_header)) / sizeof(uint32_t);
+    uint32_t *tables = (uint32_t *)((uint32_t)rsdt + sizeof(struct acpi_sdt_header));
+    for (int i = 0; i < total_tables; i++)
+    {
+        struct acpi_sdt_header *header = (struct acpi_sdt_header *)tables[i];
+        if (memcmp(header->signature, ACPI_MADT_SIGNATURE, sizeof(header->signature)) == 0 &&
+            acpi_checksum_valid(header, header->length))
+        {
+            return (struct acpi_madt *)header;
+        }
+    }
+
+    return 0;
+}
+
+static void acpi_parse_madt_entry(struct acpi_madt_entry *entry)
+{
+    switch (entry->type)
+    {
+    case ACPI_MADT_ENTRY_LOCAL_APIC:
+    {
+        struct acpi_madt_local_apic *local_apic = (struct acpi_madt_local_apic *)entry;
+        if ((local_apic->flags & ACPI_MADT_LOCAL_APIC_ENABLED) && madt_info.total_cpus < COS32_MAX_CPUS)
+        {
+            madt_info.cpu_apic_ids[madt_info.total_cpus] = local_apic->apic_id;
+            madt_info.total_cpus++;
+        }
+    }
+    break;
+
+    case ACPI_MADT_ENTRY_IO_APIC:
+    {
+        // We only drive the IOAPIC that has the ISA interrupts
+        struct acpi_madt_io_apic *io_apic = (struct acpi_madt_io_apic *)entry;
+        if (io_apic->gsi_base == 0)
+        {
+            madt_info.io_apic_address = io_apic->address;
+            madt_info.io_apic_gsi_base = io_apic->gsi_base;
+        }
+    }
+    break;
+
+    case ACPI_MADT_ENTRY_INTERRUPT_OVERRIDE:
+    {
+        struct acpi_madt_interrupt_override *override = (struct acpi_madt_interrupt_override *)entry;
+        if (override->source < ACPI_ISA_IRQS)
+        {
+            madt_info.isa_irqs[override->source].gsi = override->gsi;
+            madt_info.isa_irqs[override->source].flags = override->flags;
+        }
+    }
+    break;
+    }
+}
+
+int acpi_init()
+{
+    int res = 0;
+    memset(&madt_info, 0, sizeof(madt_info));
+
+    // ISA IRQs are identity mapped unless the MADT says otherwise
+    for (int i = 0; i < ACPI_ISA_IRQS; i++)
+    {
+        madt_info.isa_irqs[i].gsi = i;
+    }
+
+    struct acpi_rsdp *rsdp = acpi_find_rsdp();
+    if (!rsdp)
+    {
+        res = -EIO;
+        goto out;
+    }
+
+    struct acpi_madt *madt = acpi_find_madt(rsdp);
+    if (!madt)
+    {
+        res = -EIO;
+        goto out;
+    }
+
+    madt_info.local_apic_address = madt->local_apic_address;
+    uint32_t current = (uint32_t)madt + sizeof(struct acpi_madt);
+    uint32_t end = (uint32_t)madt + madt->header.length;
+    while (current < end)
+    {
+        struct acpi_madt_entry *entry = (struct acpi_madt_entry *)current;
+        if (entry->length == 0)
+        {
+            break;
+        }
+
+        acpi_parse_madt_entry(entry);
+        current += entry->length;
+    }
+
+    if (!madt_info.io_apic_address || madt_info.total_cpus == 0)
+    {
+        res = -EIO;
+        goto out;
+    }
+
+    madt_found = true;
+out:
+    return res;
+}
+
+struct acpi_madt_info *acpi_madt_info()
+{
+    return madt_found ? &madt_info : NULL;
+}
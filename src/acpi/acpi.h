@@ -0,0 +1,123 @@
+#ifndef ACPI_H
+#define ACPI_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+
+#define ACPI_RSDP_SIGNATURE "RSD PTR "
+#define ACPI_MADT_SIGNATURE "APIC"
+
+// The real mode segment of the extended BIOS data area is stored here
+#define ACPI_EBDA_SEGMENT_POINTER 0x40E
+#define ACPI_BIOS_AREA_START 0xE0000
+#define ACPI_BIOS_AREA_END 0x100000
+
+#define ACPI_MADT_ENTRY_LOCAL_APIC 0
+#define ACPI_MADT_ENTRY_IO_APIC 1
+#define ACPI_MADT_ENTRY_INTERRUPT_OVERRIDE 2
+
+#define ACPI_MADT_LOCAL_APIC_ENABLED 0b1
+
+// Interrupt override flags, the defaults for ISA are active high and edge triggered
+#define ACPI_INTERRUPT_POLARITY_MASK 0b11
+#define ACPI_INTERRUPT_POLARITY_LOW 0b11
+#define ACPI_INTERRUPT_TRIGGER_MASK 0b1100
+#define ACPI_INTERRUPT_TRIGGER_LEVEL 0b1100
+
+#define ACPI_ISA_IRQS 16
+
+struct acpi_rsdp
+{
+    char signature[8];
+    uint8_t checksum;
+    char oem_id[6];
+    uint8_t revision;
+    uint32_t rsdt_address;
+} __attribute__((packed));
+
+struct acpi_sdt_header
+{
+    char signature[4];
+    uint32_t length;
+    uint8_t revision;
+    uint8_t checksum;
+    char oem_id[6];
+    char oem_table_id[8];
+    uint32_t oem_revision;
+    uint32_t creator_id;
+    uint32_t creator_revision;
+} __attribute__((packed));
+
+struct acpi_madt
+{
+    struct acpi_sdt_header header;
+    uint32_t local_apic_address;
+    uint32_t flags;
+} __attribute__((packed));
+
+struct acpi_madt_entry
+{
+    uint8_t type;
+    uint8_t length;
+} __attribute__((packed));
+
+struct acpi_madt_local_apic
+{
+    struct acpi_madt_entry entry;
+    uint8_t processor_id;
+    uint8_t apic_id;
+    uint32_t flags;
+} __attribute__((packed));
+
+struct acpi_madt_io_apic
+{
+    struct acpi_madt_entry entry;
+    uint8_t id;
+    uint8_t reserved;
+    uint32_t address;
+    uint32_t gsi_base;
+} __attribute__((packed));
+
+struct acpi_madt_interrupt_override
+{
+    struct acpi_madt_entry entry;
+    uint8_t bus;
+    uint8_t source;
+    uint32_t gsi;
+    uint16_t flags;
+} __attribute__((packed));
+
+struct acpi_isa_irq
+{
+    // The global system interrupt the ISA IRQ is wired to on the IOAPIC
+    uint32_t gsi;
+    uint16_t flags;
+};
+
+// Everything we learnt about the interrupt controllers from the MADT
+struct acpi_madt_info
+{
+    uint32_t local_apic_address;
+    uint32_t io_apic_address;
+    uint32_t io_apic_gsi_base;
+
+    // The local APIC ids of every enabled processor, the boot processor is not always first
+    uint8_t cpu_apic_ids[COS32_MAX_CPUS];
+    int total_cpus;
+
+    struct acpi_isa_irq isa_irqs[ACPI_ISA_IRQS];
+};
+
+/**
+ * Finds and parses the ACPI MADT, returns below zero if the system has no ACPI tables
+ * or no IOAPIC. Must be called before paging is enabled or whilst the kernel page is loaded
+ */
+int acpi_init();
+
+/**
+ * Returns the parsed MADT or NULL if acpi_init failed
+ */
+struct acpi_madt_info *acpi_madt_info();
+
+#endif
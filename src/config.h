@@ -18,30 +18,84 @@
 #define COS32_PROGRAM_VIRTUAL_ADDRESS 0x0400000
 #define COS32_USER_PROGRAM_STACK_SIZE 1024*16
 #define COS32_PROGRAM_VIRTUAL_STACK_ADDRESS_START 0x3FF000
+#define COS32_KTHREAD_STACK_SIZE 1024*16
 
 #define COS32_VIDEO_MEMORY_SIZE 0x20000
 #define COS32_VIDEO_MEMORY_ADDRESS_START 0x000A0000
 #define COS32_VIDEO_MEMORY_ADDRESS_END COS32_VIDEO_MEMORY_ADDRESS_START + COS32_VIDEO_MEMORY_SIZE
 
 
+// The read only info page shared with every process, just above the top of its stack
+#define COS32_INFO_PAGE_VIRTUAL_ADDRESS 0x3FF000
+
 // Stack grows downwards remember
 #define COS32_PROGRAM_VIRTUAL_STACK_ADDRESS_END COS32_PROGRAM_VIRTUAL_STACK_ADDRESS_START - COS32_USER_PROGRAM_STACK_SIZE
 
-#define COS32_MAX_PROCESSES 12
-#define COS32_MAX_DISKS 4
+// Processes are found by id through a hash table with this many buckets, there is no limit on processes
+#define COS32_PROCESS_HASH_BUCKETS 64
+// The maximum amount of threads a process can have including its main thread
+#define COS32_MAX_THREADS_PER_PROCESS 16
+
+#define COS32_MAX_SCHEDULERS 4
+// The maximum amount of processors we will use
+#define COS32_MAX_CPUS 8
+// The maximum amount of interrupt controller backends
+#define COS32_MAX_INTERRUPT_CONTROLLERS 2
+// Set to zero to always use the legacy PIC and PIT even when an APIC is present
+#define COS32_APIC_ENABLED 1
+// The scheduler used at boot, either "roundrobin" or "mlfq"
+#define COS32_DEFAULT_SCHEDULER "mlfq"
+// When enabled the PIT only interrupts us when a deadline is due rather than periodically
+// The PIT stays periodic if the processor has no time stamp counter to keep time with
+#define COS32_TIMER_TICKLESS 1
+// The longest we let the timer go without interrupting us when nothing is due
+#define COS32_TIMER_IDLE_MAX_MS 1000
+
+// The maximum amount of tasks a single task statistics request can return
+#define COS32_MAX_TASK_INFO 64
+// Drives and their partitions, paths name a disk with a single digit
+#define COS32_MAX_DISKS 10
+// The most PCI functions we keep track of
+#define COS32_MAX_PCI_DEVICES 32
+// The most handlers sharing the interrupt lines of PCI devices
+#define COS32_MAX_PCI_INTERRUPT_HANDLERS 16
+// The most requests a virtio block device has in flight at once
+#define COS32_VIRTIO_BLK_MAX_REQUESTS 32
+// The most sectors a program may read from or write to a disk with a single system call
+#define COS32_DISK_READ_MAX_SECTORS 256
+// The most requests a disk's queue holds, waiting and in flight
+#define COS32_DISK_QUEUE_MAX_REQUESTS 64
+// The most of a FAT16 read whose clusters are all asked for before the first is copied
+#define COS32_FAT16_ASYNC_READ_MAX_BYTES 262144
 #define COS32_FORCE_MEMORY_ALIGNMENT 1
 #define COS32_SECTOR_SIZE 512
+
+// Disk data is cached in blocks of this many bytes, must be a multiple of the sector size
+#define COS32_DISK_CACHE_BLOCK_SIZE 4096
+// The amount of blocks in the disk cache
+#define COS32_DISK_CACHE_BLOCKS 256
+#define COS32_DISK_CACHE_HASH_BUCKETS 64
+// The bounds of the window sequential readers have read ahead of them, in sectors
+#define COS32_DISK_READAHEAD_MIN_SECTORS 8
+#define COS32_DISK_READAHEAD_MAX_SECTORS 128
+// Modified blocks are written back by the flusher this often, or sooner once this many are waiting
+#define COS32_DISK_CACHE_FLUSH_INTERVAL_MS 5000
+#define COS32_DISK_CACHE_DIRTY_MAX_BLOCKS 128
 #define COS32_MAX_PATH 108
 
 #define COS32_MAX_INTERRUPTS 512
 #define COS32_MAX_ISR80H_COMMANDS 128
 
+// The amount of recent system calls the tracer remembers
+#define COS32_ISR80H_TRACE_RING_SIZE 256
+
 #define COS32_CODE_SELECTOR 0x08
 #define COS32_DATA_SELECTOR 0x10
 
 #define COS32_PAGE_SIZE 4096
 
-#define COS32_TOTAL_GDT_SEGMENTS 6
+// The standard segments and the kernel TSS followed by a TSS for each application processor
+#define COS32_TOTAL_GDT_SEGMENTS (6 + COS32_MAX_CPUS - 1)
 
 #define COS32_TOTAL_PAGE_ENTRIES_PER_DIRECTORY 1024
 
@@ -0,0 +1,46 @@
+[BITS 32]
+section .asm
+
+global cpu_cpuid
+global cpu_read_msr
+global cpu_write_msr
+
+; void cpu_cpuid(uint32_t leaf, struct cpu_cpuid* out)
+cpu_cpuid:
+    push ebp
+    mov ebp, esp
+    push ebx ; cpuid will trash ebx
+    push edi
+    mov eax, [ebp+8]
+    xor ecx, ecx
+    cpuid
+    mov edi, [ebp+12]
+    mov [edi], eax
+    mov [edi+4], ebx
+    mov [edi+8], ecx
+    mov [edi+12], edx
+    pop edi
+    pop ebx
+    pop ebp
+    ret
+
+; uint64_t cpu_read_msr(uint32_t msr)
+cpu_read_msr:
+    push ebp
+    mov ebp, esp
+    mov ecx, [ebp+8]
+    ; The MSR is returned in edx:eax which is exactly how a 64 bit value is returned
+    rdmsr
+    pop ebp
+    ret
+
+; void cpu_write_msr(uint32_t msr, uint64_t value)
+cpu_write_msr:
+    push ebp
+    mov ebp, esp
+    mov ecx, [ebp+8]
+    mov eax, [ebp+12]
+    mov edx, [ebp+16]
+    wrmsr
+    pop ebp
+    ret
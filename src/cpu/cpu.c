@@ -0,0 +1,80 @@
+#include "cpu.h"
+#include "idt/controllers/apic.h"
+#include "config.h"
+#include "status.h"
+
+static struct cpu cpus[COS32_MAX_CPUS] = {
+    {.id = 0, .online = true}};
+
+// Maps local APIC ids to processor indexes
+static uint8_t apic_id_to_cpu[256];
+
+static int total_cpus = 1;
+static int total_online = 1;
+
+// Until other processors are started everything runs on the boot processor
+static bool lookup_enabled = false;
+
+bool cpu_has_features_edx(uint32_t features)
+{
+    struct cpu_cpuid cpuid;
+    cpu_cpuid(1, &cpuid);
+    return (cpuid.edx & features) == features;
+}
+
+struct cpu *cpu_current()
+{
+    if (!lookup_enabled)
+    {
+        return &cpus[0];
+    }
+
+    return &cpus[apic_id_to_cpu[apic_id()]];
+}
+
+struct cpu *cpu_get(int id)
+{
+    if (id < 0 || id >= total_cpus)
+    {
+        return 0;
+    }
+    return &cpus[id];
+}
+
+int cpu_total_online()
+{
+    return total_online;
+}
+
+int cpu_total()
+{
+    return total_cpus;
+}
+
+int cpu_register(int apic_id)
+{
+    if (total_cpus >= COS32_MAX_CPUS)
+    {
+        return -ENOMEM;
+    }
+
+    int id = total_cpus;
+    cpus[id].id = id;
+    cpus[id].apic_id = apic_id;
+    apic_id_to_cpu[apic_id] = id;
+    total_cpus++;
+    return id;
+}
+
+void cpu_set_online(struct cpu *cpu)
+{
+    cpu->online = true;
+    total_online++;
+}
+
+void cpu_enable_lookup()
+{
+    cpus[0].apic_id = apic_id();
+    apic_id_to_cpu[cpus[0].apic_id] = 0;
+    lookup_enabled = true;
+}
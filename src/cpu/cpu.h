@@ -0,0 +1,110 @@
+#ifndef CPU_H
+#define CPU_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// CPUID leaf 1 feature bits in edx
+#define CPU_FEATURE_EDX_FPU 0b1
+#define CPU_FEATURE_EDX_TSC 0b10000
+#define CPU_FEATURE_EDX_MSR 0b100000
+#define CPU_FEATURE_EDX_APIC 0b1000000000
+#define CPU_FEATURE_EDX_SEP 0b100000000000
+#define CPU_FEATURE_EDX_FXSR 0x1000000
+#define CPU_FEATURE_EDX_SSE 0x2000000
+
+#define CPU_MSR_APIC_BASE 0x1B
+// Set in the APIC base MSR when the local APIC is globally enabled
+#define CPU_MSR_APIC_BASE_ENABLE 0x800
+
+// The code segment, stack and entry point the processor switches to on SYSENTER
+#define CPU_MSR_SYSENTER_CS 0x174
+#define CPU_MSR_SYSENTER_ESP 0x175
+#define CPU_MSR_SYSENTER_EIP 0x176
+
+struct task;
+
+// The state each processor keeps for its self
+struct cpu
+{
+    // Index into the processor table, the boot processor is always zero
+    int id;
+    int apic_id;
+
+    // The task running on this processor
+    struct task *task;
+
+    // Runs when this processor has nothing else to do
+    struct task *idle;
+
+    // The kernel stack interrupts land on when this processor is running a user task
+    void *stack;
+
+    // The task whose state is loaded in the FPU, NULL if nobody's is
+    struct task *fpu_owner;
+
+    // When the one shot timer of this processor is due to interrupt it, in pit_get_millis time
+    long timer_expires_at;
+
+    // True whilst the scheduler may take tasks that belong to other processors
+    bool stealing;
+    bool online;
+};
+
+struct cpu_cpuid
+{
+    uint32_t eax;
+    uint32_t ebx;
+    uint32_t ecx;
+    uint32_t edx;
+};
+
+/**
+ * Runs the CPUID instruction for the given leaf and stores the registers in "out"
+ */
+void cpu_cpuid(uint32_t leaf, struct cpu_cpuid *out);
+
+/**
+ * Returns true if CPUID leaf 1 reports all of the given edx feature bits
+ */
+bool cpu_has_features_edx(uint32_t features);
+
+/**
+ * Returns the processor we are running on
+ */
+struct cpu *cpu_current();
+
+/**
+ * Returns the processor with the given index
+ */
+struct cpu *cpu_get(int id);
+
+/**
+ * Returns how many processors are online and scheduling tasks
+ */
+int cpu_total_online();
+
+/**
+ * Returns how many processors we know about including ones still starting
+ */
+int cpu_total();
+
+/**
+ * Registers a processor by its local APIC id, returns its index or below zero if we have no room
+ */
+int cpu_register(int apic_id);
+
+/**
+ * Marks the current processor as online and able to run tasks
+ */
+void cpu_set_online(struct cpu *cpu);
+
+/**
+ * From now on the current processor is found through its local APIC id
+ */
+void cpu_enable_lookup();
+
+uint64_t cpu_read_msr(uint32_t msr);
+void cpu_write_msr(uint32_t msr, uint64_t value);
+
+#endif
@@ -0,0 +1,87 @@
+[BITS 32]
+section .asm
+
+global fpu_enable
+global fpu_set_task_switched
+global fpu_clear_task_switched
+global fpu_reset
+global fpu_fxsave
+global fpu_fxrstor
+global fpu_fnsave
+global fpu_frstor
+
+CR0_MP equ 0x02
+CR0_EM equ 0x04
+CR0_TS equ 0x08
+CR0_NE equ 0x20
+
+; void fpu_enable(uint32_t cr4_flags)
+fpu_enable:
+    push ebp
+    mov ebp, esp
+    ; Stop emulating the FPU and report its errors as exceptions rather than through the PIC
+    mov eax, cr0
+    and eax, ~CR0_EM
+    or eax, CR0_MP | CR0_NE
+    mov cr0, eax
+
+    ; Processors without FXSAVE may not even have a CR4
+    mov ecx, [ebp+8]
+    test ecx, ecx
+    jz .done
+    mov eax, cr4
+    or eax, ecx
+    mov cr4, eax
+.done:
+    pop ebp
+    ret
+
+; void fpu_set_task_switched()
+fpu_set_task_switched:
+    ; The next FPU or SSE instruction faults so we can load the state of whoever runs it
+    mov eax, cr0
+    or eax, CR0_TS
+    mov cr0, eax
+    ret
+
+; void fpu_clear_task_switched()
+fpu_clear_task_switched:
+    clts
+    ret
+
+; void fpu_reset(uint32_t mxcsr)
+fpu_reset:
+    push ebp
+    mov ebp, esp
+    fninit
+    ; Zero means the processor has no SSE and no MXCSR to load
+    cmp dword [ebp+8], 0
+    je .done
+    ldmxcsr [ebp+8]
+.done:
+    pop ebp
+    ret
+
+; void fpu_fxsave(void* state)
+fpu_fxsave:
+    mov eax, [esp+4]
+    fxsave [eax]
+    ret
+
+; void fpu_fxrstor(void* state)
+fpu_fxrstor:
+    mov eax, [esp+4]
+    fxrstor [eax]
+    ret
+
+; void fpu_fnsave(void* state)
+fpu_fnsave:
+    mov eax, [esp+4]
+    fnsave [eax]
+    ret
+
+; void fpu_frstor(void* state)
+fpu_frstor:
+    mov eax, [esp+4]
+    frstor [eax]
+    ret
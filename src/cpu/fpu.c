@@ -0,0 +1,147 @@
+#include "fpu.h"
+#include "cpu.h"
+#include "task/task.h"
+#include "memory/memory.h"
+#include "memory/kheap.h"
+#include "config.h"
+
+static bool fpu_present = false;
+
+// True if we save with FXSAVE which includes the SSE registers
+static bool fpu_fxsr = false;
+static uint32_t fpu_mxcsr = 0;
+
+// The state a task starts with, copied rather than resetting the FPU so nothing of the previous owner leaks
+static uint8_t fpu_initial_state[FPU_STATE_SIZE] __attribute__((aligned(16)));
+static bool fpu_initial_state_ready = false;
+
+static void fpu_save(void *state)
+{
+    if (fpu_fxsr)
+    {
+        fpu_fxsave(state);
+        return;
+    }
+    fpu_fnsave(state);
+}
+
+static void fpu_restore(void *state)
+{
+    if (fpu_fxsr)
+    {
+        fpu_fxrstor(state);
+        return;
+    }
+    fpu_frstor(state);
+}
+
+void fpu_init()
+{
+    fpu_present = cpu_has_features_edx(CPU_FEATURE_EDX_FPU);
+    if (!fpu_present)
+    {
+        // Emulation stays on so any FPU instruction faults and the task is crashed
+        return;
+    }
+
+    uint32_t cr4_flags = 0;
+    fpu_fxsr = cpu_has_features_edx(CPU_FEATURE_EDX_FXSR);
+    if (fpu_fxsr)
+    {
+        cr4_flags |= FPU_CR4_OSFXSR;
+    }
+
+    if (cpu_has_features_edx(CPU_FEATURE_EDX_SSE))
+    {
+        cr4_flags |= FPU_CR4_OSXMMEXCPT;
+        fpu_mxcsr = FPU_MXCSR_DEFAULT;
+    }
+
+    fpu_enable(cr4_flags);
+    fpu_clear_task_switched();
+    fpu_reset(fpu_mxcsr);
+    if (!fpu_initial_state_ready)
+    {
+        fpu_save(fpu_initial_state);
+        fpu_initial_state_ready = true;
+    }
+
+    // Nobody owns the FPU yet, the first task to use it takes it
+    fpu_set_task_switched();
+}
+
+void fpu_switch(struct cpu *cpu, struct task *from, struct task *to)
+{
+    if (!fpu_present)
+    {
+        return;
+    }
+
+    // Another processor may take the task we are leaving, its state must be in memory before then
+    if (from && from != to && cpu->fpu_owner == from && cpu_total() > 1 && !(from->flags & TASK_FLAG_PINNED))
+    {
+        fpu_clear_task_switched();
+        fpu_save(from->fpu_state);
+        cpu->fpu_owner = 0;
+    }
+
+    if (cpu->fpu_owner == to)
+    {
+        fpu_clear_task_switched();
+        return;
+    }
+
+    fpu_set_task_switched();
+}
+
+bool fpu_handle_device_not_available()
+{
+    struct cpu *cpu = cpu_current();
+    struct task *task = cpu->task;
+    if (!fpu_present)
+    {
+        return false;
+    }
+
+    fpu_clear_task_switched();
+    if (cpu->fpu_owner == task)
+    {
+        return true;
+    }
+
+    if (cpu->fpu_owner)
+    {
+        fpu_save(cpu->fpu_owner->fpu_state);
+        cpu->fpu_owner = 0;
+    }
+
+    if (!task->fpu_state)
+    {
+        // Most tasks never use the FPU so they never pay for the memory
+        task->fpu_state = kzalloc(FPU_STATE_SIZE);
+        if (!task->fpu_state)
+        {
+            return false;
+        }
+        memcpy(task->fpu_state, fpu_initial_state, FPU_STATE_SIZE);
+    }
+
+    fpu_restore(task->fpu_state);
+    cpu->fpu_owner = task;
+    return true;
+}
+
+void fpu_task_free(struct task *task)
+{
+    for (int i = 0; i < COS32_MAX_CPUS; i++)
+    {
+        struct cpu *cpu = cpu_get(i);
+        if (cpu && cpu->fpu_owner == task)
+        {
+            cpu->fpu_owner = 0;
+        }
+    }
+
+    kfree(task->fpu_state);
+    task->fpu_state = 0;
+}
@@ -0,0 +1,51 @@
+#ifndef FPU_H
+#define FPU_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// FXSAVE writes 512 bytes which must be 16 byte aligned, FNSAVE needs far less
+#define FPU_STATE_SIZE 512
+
+#define FPU_CR4_OSFXSR 0x200
+#define FPU_CR4_OSXMMEXCPT 0x400
+
+// Every SSE exception masked, the value the processor resets MXCSR to
+#define FPU_MXCSR_DEFAULT 0x1F80
+
+struct cpu;
+struct task;
+
+/**
+ * Enables the FPU and SSE on the current processor, every processor must call this.
+ * The FPU state of a task is only saved and loaded once the task uses the FPU
+ */
+void fpu_init();
+
+/**
+ * Called when "to" is about to run on the processor instead of "from", costs nothing
+ * for tasks that have never used the FPU
+ */
+void fpu_switch(struct cpu *cpu, struct task *from, struct task *to);
+
+/**
+ * Gives the FPU to the current task, called when it uses the FPU whilst another task's state is loaded.
+ * Returns false if the task can't have the FPU
+ */
+bool fpu_handle_device_not_available();
+
+/**
+ * Frees the FPU state of a task that is going away
+ */
+void fpu_task_free(struct task *task);
+
+void fpu_enable(uint32_t cr4_flags);
+void fpu_set_task_switched();
+void fpu_clear_task_switched();
+void fpu_reset(uint32_t mxcsr);
+void fpu_fxsave(void *state);
+void fpu_fxrstor(void *state);
+void fpu_fnsave(void *state);
+void fpu_frstor(void *state);
+
+#endif
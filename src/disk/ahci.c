@@ -0,0 +1,469 @@
+#include "ahci.h"
+#include "disk.h"
+#include "pci/pci.h"
+#include "task/task.h"
+#include "memory/memory.h"
+#include "memory/kheap.h"
+#include "kernel.h"
+#include "config.h"
+#include "status.h"
+
+static int ahci_submit_request(struct disk *disk, struct disk_request *request);
+static void ahci_poll(void *private);
+
+static struct disk_driver ahci_driver = {
+    .submit = ahci_submit_request,
+    .poll = ahci_poll,
+    .max_sectors = AHCI_REQUEST_SECTORS,
+    .max_segments = AHCI_MAX_PRDS,
+    .queue_depth = AHCI_MAX_SLOTS,
+    .name = "ahci"};
+
+// The registers are memory mapped, the kernel maps every address to itself so we use the physical address
+static volatile struct ahci_hba_registers *hba = 0;
+static struct ahci_port *ports[AHCI_MAX_PORTS];
+
+static int ahci_port_stop(struct ahci_port *port)
+{
+    port->registers->command &= ~(AHCI_PORT_CMD_START | AHCI_PORT_CMD_FIS_RECEIVE);
+    for (int i = 0; i < AHCI_SPIN_LIMIT; i++)
+    {
+        if (!(port->registers->command & (AHCI_PORT_CMD_LIST_RUNNING | AHCI_PORT_CMD_FIS_RUNNING)))
+        {
+            return 0;
+        }
+    }
+
+    return -EIO;
+}
+
+static void ahci_port_start(struct ahci_port *port)
+{
+    port->registers->sata_error = 0xFFFFFFFF;
+    port->registers->interrupt_status = 0xFFFFFFFF;
+    port->registers->command |= AHCI_PORT_CMD_FIS_RECEIVE;
+    port->registers->command |= AHCI_PORT_CMD_START;
+}
+
+/**
+ * Completes every command the port has finished since we last looked. After an error the drive
+ * abandons every queued command so they all fail and the port is restarted
+ */
+static void ahci_port_process(struct ahci_port *port)
+{
+    uint32_t status = port->registers->interrupt_status;
+    port->registers->interrupt_status = status;
+
+    uint32_t done = port->outstanding & ~(port->registers->command_issue | port->registers->sata_active);
+    bool failed = status & AHCI_PORT_IS_ERROR;
+    if (failed)
+    {
+        done = port->outstanding;
+        ahci_port_stop(port);
+        ahci_port_start(port);
+    }
+
+    // Completing a request may issue another in the slot it had
+    port->outstanding &= ~done;
+    for (int slot = 0; slot < AHCI_MAX_SLOTS; slot++)
+    {
+        if (!(done & (1 << slot)))
+        {
+            continue;
+        }
+
+        struct ahci_request *request = &port->requests[slot];
+        if (request->request)
+        {
+            struct disk_request *disk_request = request->request;
+            request->request = 0;
+            request->used = false;
+            disk_request_complete(port->disk, disk_request, failed ? -EIO : 0);
+            continue;
+        }
+
+        request->failed = failed;
+        request->complete = true;
+        if (request->waiter)
+        {
+            task_wake(request->waiter);
+            request->waiter = 0;
+        }
+    }
+}
+
+static void ahci_poll(void *private)
+{
+    struct ahci_port *port = private;
+    ahci_port_process(port);
+    port->hba->interrupt_status = 1 << port->number;
+}
+
+static void ahci_interrupt(void *private)
+{
+    uint32_t status = hba->interrupt_status;
+    for (int i = 0; i < AHCI_MAX_PORTS; i++)
+    {
+        if ((status & (1 << i)) && ports[i])
+        {
+            ahci_port_process(ports[i]);
+        }
+    }
+
+    // Cleared after the ports, the HBA would interrupt again if a port still had something to say
+    hba->interrupt_status = status;
+}
+
+/**
+ * Starts the ATA command in a free slot, reading into the given segments or writing from them
+ */
+static struct ahci_request *ahci_issue(struct ahci_port *port, uint8_t command, unsigned int lba, struct disk_segment *segments, int total_segments)
+{
+    bool write = command == AHCI_ATA_COMMAND_WRITE_DMA || command == AHCI_ATA_COMMAND_WRITE_DMA_EXT || command == AHCI_ATA_COMMAND_WRITE_FPDMA_QUEUED;
+    bool queued = command == AHCI_ATA_COMMAND_READ_FPDMA_QUEUED || command == AHCI_ATA_COMMAND_WRITE_FPDMA_QUEUED;
+
+    int slot = -1;
+    for (int i = 0; i < port->slots; i++)
+    {
+        if (!port->requests[i].used)
+        {
+            slot = i;
+            break;
+        }
+    }
+
+    if (slot < 0)
+    {
+        return ERROR(-ENOMEM);
+    }
+
+    struct ahci_command_table *table = &port->tables[slot];
+    memset(table, 0, sizeof(struct ahci_command_table));
+
+    // The kernel maps every address to itself so our addresses are the ones the HBA needs
+    int prds = 0;
+    int sectors = 0;
+    for (int i = 0; i < total_segments; i++)
+    {
+        uint32_t address = (uint32_t)segments[i].buf;
+        uint32_t bytes = segments[i].sectors * COS32_SECTOR_SIZE;
+        if (address & 1)
+        {
+            return ERROR(-EINVARG);
+        }
+
+        sectors += segments[i].sectors;
+        while (bytes > 0)
+        {
+            if (prds == AHCI_MAX_PRDS)
+            {
+                return ERROR(-EINVARG);
+            }
+
+            uint32_t amount = bytes < AHCI_PRD_MAX_BYTES ? bytes : AHCI_PRD_MAX_BYTES;
+            table->prdt[prds].address = address;
+            table->prdt[prds].bytes = amount - 1;
+            prds++;
+            address += amount;
+            bytes -= amount;
+        }
+    }
+
+    struct ahci_fis_h2d *fis = (struct ahci_fis_h2d *)table->fis;
+    fis->type = AHCI_FIS_TYPE_H2D;
+    fis->flags = AHCI_FIS_H2D_COMMAND;
+    fis->command = command;
+    if (command != AHCI_ATA_COMMAND_IDENTIFY)
+    {
+        fis->device = AHCI_DEVICE_LBA;
+        fis->lba0 = lba & 0xFF;
+        fis->lba1 = (lba >> 8) & 0xFF;
+        fis->lba2 = (lba >> 16) & 0xFF;
+        fis->lba3 = (lba >> 24) & 0xFF;
+    }
+
+    if (queued)
+    {
+        // The count moves to the features and the tag takes its place
+        fis->feature_low = sectors & 0xFF;
+        fis->feature_high = (sectors >> 8) & 0xFF;
+        fis->count_low = slot << 3;
+    }
+    else if (command == AHCI_ATA_COMMAND_READ_DMA || command == AHCI_ATA_COMMAND_WRITE_DMA)
+    {
+        // Twenty eight bit addresses keep their top nibble in the device register, a count of zero means 256
+        fis->device |= (lba >> 24) & 0x0F;
+        fis->lba3 = 0;
+        fis->count_low = sectors & 0xFF;
+    }
+    else if (command == AHCI_ATA_COMMAND_READ_DMA_EXT || command == AHCI_ATA_COMMAND_WRITE_DMA_EXT)
+    {
+        fis->count_low = sectors & 0xFF;
+        fis->count_high = (sectors >> 8) & 0xFF;
+    }
+
+    struct ahci_command_header *header = &port->command_list[slot];
+    header->flags = (sizeof(struct ahci_fis_h2d) / sizeof(uint32_t)) & AHCI_COMMAND_FIS_LENGTH_MASK;
+    if (write)
+    {
+        header->flags |= AHCI_COMMAND_WRITE;
+    }
+    header->prdt_length = prds;
+    header->bytes_transferred = 0;
+    header->table = (uint32_t)table;
+    header->table_upper = 0;
+
+    struct ahci_request *request = &port->requests[slot];
+    request->used = true;
+    request->complete = false;
+    request->failed = false;
+    request->waiter = 0;
+    request->request = 0;
+    port->outstanding |= 1 << slot;
+
+    // Everything the HBA reads must be in memory before it is told about the command
+    __asm__ __volatile__("" ::: "memory");
+    if (queued)
+    {
+        port->registers->sata_active = 1 << slot;
+    }
+    port->registers->command_issue = 1 << slot;
+    return request;
+}
+
+static struct ahci_request *ahci_submit(struct ahci_port *port, bool write, unsigned int lba, struct disk_segment *segments, int total_segments)
+{
+    uint8_t command = write ? AHCI_ATA_COMMAND_WRITE_DMA : AHCI_ATA_COMMAND_READ_DMA;
+    if (port->ncq)
+    {
+        command = write ? AHCI_ATA_COMMAND_WRITE_FPDMA_QUEUED : AHCI_ATA_COMMAND_READ_FPDMA_QUEUED;
+    }
+    else if (port->lba48)
+    {
+        command = write ? AHCI_ATA_COMMAND_WRITE_DMA_EXT : AHCI_ATA_COMMAND_READ_DMA_EXT;
+    }
+
+    return ahci_issue(port, command, lba, segments, total_segments);
+}
+
+/**
+ * Waits for a request issued for ourselves rather than the disk's queue then frees its slot
+ */
+static int ahci_wait(struct ahci_port *port, struct ahci_request *request)
+{
+    disk_wait(&request->complete, &request->waiter, ahci_poll, port);
+    int res = request->failed ? -EIO : 0;
+    request->used = false;
+    return res;
+}
+
+static int ahci_submit_request(struct disk *disk, struct disk_request *request)
+{
+    struct ahci_port *port = disk->driver_private;
+    struct disk_segment segments[AHCI_MAX_PRDS];
+    int total = disk_request_segments(request, segments, AHCI_MAX_PRDS);
+    if (total < 0)
+    {
+        return total;
+    }
+
+    // With NCQ the drive may work on the commands in whatever order suits it. The port can't complete the command
+    // before we know which request it is, completions are handled with the kernel lock held
+    struct ahci_request *ahci_request = ahci_submit(port, request->write, request->lba, segments, total);
+    if (ISERR(ahci_request))
+    {
+        return ERROR_I(ahci_request);
+    }
+
+    ahci_request->request = request;
+    return 0;
+}
+
+/**
+ * Reads the drive's IDENTIFY data to learn its size and whether it can queue commands
+ */
+static int ahci_port_identify(struct ahci_port *port, int hba_slots)
+{
+    int res = 0;
+    uint16_t *identify = kzalloc(COS32_SECTOR_SIZE);
+    if (!identify)
+    {
+        res = -ENOMEM;
+        goto out;
+    }
+
+    struct disk_segment segment;
+    segment.buf = identify;
+    segment.sectors = 1;
+    struct ahci_request *request = ahci_issue(port, AHCI_ATA_COMMAND_IDENTIFY, 0, &segment, 1);
+    if (ISERR(request))
+    {
+        res = ERROR_I(request);
+        goto out;
+    }
+
+    res = ahci_wait(port, request);
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    port->lba48 = identify[AHCI_IDENTIFY_COMMAND_SETS] & AHCI_IDENTIFY_LBA48;
+    if (port->lba48)
+    {
+        port->total_sectors = identify[AHCI_IDENTIFY_SECTORS_LBA48];
+        port->total_sectors |= (uint64_t)identify[AHCI_IDENTIFY_SECTORS_LBA48 + 1] << 16;
+        port->total_sectors |= (uint64_t)identify[AHCI_IDENTIFY_SECTORS_LBA48 + 2] << 32;
+        port->total_sectors |= (uint64_t)identify[AHCI_IDENTIFY_SECTORS_LBA48 + 3] << 48;
+    }
+    else
+    {
+        port->total_sectors = identify[AHCI_IDENTIFY_SECTORS] | ((uint32_t)identify[AHCI_IDENTIFY_SECTORS + 1] << 16);
+    }
+
+    // Queued commands need both the HBA and the drive, the drive may queue fewer commands than the HBA has slots
+    port->slots = hba_slots;
+    port->ncq = (hba->capabilities & AHCI_CAP_NCQ) && (identify[AHCI_IDENTIFY_SATA_CAPABILITIES] & AHCI_IDENTIFY_NCQ);
+    if (port->ncq)
+    {
+        int depth = (identify[AHCI_IDENTIFY_QUEUE_DEPTH] & 0x1F) + 1;
+        if (depth < port->slots)
+        {
+            port->slots = depth;
+        }
+    }
+
+out:
+    kfree(identify);
+    return res;
+}
+
+static struct ahci_port *ahci_port_init(int number, int hba_slots)
+{
+    int res = 0;
+    struct ahci_port *port = 0;
+    volatile struct ahci_port_registers *registers = &hba->ports[number];
+
+    uint32_t sata_status = registers->sata_status;
+    if ((sata_status & AHCI_SSTS_DETECT_MASK) != AHCI_SSTS_DETECT_PRESENT ||
+        ((sata_status >> AHCI_SSTS_POWER_SHIFT) & AHCI_SSTS_POWER_MASK) != AHCI_SSTS_POWER_ACTIVE ||
+        registers->signature != AHCI_SIGNATURE_ATA)
+    {
+        res = -EIO;
+        goto out;
+    }
+
+    port = kzalloc(sizeof(struct ahci_port));
+    if (!port)
+    {
+        res = -ENOMEM;
+        goto out;
+    }
+
+    port->registers = registers;
+    port->hba = hba;
+    port->number = number;
+
+    // Kernel heap allocations start on a page which satisfies every alignment the HBA needs
+    port->command_list = kzalloc(COS32_PAGE_SIZE);
+    port->tables = kzalloc(sizeof(struct ahci_command_table) * AHCI_MAX_SLOTS);
+    if (!port->command_list || !port->tables)
+    {
+        res = -ENOMEM;
+        goto out;
+    }
+    port->received_fis = (char *)port->command_list + sizeof(struct ahci_command_header) * AHCI_MAX_SLOTS;
+
+    // The port must be idle before we move its command list
+    res = ahci_port_stop(port);
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    registers->command_list = (uint32_t)port->command_list;
+    registers->command_list_upper = 0;
+    registers->fis = (uint32_t)port->received_fis;
+    registers->fis_upper = 0;
+    ahci_port_start(port);
+    registers->interrupt_enable = AHCI_PORT_INTERRUPTS;
+
+    // Only the IDENTIFY command is issued until we know what the drive can do
+    port->slots = 1;
+    res = ahci_port_identify(port, hba_slots);
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    port->disk = disk_register(&ahci_driver, port);
+    if (!port->disk)
+    {
+        res = -ENOMEM;
+        goto out;
+    }
+    port->disk->queue.depth = port->slots;
+    port->disk->total_sectors = port->total_sectors > 0xFFFFFFFF ? 0xFFFFFFFF : port->total_sectors;
+
+out:
+    if (ISERR(res))
+    {
+        if (port)
+        {
+            registers->interrupt_enable = 0;
+            ahci_port_stop(port);
+            kfree(port->command_list);
+            kfree(port->tables);
+        }
+        kfree(port);
+        return ERROR(res);
+    }
+
+    return port;
+}
+
+void ahci_init()
+{
+    memset(ports, 0, sizeof(ports));
+
+    struct pci_device device;
+    if (pci_find_class(PCI_CLASS_MASS_STORAGE, PCI_SUBCLASS_SATA, &device) < 0 || device.prog_if != PCI_PROG_IF_AHCI)
+    {
+        return;
+    }
+
+    if (pci_bar_is_io(&device, AHCI_BAR_HBA) || !pci_bar(&device, AHCI_BAR_HBA))
+    {
+        return;
+    }
+
+    // Without the interrupt everyone polls the ports for their completions
+    bool polled = pci_register_interrupt(&device, ahci_interrupt, 0) < 0;
+
+    hba = (volatile struct ahci_hba_registers *)pci_bar(&device, AHCI_BAR_HBA);
+    pci_enable_bus_master(&device);
+    hba->global_control |= AHCI_GHC_AHCI_ENABLE;
+
+    int slots = ((hba->capabilities >> AHCI_CAP_SLOTS_SHIFT) & AHCI_CAP_SLOTS_MASK) + 1;
+    uint32_t implemented = hba->ports_implemented;
+    for (int i = 0; i < AHCI_MAX_PORTS; i++)
+    {
+        if (!(implemented & (1 << i)))
+        {
+            continue;
+        }
+
+        struct ahci_port *port = ahci_port_init(i, slots);
+        if (!ISERR(port))
+        {
+            port->disk->polled = polled;
+            ports[i] = port;
+        }
+    }
+
+    hba->interrupt_status = 0xFFFFFFFF;
+    if (!polled)
+    {
+        hba->global_control |= AHCI_GHC_INTERRUPT_ENABLE;
+    }
+}
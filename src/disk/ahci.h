@@ -0,0 +1,230 @@
+#ifndef DISK_AHCI_H
+#define DISK_AHCI_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// The HBA's registers are memory mapped by BAR5
+#define AHCI_BAR_HBA 5
+
+#define AHCI_MAX_PORTS 32
+#define AHCI_MAX_SLOTS 32
+
+// Host capabilities
+#define AHCI_CAP_SLOTS_SHIFT 8
+#define AHCI_CAP_SLOTS_MASK 0x1F
+#define AHCI_CAP_NCQ (1 << 30)
+
+// Global host control
+#define AHCI_GHC_INTERRUPT_ENABLE (1 << 1)
+#define AHCI_GHC_AHCI_ENABLE (1 << 31)
+
+// Port command and status
+#define AHCI_PORT_CMD_START 0x0001
+#define AHCI_PORT_CMD_FIS_RECEIVE 0x0010
+#define AHCI_PORT_CMD_FIS_RUNNING 0x4000
+#define AHCI_PORT_CMD_LIST_RUNNING 0x8000
+
+// Port interrupt status, the errors stop the port until it is restarted
+#define AHCI_PORT_IS_D2H_FIS 0x00000001
+#define AHCI_PORT_IS_PIO_SETUP_FIS 0x00000002
+#define AHCI_PORT_IS_SET_DEVICE_BITS_FIS 0x00000008
+#define AHCI_PORT_IS_DESCRIPTOR_PROCESSED 0x00000020
+#define AHCI_PORT_IS_ERROR 0x78000000
+#define AHCI_PORT_INTERRUPTS (AHCI_PORT_IS_D2H_FIS | AHCI_PORT_IS_PIO_SETUP_FIS | AHCI_PORT_IS_SET_DEVICE_BITS_FIS | AHCI_PORT_IS_DESCRIPTOR_PROCESSED | AHCI_PORT_IS_ERROR)
+
+// A drive is present and the link is up when the SATA status reads these
+#define AHCI_SSTS_DETECT_MASK 0x0F
+#define AHCI_SSTS_DETECT_PRESENT 0x03
+#define AHCI_SSTS_POWER_SHIFT 8
+#define AHCI_SSTS_POWER_MASK 0x0F
+#define AHCI_SSTS_POWER_ACTIVE 0x01
+
+// The signature of a port with an ATA drive rather than ATAPI or a port multiplier
+#define AHCI_SIGNATURE_ATA 0x00000101
+
+#define AHCI_TFD_BUSY 0x80
+#define AHCI_TFD_DRQ 0x08
+#define AHCI_TFD_ERROR 0x01
+
+#define AHCI_FIS_TYPE_H2D 0x27
+// Set in a host to device FIS carrying a command rather than a control update
+#define AHCI_FIS_H2D_COMMAND 0x80
+#define AHCI_DEVICE_LBA 0x40
+
+#define AHCI_ATA_COMMAND_READ_DMA 0xC8
+#define AHCI_ATA_COMMAND_READ_DMA_EXT 0x25
+#define AHCI_ATA_COMMAND_READ_FPDMA_QUEUED 0x60
+#define AHCI_ATA_COMMAND_WRITE_DMA 0xCA
+#define AHCI_ATA_COMMAND_WRITE_DMA_EXT 0x35
+#define AHCI_ATA_COMMAND_WRITE_FPDMA_QUEUED 0x61
+#define AHCI_ATA_COMMAND_IDENTIFY 0xEC
+
+// IDENTIFY data, in 16 bit words
+#define AHCI_IDENTIFY_QUEUE_DEPTH 75
+#define AHCI_IDENTIFY_SATA_CAPABILITIES 76
+#define AHCI_IDENTIFY_NCQ (1 << 8)
+#define AHCI_IDENTIFY_COMMAND_SETS 83
+#define AHCI_IDENTIFY_LBA48 (1 << 10)
+#define AHCI_IDENTIFY_SECTORS 60
+#define AHCI_IDENTIFY_SECTORS_LBA48 100
+
+// The most sectors in one command
+#define AHCI_REQUEST_SECTORS 128
+
+// Each command table holds this many PRDs, a PRD describes at most 4MB
+#define AHCI_MAX_PRDS 8
+#define AHCI_PRD_MAX_BYTES 0x400000
+
+// Command header flags, the length of the command FIS is in dwords
+#define AHCI_COMMAND_FIS_LENGTH_MASK 0x1F
+// Set when the HBA reads the PRDs' memory and sends it to the drive
+#define AHCI_COMMAND_WRITE 0x40
+
+// How long we spin waiting for the port during setup before we give up on it
+#define AHCI_SPIN_LIMIT 1000000
+
+// The registers of a port, the HBA has one set every 0x80 bytes from offset 0x100
+struct ahci_port_registers
+{
+    uint32_t command_list;
+    uint32_t command_list_upper;
+    uint32_t fis;
+    uint32_t fis_upper;
+    uint32_t interrupt_status;
+    uint32_t interrupt_enable;
+    uint32_t command;
+    uint32_t reserved0;
+    uint32_t task_file;
+    uint32_t signature;
+    uint32_t sata_status;
+    uint32_t sata_control;
+    uint32_t sata_error;
+    uint32_t sata_active;
+    uint32_t command_issue;
+    uint32_t sata_notification;
+    uint32_t fis_switching;
+    uint32_t reserved1[11];
+    uint32_t vendor[4];
+} __attribute__((packed));
+
+struct ahci_hba_registers
+{
+    uint32_t capabilities;
+    uint32_t global_control;
+    uint32_t interrupt_status;
+    uint32_t ports_implemented;
+    uint32_t version;
+    uint32_t reserved[59];
+    struct ahci_port_registers ports[AHCI_MAX_PORTS];
+} __attribute__((packed));
+
+struct ahci_command_header
+{
+    uint16_t flags;
+    uint16_t prdt_length;
+
+    // Written by the HBA as it transfers
+    uint32_t bytes_transferred;
+    uint32_t table;
+    uint32_t table_upper;
+    uint32_t reserved[4];
+} __attribute__((packed));
+
+// A physical region descriptor, one piece of the memory a command reads into
+struct ahci_prd
+{
+    uint32_t address;
+    uint32_t address_upper;
+    uint32_t reserved;
+
+    // The amount of bytes minus one
+    uint32_t bytes;
+} __attribute__((packed));
+
+struct ahci_fis_h2d
+{
+    uint8_t type;
+    uint8_t flags;
+    uint8_t command;
+    uint8_t feature_low;
+    uint8_t lba0;
+    uint8_t lba1;
+    uint8_t lba2;
+    uint8_t device;
+    uint8_t lba3;
+    uint8_t lba4;
+    uint8_t lba5;
+    uint8_t feature_high;
+    uint8_t count_low;
+    uint8_t count_high;
+    uint8_t icc;
+    uint8_t control;
+    uint8_t reserved[4];
+} __attribute__((packed));
+
+// Must be 128 byte aligned
+struct ahci_command_table
+{
+    uint8_t fis[64];
+    uint8_t atapi[16];
+    uint8_t reserved[48];
+    struct ahci_prd prdt[AHCI_MAX_PRDS];
+} __attribute__((packed));
+
+struct task;
+struct disk;
+struct disk_request;
+
+struct ahci_request
+{
+    bool used;
+
+    // The request of the disk's queue we are carrying out, NULL for commands we wait for ourselves
+    struct disk_request *request;
+
+    volatile bool complete;
+    bool failed;
+
+    // The kernel thread sleeping until the request completes, if any
+    struct task *waiter;
+};
+
+struct ahci_port
+{
+    struct disk *disk;
+    volatile struct ahci_port_registers *registers;
+    volatile struct ahci_hba_registers *hba;
+    int number;
+
+    // 32 command headers, must be 1KB aligned
+    struct ahci_command_header *command_list;
+
+    // Where the HBA writes the FISes the drive sends, must be 256 byte aligned
+    void *received_fis;
+
+    // A command table for every slot
+    struct ahci_command_table *tables;
+
+    // True if commands are queued with NCQ, otherwise the HBA runs them one after the other
+    bool ncq;
+    bool lba48;
+
+    // The slots we use, limited by the HBA and with NCQ by the drive's queue depth
+    int slots;
+
+    uint64_t total_sectors;
+
+    // Slots we have issued that have not completed
+    uint32_t outstanding;
+
+    // Indexed by slot, which is also the NCQ tag
+    struct ahci_request requests[AHCI_MAX_SLOTS];
+};
+
+/**
+ * Finds the AHCI controller on the PCI buses and registers a disk for every ATA drive connected to it
+ */
+void ahci_init();
+
+#endif
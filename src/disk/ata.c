@@ -0,0 +1,327 @@
+#include "ata.h"
+#include "disk.h"
+#include "idedma.h"
+#include "io/io.h"
+#include "memory/memory.h"
+#include "config.h"
+#include "status.h"
+
+static int ata_submit(struct disk *disk, struct disk_request *request);
+static int ata_flush(struct disk *disk);
+
+static struct disk_driver ata_driver = {
+    .submit = ata_submit,
+    .flush = ata_flush,
+    .max_sectors = DISK_MAX_SECTORS_PER_COMMAND,
+    .max_segments = DISK_ATA_MAX_SEGMENTS,
+    .queue_depth = 1,
+    .name = "ata"};
+
+static struct ata_drive drives[ATA_TOTAL_DRIVES];
+
+/**
+ * Selects the drive on its channel with the top bits of the LBA, a drive needs 400ns to respond to being selected
+ * which four reads of the status register take
+ */
+static void ata_select(struct ata_drive *drive, unsigned int lba)
+{
+    outb(drive->io_base + ATA_REGISTER_DRIVE, ATA_DRIVE_LBA | (drive->slave ? ATA_DRIVE_SLAVE : 0) | ((lba >> 24) & 0x0F));
+    for (int i = 0; i < 4; i++)
+    {
+        insb(drive->io_base + ATA_REGISTER_STATUS);
+    }
+}
+
+/**
+ * Returns true if the transfer needs an LBA48 command, the older commands take fewer port writes so they are used when they can be
+ */
+static bool ata_needs_lba48(struct ata_drive *drive, unsigned int lba, int total)
+{
+    return drive->lba48 && (total > DISK_MAX_SECTORS_PER_COMMAND || lba + total > ATA_LBA28_SECTORS);
+}
+
+/**
+ * Writes the address and count of an LBA48 command, each register holds two bytes which are written high byte first
+ */
+static void ata_select_lba48(struct ata_drive *drive, unsigned int lba, int total)
+{
+    outb(drive->io_base + ATA_REGISTER_DRIVE, ATA_DRIVE_LBA48 | (drive->slave ? ATA_DRIVE_SLAVE : 0));
+    for (int i = 0; i < 4; i++)
+    {
+        insb(drive->io_base + ATA_REGISTER_STATUS);
+    }
+
+    // A count of zero asks for 65536 sectors, our addresses have no bits above 32
+    outb(drive->io_base + ATA_REGISTER_SECTOR_COUNT, (unsigned char)(total >> 8));
+    outb(drive->io_base + ATA_REGISTER_LBA_LOW, (unsigned char)(lba >> 24));
+    outb(drive->io_base + ATA_REGISTER_LBA_MID, 0);
+    outb(drive->io_base + ATA_REGISTER_LBA_HIGH, 0);
+    outb(drive->io_base + ATA_REGISTER_SECTOR_COUNT, (unsigned char)total);
+    outb(drive->io_base + ATA_REGISTER_LBA_LOW, (unsigned char)(lba & 0xff));
+    outb(drive->io_base + ATA_REGISTER_LBA_MID, (unsigned char)(lba >> 8));
+    outb(drive->io_base + ATA_REGISTER_LBA_HIGH, (unsigned char)(lba >> 16));
+}
+
+/**
+ * Starts a PIO command on "total" sectors starting at "lba", the LBA48 form of the command is used if the transfer needs it
+ */
+static void ata_start(struct ata_drive *drive, unsigned int lba, int total, uint8_t command, uint8_t command_lba48)
+{
+    if (ata_needs_lba48(drive, lba, total))
+    {
+        ata_select_lba48(drive, lba, total);
+        outb(drive->io_base + ATA_REGISTER_COMMAND, command_lba48);
+        return;
+    }
+
+    ata_select(drive, lba);
+    // A count of zero asks for 256 sectors
+    outb(drive->io_base + ATA_REGISTER_SECTOR_COUNT, (unsigned char)total);
+    outb(drive->io_base + ATA_REGISTER_LBA_LOW, (unsigned char)(lba & 0xff));
+    outb(drive->io_base + ATA_REGISTER_LBA_MID, (unsigned char)(lba >> 8));
+    outb(drive->io_base + ATA_REGISTER_LBA_HIGH, (unsigned char)(lba >> 16));
+    outb(drive->io_base + ATA_REGISTER_COMMAND, command);
+}
+
+/**
+ * Waits until the drive is ready to move the next sector, returns an error if the command failed
+ */
+static int ata_wait_drq(struct ata_drive *drive)
+{
+    char c = insb(drive->io_base + ATA_REGISTER_STATUS);
+    while (!(c & DISK_ATA_STATUS_DRQ))
+    {
+        if (c & DISK_ATA_STATUS_ERR)
+        {
+            return -EIO;
+        }
+        c = insb(drive->io_base + ATA_REGISTER_STATUS);
+    }
+
+    return 0;
+}
+
+/**
+ * Waits until the drive has finished the command, returns an error if it failed
+ */
+static int ata_wait_idle(struct ata_drive *drive)
+{
+    uint8_t status = insb(drive->io_base + ATA_REGISTER_STATUS);
+    while (status & ATA_STATUS_BSY)
+    {
+        status = insb(drive->io_base + ATA_REGISTER_STATUS);
+    }
+
+    return status & DISK_ATA_STATUS_ERR ? -EIO : 0;
+}
+
+/**
+ * Reads the sectors with a single PIO command, up to ATA_LBA48_MAX_SECTORS on drives that take LBA48 commands
+ * and DISK_MAX_SECTORS_PER_COMMAND otherwise
+ */
+static int ata_read_sectors(struct ata_drive *drive, unsigned int lba, int total, void *buf)
+{
+    ata_start(drive, lba, total, ATA_COMMAND_READ_SECTORS, ATA_COMMAND_READ_SECTORS_EXT);
+
+    unsigned short *ptr = (unsigned short *)buf;
+    for (int b = 0; b < total; b++)
+    {
+        // Wait until buffer is ready
+        if (ata_wait_drq(drive) < 0)
+        {
+            return -EIO;
+        }
+
+        // Copy from hard disk to memory two bytes at a time
+        for (int i = 0; i < 256; i++)
+        {
+            *ptr = insw(drive->io_base + ATA_REGISTER_DATA);
+            ptr++;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Writes the sectors with a single PIO command, the limits are those of ata_read_sectors.
+ * Returns once the drive has taken every sector, it may still hold them in its cache
+ */
+static int ata_write_sectors(struct ata_drive *drive, unsigned int lba, int total, const void *buf)
+{
+    ata_start(drive, lba, total, ATA_COMMAND_WRITE_SECTORS, ATA_COMMAND_WRITE_SECTORS_EXT);
+
+    const unsigned short *ptr = (const unsigned short *)buf;
+    for (int b = 0; b < total; b++)
+    {
+        if (ata_wait_drq(drive) < 0)
+        {
+            return -EIO;
+        }
+
+        for (int i = 0; i < 256; i++)
+        {
+            outw(drive->io_base + ATA_REGISTER_DATA, *ptr);
+            ptr++;
+        }
+    }
+
+    return ata_wait_idle(drive);
+}
+
+static int ata_flush(struct disk *disk)
+{
+    struct ata_drive *drive = disk->driver_private;
+    if (!drive->flush_cache)
+    {
+        return 0;
+    }
+
+    ata_select(drive, 0);
+    outb(drive->io_base + ATA_REGISTER_COMMAND, drive->lba48 ? ATA_COMMAND_FLUSH_CACHE_EXT : ATA_COMMAND_FLUSH_CACHE);
+    return ata_wait_idle(drive);
+}
+
+/**
+ * Transfers with bus master DMA when the controller can, the CPU is left alone whilst the drive does the work.
+ * The channel can only do one thing at a time so the request is complete before we return
+ */
+static int ata_submit(struct disk *disk, struct disk_request *request)
+{
+    struct ata_drive *drive = disk->driver_private;
+    struct disk_segment segments[DISK_ATA_MAX_SEGMENTS];
+    int total = disk_request_segments(request, segments, DISK_ATA_MAX_SEGMENTS);
+    int res = total;
+    if (total < 0)
+    {
+        goto out;
+    }
+
+    res = -EINVARG;
+    if (idedma_ready(drive->channel))
+    {
+        res = idedma_transfer(drive->channel, drive->slave, ata_needs_lba48(drive, request->lba, request->sectors), request->write, request->lba, segments, total);
+    }
+
+    if (res == -EINVARG)
+    {
+        // Fall back to PIO, the CPU moves every word itself
+        res = 0;
+        unsigned int lba = request->lba;
+        for (int i = 0; i < total && res == 0; i++)
+        {
+            if (request->write)
+            {
+                res = ata_write_sectors(drive, lba, segments[i].sectors, segments[i].buf);
+            }
+            else
+            {
+                res = ata_read_sectors(drive, lba, segments[i].sectors, segments[i].buf);
+            }
+            lba += segments[i].sectors;
+        }
+    }
+
+out:
+    disk_request_complete(disk, request, res);
+    return 0;
+}
+
+/**
+ * Asks the drive to describe itself, returns an error if there is no ATA drive there. ATAPI drives answer
+ * with a signature in the LBA registers instead
+ */
+static int ata_identify(struct ata_drive *drive)
+{
+    uint16_t identify[ATA_IDENTIFY_WORDS];
+    ata_select(drive, 0);
+    outb(drive->io_base + ATA_REGISTER_SECTOR_COUNT, 0);
+    outb(drive->io_base + ATA_REGISTER_LBA_LOW, 0);
+    outb(drive->io_base + ATA_REGISTER_LBA_MID, 0);
+    outb(drive->io_base + ATA_REGISTER_LBA_HIGH, 0);
+    outb(drive->io_base + ATA_REGISTER_COMMAND, ATA_COMMAND_IDENTIFY);
+
+    // Nothing drives a bus without any drives on it so it floats high
+    uint8_t status = insb(drive->io_base + ATA_REGISTER_STATUS);
+    if (status == 0 || status == 0xFF)
+    {
+        return -EIO;
+    }
+
+    int spins = 0;
+    while (status & ATA_STATUS_BSY)
+    {
+        if (++spins == ATA_SPIN_LIMIT)
+        {
+            return -EIO;
+        }
+        status = insb(drive->io_base + ATA_REGISTER_STATUS);
+    }
+
+    if (insb(drive->io_base + ATA_REGISTER_LBA_MID) || insb(drive->io_base + ATA_REGISTER_LBA_HIGH))
+    {
+        return -EIO;
+    }
+
+    while (!(status & (DISK_ATA_STATUS_DRQ | DISK_ATA_STATUS_ERR)))
+    {
+        if (++spins == ATA_SPIN_LIMIT)
+        {
+            return -EIO;
+        }
+        status = insb(drive->io_base + ATA_REGISTER_STATUS);
+    }
+
+    if (status & DISK_ATA_STATUS_ERR)
+    {
+        return -EIO;
+    }
+
+    for (int i = 0; i < ATA_IDENTIFY_WORDS; i++)
+    {
+        identify[i] = insw(drive->io_base + ATA_REGISTER_DATA);
+    }
+
+    drive->lba48 = identify[ATA_IDENTIFY_COMMAND_SETS] & ATA_IDENTIFY_LBA48;
+    drive->flush_cache = identify[ATA_IDENTIFY_COMMAND_SETS] & ATA_IDENTIFY_FLUSH_CACHE;
+    drive->total_sectors = identify[ATA_IDENTIFY_SECTORS] | ((uint32_t)identify[ATA_IDENTIFY_SECTORS + 1] << 16);
+    if (drive->lba48)
+    {
+        drive->total_sectors = identify[ATA_IDENTIFY_SECTORS_LBA48] | ((uint32_t)identify[ATA_IDENTIFY_SECTORS_LBA48 + 1] << 16);
+        if (identify[ATA_IDENTIFY_SECTORS_LBA48 + 2] || identify[ATA_IDENTIFY_SECTORS_LBA48 + 3])
+        {
+            drive->total_sectors = 0xFFFFFFFF;
+        }
+    }
+    return 0;
+}
+
+void ata_init()
+{
+    memset(drives, 0, sizeof(drives));
+    for (int i = 0; i < ATA_TOTAL_DRIVES; i++)
+    {
+        struct ata_drive *drive = &drives[i];
+        drive->channel = i / 2 ? IDEDMA_CHANNEL_SECONDARY : IDEDMA_CHANNEL_PRIMARY;
+        drive->io_base = drive->channel == IDEDMA_CHANNEL_PRIMARY ? IDEDMA_PRIMARY_IO_BASE : IDEDMA_SECONDARY_IO_BASE;
+        drive->slave = i % 2;
+
+        // The kernel was loaded from the primary master so it is there even if it won't identify itself
+        if (ata_identify(drive) < 0 && i != 0)
+        {
+            continue;
+        }
+
+        struct disk *disk = disk_register(&ata_driver, drive);
+        if (!disk)
+        {
+            break;
+        }
+        disk->total_sectors = drive->total_sectors;
+        if (drive->lba48)
+        {
+            // Fewer, larger transfers
+            disk->queue.max_sectors = ATA_LBA48_MAX_SECTORS;
+        }
+    }
+}
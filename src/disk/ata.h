@@ -0,0 +1,77 @@
+#ifndef DISK_ATA_H
+#define DISK_ATA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// A master and a slave on each of the primary and secondary channels
+#define ATA_TOTAL_DRIVES 4
+
+// Task file registers relative to the channel's I/O base
+#define ATA_REGISTER_DATA 0x00
+#define ATA_REGISTER_SECTOR_COUNT 0x02
+#define ATA_REGISTER_LBA_LOW 0x03
+#define ATA_REGISTER_LBA_MID 0x04
+#define ATA_REGISTER_LBA_HIGH 0x05
+#define ATA_REGISTER_DRIVE 0x06
+#define ATA_REGISTER_COMMAND 0x07
+#define ATA_REGISTER_STATUS 0x07
+
+// Selects LBA addressing, the slave bit picks the second drive of the channel.
+// Twenty eight bit addresses keep their top nibble in the drive register too
+#define ATA_DRIVE_LBA 0xE0
+#define ATA_DRIVE_LBA48 0x40
+#define ATA_DRIVE_SLAVE 0x10
+
+#define ATA_STATUS_BSY 0x80
+
+#define ATA_COMMAND_READ_SECTORS 0x20
+#define ATA_COMMAND_READ_SECTORS_EXT 0x24
+#define ATA_COMMAND_WRITE_SECTORS 0x30
+#define ATA_COMMAND_WRITE_SECTORS_EXT 0x34
+#define ATA_COMMAND_FLUSH_CACHE 0xE7
+#define ATA_COMMAND_FLUSH_CACHE_EXT 0xEA
+#define ATA_COMMAND_IDENTIFY 0xEC
+
+// IDENTIFY data, in 16 bit words
+#define ATA_IDENTIFY_WORDS 256
+#define ATA_IDENTIFY_SECTORS 60
+#define ATA_IDENTIFY_COMMAND_SETS 83
+#define ATA_IDENTIFY_LBA48 (1 << 10)
+#define ATA_IDENTIFY_FLUSH_CACHE (1 << 12)
+#define ATA_IDENTIFY_SECTORS_LBA48 100
+
+// The first sector twenty eight bit commands can't reach, 128GB in
+#define ATA_LBA28_SECTORS 0x10000000
+
+// The most sectors one LBA48 command may transfer is 65536 but a DMA transfer that size may need
+// more PRDs than a page holds, so we ask for half as many
+#define ATA_LBA48_MAX_SECTORS 32768
+
+// How long we spin waiting for a drive that may not be there before we give up on it
+#define ATA_SPIN_LIMIT 1000000
+
+struct ata_drive
+{
+    // IDEDMA_CHANNEL_PRIMARY or IDEDMA_CHANNEL_SECONDARY
+    int channel;
+    uint16_t io_base;
+    bool slave;
+
+    // True if the drive takes the LBA48 commands with their 48 bit addresses and 16 bit counts
+    bool lba48;
+
+    // True if the drive can be asked to write its cache to the media
+    bool flush_cache;
+
+    // Zero if the drive didn't tell us, drives beyond 2TB are cut short as our sectors are numbered with 32 bits
+    unsigned int total_sectors;
+};
+
+/**
+ * Registers a disk for every ATA drive on the legacy ports, drives are found with the IDENTIFY command.
+ * The primary master is always registered as the kernel was loaded from it
+ */
+void ata_init();
+
+#endif
@@ -0,0 +1,378 @@
+#include "bio.h"
+#include "disk.h"
+#include "task/task.h"
+#include "memory/memory.h"
+#include "kernel.h"
+#include "status.h"
+
+// Every caller holds the kernel lock so the queues need no lock of their own
+
+void disk_queue_init(struct disk *disk)
+{
+    struct disk_queue *queue = &disk->queue;
+    memset(queue, 0, sizeof(struct disk_queue));
+    queue->depth = disk->driver->queue_depth;
+    queue->max_sectors = disk->driver->max_sectors;
+    queue->max_segments = disk->driver->max_segments;
+    if (queue->depth < 1 || queue->depth > COS32_DISK_QUEUE_MAX_REQUESTS)
+    {
+        queue->depth = COS32_DISK_QUEUE_MAX_REQUESTS;
+    }
+}
+
+static void disk_queue_poll(void *private)
+{
+    struct disk *disk = private;
+    if (disk->driver->poll)
+    {
+        disk->driver->poll(disk->driver_private);
+    }
+}
+
+/**
+ * Takes the pending request the elevator serves next, the first at or above where the last one ended
+ * or the lowest if there is none so that requests below us aren't starved
+ */
+static struct disk_request *disk_queue_next(struct disk_queue *queue)
+{
+    struct disk_request **link = &queue->pending;
+    while (*link && (*link)->lba < queue->position)
+    {
+        link = &(*link)->next;
+    }
+
+    if (!*link)
+    {
+        link = &queue->pending;
+    }
+
+    struct disk_request *request = *link;
+    *link = request->next;
+    request->next = 0;
+    queue->total_pending--;
+    return request;
+}
+
+static void disk_queue_insert(struct disk_queue *queue, struct disk_request *request)
+{
+    struct disk_request **link = &queue->pending;
+    while (*link && (*link)->lba < request->lba)
+    {
+        link = &(*link)->next;
+    }
+
+    request->next = *link;
+    *link = request;
+    queue->total_pending++;
+}
+
+/**
+ * Gives the driver as many pending requests as it will take
+ */
+static void disk_queue_run(struct disk *disk)
+{
+    struct disk_queue *queue = &disk->queue;
+    if (queue->dispatching)
+    {
+        return;
+    }
+
+    int submitted = 0;
+    queue->dispatching = true;
+    while (queue->pending && queue->in_flight < queue->depth)
+    {
+        struct disk_request *request = disk_queue_next(queue);
+        request->dispatched = true;
+        queue->in_flight++;
+        if ((uint32_t)queue->in_flight > queue->statistics.max_in_flight)
+        {
+            queue->statistics.max_in_flight = queue->in_flight;
+        }
+
+        int res = disk->driver->submit(disk, request);
+        if (res == -ENOMEM)
+        {
+            // The driver is full, a request completing will run the queue again and the elevator picks this one first
+            request->dispatched = false;
+            queue->in_flight--;
+            queue->statistics.busy++;
+            disk_queue_insert(queue, request);
+            break;
+        }
+
+        queue->position = request->lba + request->sectors;
+        queue->statistics.requests++;
+        queue->statistics.sectors += request->sectors;
+        if (request->write)
+        {
+            queue->statistics.writes++;
+        }
+        if (res < 0)
+        {
+            disk_request_complete(disk, request, res);
+            continue;
+        }
+
+        submitted++;
+    }
+    queue->dispatching = false;
+
+    if (submitted && disk->driver->commit)
+    {
+        disk->driver->commit(disk);
+    }
+}
+
+/**
+ * Adds the bio to a pending request for the sectors either side of it, returns false if there is none it fits
+ */
+static bool disk_queue_merge(struct disk_queue *queue, struct bio *bio)
+{
+    for (struct disk_request *request = queue->pending; request; request = request->next)
+    {
+        if (request->write != bio->write || request->sectors + bio->sectors > queue->max_sectors || request->segments == queue->max_segments)
+        {
+            continue;
+        }
+
+        if (request->lba + request->sectors == bio->lba)
+        {
+            request->last->next = bio;
+            request->last = bio;
+        }
+        else if (bio->lba + bio->sectors == request->lba)
+        {
+            // The request keeps its place in the list, nothing pending can lie between the bio and the request
+            bio->next = request->first;
+            request->first = bio;
+            request->lba = bio->lba;
+        }
+        else
+        {
+            continue;
+        }
+
+        request->sectors += bio->sectors;
+        request->segments++;
+        queue->statistics.merges++;
+        return true;
+    }
+
+    return false;
+}
+
+static struct disk_request *disk_queue_alloc_request(struct disk_queue *queue)
+{
+    for (int i = 0; i < COS32_DISK_QUEUE_MAX_REQUESTS; i++)
+    {
+        if (!queue->requests[i].used)
+        {
+            return &queue->requests[i];
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Returns a request nobody is using, waiting for one in flight to complete if there are none
+ */
+static struct disk_request *disk_queue_get_request(struct disk *disk)
+{
+    struct disk_queue *queue = &disk->queue;
+    struct disk_request *request = disk_queue_alloc_request(queue);
+    while (!request)
+    {
+        disk_queue_run(disk);
+        for (int i = 0; i < COS32_DISK_QUEUE_MAX_REQUESTS; i++)
+        {
+            if (queue->requests[i].dispatched)
+            {
+                bio_wait(queue->requests[i].last);
+                break;
+            }
+        }
+        request = disk_queue_alloc_request(queue);
+    }
+
+    return request;
+}
+
+int bio_submit(struct bio *bio)
+{
+    struct disk *disk = bio->disk;
+    if (bio->sectors <= 0 || bio->sectors > disk->queue.max_sectors)
+    {
+        return -EINVARG;
+    }
+
+    if (disk->parent)
+    {
+        // Partitions are read through the queue of the drive they are on
+        if (bio->lba + bio->sectors > disk->total_sectors)
+        {
+            return -EIO;
+        }
+
+        bio->lba += disk->offset;
+        bio->disk = disk->parent;
+        disk = disk->parent;
+    }
+
+    struct disk_queue *queue = &disk->queue;
+
+    bio->status = 0;
+    bio->complete = false;
+    bio->waiter = 0;
+    bio->next = 0;
+    queue->statistics.bios++;
+
+    if (!disk_queue_merge(queue, bio))
+    {
+        struct disk_request *request = disk_queue_get_request(disk);
+        request->used = true;
+        request->dispatched = false;
+        request->write = bio->write;
+        request->lba = bio->lba;
+        request->sectors = bio->sectors;
+        request->segments = 1;
+        request->first = bio;
+        request->last = bio;
+        request->next = 0;
+
+        disk_queue_insert(queue, request);
+        if ((uint32_t)queue->total_pending > queue->statistics.max_pending)
+        {
+            queue->statistics.max_pending = queue->total_pending;
+        }
+    }
+
+    if (!queue->plugged)
+    {
+        disk_queue_run(disk);
+    }
+
+    return 0;
+}
+
+int bio_wait(struct bio *bio)
+{
+    struct disk *disk = bio->disk;
+    if (!bio->complete)
+    {
+        // Completions only give the driver more requests once the queue is unplugged
+        disk->queue.plugged = 0;
+        disk_queue_run(disk);
+    }
+
+    if (bio->waiter)
+    {
+        // Only one kernel thread can sleep on a bio, anyone else polls until it completes
+        disk_poll(&bio->complete, disk_queue_poll, disk);
+    }
+    else
+    {
+        disk_wait(&bio->complete, disk->polled ? 0 : &bio->waiter, disk_queue_poll, disk);
+    }
+
+    return bio->status;
+}
+
+void disk_plug(struct disk *disk)
+{
+    if (disk->parent)
+    {
+        disk = disk->parent;
+    }
+
+    disk->queue.plugged++;
+}
+
+void disk_unplug(struct disk *disk)
+{
+    if (disk->parent)
+    {
+        disk = disk->parent;
+    }
+
+    // Someone may have waited for a bio since we plugged the queue
+    if (disk->queue.plugged > 0)
+    {
+        disk->queue.plugged--;
+    }
+
+    if (!disk->queue.plugged)
+    {
+        disk_queue_run(disk);
+    }
+}
+
+int disk_request_segments(struct disk_request *request, struct disk_segment *segments, int max)
+{
+    int total = 0;
+    for (struct bio *bio = request->first; bio; bio = bio->next)
+    {
+        if (total == max)
+        {
+            return -EINVARG;
+        }
+
+        segments[total].buf = bio->buf;
+        segments[total].sectors = bio->sectors;
+        total++;
+    }
+
+    return total;
+}
+
+void disk_request_complete(struct disk *disk, struct disk_request *request, int status)
+{
+    struct disk_queue *queue = &disk->queue;
+    if (status < 0)
+    {
+        queue->statistics.errors++;
+    }
+
+    struct bio *bio = request->first;
+    while (bio)
+    {
+        // The bio may be reused by its end function
+        struct bio *next = bio->next;
+        bio->status = status;
+        bio->complete = true;
+        if (bio->waiter)
+        {
+            task_wake(bio->waiter);
+            bio->waiter = 0;
+        }
+
+        if (bio->end)
+        {
+            bio->end(bio);
+        }
+        bio = next;
+    }
+
+    if (request->dispatched)
+    {
+        queue->in_flight--;
+    }
+    request->used = false;
+    request->dispatched = false;
+
+    if (!queue->plugged)
+    {
+        disk_queue_run(disk);
+    }
+}
+
+void disk_queue_get_statistics(struct disk *disk, struct disk_queue_statistics *out)
+{
+    if (disk->parent)
+    {
+        disk = disk->parent;
+    }
+
+    memcpy(out, &disk->queue.statistics, sizeof(struct disk_queue_statistics));
+    out->depth = disk->queue.depth;
+}
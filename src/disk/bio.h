@@ -0,0 +1,162 @@
+#ifndef DISK_BIO_H
+#define DISK_BIO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+
+struct disk;
+struct bio;
+struct task;
+struct disk_segment;
+
+/**
+ * Called once the bio has completed with the kernel lock held, often from an interrupt handler so it must not wait.
+ * The bio belongs to its owner again once this returns
+ */
+typedef void (*BIO_END_FUNCTION)(struct bio *bio);
+
+// A read or write of consecutive sectors to or from one piece of memory, owned by whoever submits it until it completes
+struct bio
+{
+    // A bio for a partition is moved to the drive it is on when it's submitted
+    struct disk *disk;
+    unsigned int lba;
+    int sectors;
+    void *buf;
+
+    // True if "buf" is written to the disk rather than read into
+    bool write;
+
+    // May be NULL if the owner will wait for the bio instead
+    BIO_END_FUNCTION end;
+    void *private;
+
+    // Zero if the transfer succeeded, set before "complete"
+    int status;
+    volatile bool complete;
+
+    // The kernel thread sleeping until the bio completes, if any
+    struct task *waiter;
+
+    // The next bio of the same request
+    struct bio *next;
+};
+
+// Bios for consecutive sectors merged into a single transfer, each bio is one segment of the transfer.
+// Reads are only merged with reads and writes with writes
+struct disk_request
+{
+    bool used;
+
+    // True once the request has been given to the driver
+    bool dispatched;
+
+    bool write;
+
+    unsigned int lba;
+    int sectors;
+    int segments;
+    struct bio *first;
+    struct bio *last;
+
+    // The next pending request, pending requests are kept in order of their LBA
+    struct disk_request *next;
+};
+
+// The layout is shared with user space
+struct disk_queue_statistics
+{
+    // Bios submitted and how many of them were merged into a request that was already pending
+    uint32_t bios;
+    uint32_t merges;
+
+    // Requests given to the driver and how many of those failed
+    uint32_t requests;
+    uint32_t errors;
+    uint32_t sectors;
+
+    // Times the driver had no room for another request
+    uint32_t busy;
+
+    // The most requests we have had waiting and in flight at once
+    uint32_t max_pending;
+    uint32_t max_in_flight;
+
+    uint32_t depth;
+
+    // Requests that wrote to the disk, they are counted in "requests" too
+    uint32_t writes;
+};
+
+struct disk_queue
+{
+    struct disk_request requests[COS32_DISK_QUEUE_MAX_REQUESTS];
+    struct disk_request *pending;
+    int total_pending;
+    int in_flight;
+
+    // The most requests the driver is given at once
+    int depth;
+
+    // The limits of a single request
+    int max_sectors;
+    int max_segments;
+
+    // Requests wait in the queue to be merged until it is unplugged as often as it was plugged
+    int plugged;
+
+    // True whilst we are giving requests to the driver, drivers may complete them before they return
+    bool dispatching;
+
+    // Where the last dispatched request ended, the elevator carries on upwards from here before it wraps around
+    unsigned int position;
+
+    struct disk_queue_statistics statistics;
+};
+
+/**
+ * Prepares the queue of a disk with the limits of its driver, drivers may lower the limits once the disk is registered
+ */
+void disk_queue_init(struct disk *disk);
+
+/**
+ * Queues a bio, merging it with a pending request in the same direction for the sectors either side of it if there is one.
+ * Bios for a partition are queued on the drive it is on.
+ * The bio is given to the driver at once unless the queue is plugged or the driver already has as many requests as it can take.
+ * Returns an error if the bio is larger than a request may be
+ */
+int bio_submit(struct bio *bio);
+
+/**
+ * Waits for the bio to complete, its queue is unplugged however often it was plugged so the bio can't wait there forever.
+ * Returns the bio's status
+ */
+int bio_wait(struct bio *bio);
+
+/**
+ * Holds back the requests of the disk so that bios submitted after this can be merged, see disk_unplug. Plugs nest
+ */
+void disk_plug(struct disk *disk);
+
+/**
+ * Gives the driver the requests held back since disk_plug
+ */
+void disk_unplug(struct disk *disk);
+
+/**
+ * Fills "segments" with the memory of each bio of the request, returns how many there are or an error if there are more than "max"
+ */
+int disk_request_segments(struct disk_request *request, struct disk_segment *segments, int max);
+
+/**
+ * Called by drivers when a request they were given has completed, completes every bio of the request
+ */
+void disk_request_complete(struct disk *disk, struct disk_request *request, int status);
+
+/**
+ * Copies the counters of the disk's queue, a partition shares the queue of the drive it is on
+ */
+void disk_queue_get_statistics(struct disk *disk, struct disk_queue_statistics *statistics);
+
+#endif
@@ -0,0 +1,700 @@
+#include "cache.h"
+#include "disk.h"
+#include "memory/memory.h"
+#include "memory/kheap.h"
+#include "task/kthread.h"
+#include "smp/smp.h"
+#include "idt/idt.h"
+#include "kernel.h"
+#include "status.h"
+
+// Every caller holds the kernel lock so the cache needs no lock of its own
+static struct disk_cache_block blocks[COS32_DISK_CACHE_BLOCKS];
+static struct disk_cache_block *hash[COS32_DISK_CACHE_HASH_BUCKETS];
+
+// The least recently used block is at the head, the most recently used at the tail
+static struct disk_cache_block *lru_head = 0;
+static struct disk_cache_block *lru_tail = 0;
+
+static struct disk_cache_statistics statistics;
+
+static void disk_cache_lru_remove(struct disk_cache_block *block)
+{
+    if (block->lru_prev)
+    {
+        block->lru_prev->lru_next = block->lru_next;
+    }
+
+    if (block->lru_next)
+    {
+        block->lru_next->lru_prev = block->lru_prev;
+    }
+
+    if (block == lru_head)
+    {
+        lru_head = block->lru_next;
+    }
+
+    if (block == lru_tail)
+    {
+        lru_tail = block->lru_prev;
+    }
+
+    block->lru_next = 0;
+    block->lru_prev = 0;
+}
+
+static void disk_cache_lru_append(struct disk_cache_block *block)
+{
+    block->lru_prev = lru_tail;
+    if (lru_tail)
+    {
+        lru_tail->lru_next = block;
+    }
+    lru_tail = block;
+
+    if (!lru_head)
+    {
+        lru_head = block;
+    }
+}
+
+static void disk_cache_touch(struct disk_cache_block *block)
+{
+    disk_cache_lru_remove(block);
+    disk_cache_lru_append(block);
+}
+
+/**
+ * Partitions are cached as sectors of the drive they are on so each sector has one block however it is reached.
+ * Moves "disk" and "lba" to the drive, returns an error if the sectors run past the end of the partition
+ */
+static int disk_cache_resolve(struct disk **disk, unsigned int *lba, int total)
+{
+    struct disk *partition = *disk;
+    if (!partition->parent)
+    {
+        return 0;
+    }
+
+    if (*lba + total < *lba || *lba + total > partition->total_sectors)
+    {
+        return -EIO;
+    }
+
+    *lba += partition->offset;
+    *disk = partition->parent;
+    return 0;
+}
+
+static int disk_cache_hash_index(struct disk *disk, unsigned int block)
+{
+    return ((unsigned int)disk->id * 31 + block) % COS32_DISK_CACHE_HASH_BUCKETS;
+}
+
+static struct disk_cache_block *disk_cache_find(struct disk *disk, unsigned int block)
+{
+    struct disk_cache_block *current = hash[disk_cache_hash_index(disk, block)];
+    while (current)
+    {
+        if (current->disk == disk && current->block == block)
+        {
+            return current;
+        }
+        current = current->hash_next;
+    }
+
+    return 0;
+}
+
+/**
+ * Finds a cached block for someone who wants its data, counting the hit if the block was read ahead
+ */
+static struct disk_cache_block *disk_cache_find_for_use(struct disk *disk, unsigned int block)
+{
+    struct disk_cache_block *cached = disk_cache_find(disk, block);
+    if (cached && cached->readahead)
+    {
+        cached->readahead = false;
+        statistics.readahead_hits++;
+    }
+
+    return cached;
+}
+
+static void disk_cache_hash_remove(struct disk_cache_block *block)
+{
+    struct disk_cache_block **link = &hash[disk_cache_hash_index(block->disk, block->block)];
+    while (*link && *link != block)
+    {
+        link = &(*link)->hash_next;
+    }
+
+    if (*link)
+    {
+        *link = block->hash_next;
+    }
+    block->hash_next = 0;
+}
+
+/**
+ * Takes the least recently used block nobody is using for the given block of the disk, changed blocks must be
+ * written back first. Returns NULL if every block is in use or changed
+ */
+static struct disk_cache_block *disk_cache_claim(struct disk *disk, unsigned int block)
+{
+    struct disk_cache_block *current = lru_head;
+    while (current && (current->refcount || current->dirty))
+    {
+        current = current->lru_next;
+    }
+
+    if (!current)
+    {
+        return 0;
+    }
+
+    if (current->valid)
+    {
+        disk_cache_hash_remove(current);
+        current->valid = false;
+        statistics.evictions++;
+        statistics.used_blocks--;
+        if (current->readahead)
+        {
+            statistics.readahead_wasted++;
+        }
+    }
+
+    current->readahead = false;
+
+    current->disk = disk;
+    current->block = block;
+    disk_cache_touch(current);
+    return current;
+}
+
+static void disk_cache_hash_add(struct disk_cache_block *block)
+{
+    int index = disk_cache_hash_index(block->disk, block->block);
+    block->hash_next = hash[index];
+    hash[index] = block;
+}
+
+static void disk_cache_read_end(struct bio *bio)
+{
+    struct disk_cache_block *block = bio->private;
+    block->reading = false;
+    if (bio->status < 0)
+    {
+        // Whoever is waiting for the block sees it isn't valid, nobody else will find it
+        disk_cache_hash_remove(block);
+    }
+    else
+    {
+        block->valid = true;
+        statistics.used_blocks++;
+    }
+
+    // The reference held by the read
+    block->refcount--;
+}
+
+/**
+ * Claims a block for the given block of the disk and starts reading it. The block can be found at once so it
+ * isn't read twice, the read holds a reference until it completes. Returns an error if every block is in use
+ */
+static struct disk_cache_block *disk_cache_start_read(struct disk *disk, unsigned int block)
+{
+    struct disk_cache_block *cached = disk_cache_claim(disk, block);
+    if (!cached)
+    {
+        return ERROR(-ENOMEM);
+    }
+
+    disk_cache_hash_add(cached);
+    cached->reading = true;
+    cached->refcount++;
+
+    memset(&cached->bio, 0, sizeof(struct bio));
+    cached->bio.disk = disk;
+    cached->bio.lba = block * DISK_CACHE_BLOCK_SECTORS;
+    cached->bio.sectors = DISK_CACHE_BLOCK_SECTORS;
+    cached->bio.buf = cached->data;
+    cached->bio.end = disk_cache_read_end;
+    cached->bio.private = cached;
+    int res = bio_submit(&cached->bio);
+    if (res < 0)
+    {
+        disk_cache_hash_remove(cached);
+        cached->reading = false;
+        cached->refcount--;
+        return ERROR(res);
+    }
+
+    return cached;
+}
+
+static void disk_cache_mark_dirty(struct disk_cache_block *block)
+{
+    if (!block->dirty)
+    {
+        block->dirty = true;
+        statistics.dirty_blocks++;
+    }
+}
+
+static void disk_cache_write_end(struct bio *bio)
+{
+    struct disk_cache_block *block = bio->private;
+    block->writing = false;
+    if (bio->status < 0)
+    {
+        // The data is kept, the next write back tries again
+        statistics.write_errors++;
+        disk_cache_mark_dirty(block);
+    }
+
+    // The reference held by the write
+    block->refcount--;
+}
+
+/**
+ * Starts writing a changed block back to its disk, the write holds a reference until it completes
+ */
+static int disk_cache_start_write(struct disk_cache_block *block)
+{
+    // Changes made from now on need writing again
+    block->dirty = false;
+    statistics.dirty_blocks--;
+    block->writing = true;
+    block->refcount++;
+
+    memset(&block->bio, 0, sizeof(struct bio));
+    block->bio.disk = block->disk;
+    block->bio.lba = block->block * DISK_CACHE_BLOCK_SECTORS;
+    block->bio.sectors = DISK_CACHE_BLOCK_SECTORS;
+    block->bio.buf = block->data;
+    block->bio.write = true;
+    block->bio.end = disk_cache_write_end;
+    block->bio.private = block;
+    int res = bio_submit(&block->bio);
+    if (res < 0)
+    {
+        block->writing = false;
+        block->refcount--;
+        disk_cache_mark_dirty(block);
+        return res;
+    }
+
+    statistics.writebacks++;
+    return 0;
+}
+
+/**
+ * Waits for the read of a block we hold a reference to, returns an error if the read failed
+ */
+static int disk_cache_wait(struct disk_cache_block *block)
+{
+    if (block->reading)
+    {
+        bio_wait(&block->bio);
+    }
+
+    return block->valid ? 0 : -EIO;
+}
+
+void disk_cache_init()
+{
+    memset(blocks, 0, sizeof(blocks));
+    memset(hash, 0, sizeof(hash));
+    memset(&statistics, 0, sizeof(statistics));
+    lru_head = 0;
+    lru_tail = 0;
+
+    for (int i = 0; i < COS32_DISK_CACHE_BLOCKS; i++)
+    {
+        blocks[i].data = kzalloc(COS32_DISK_CACHE_BLOCK_SIZE);
+        if (!blocks[i].data)
+        {
+            panic("Out of memory for the disk cache\n");
+        }
+        disk_cache_lru_append(&blocks[i]);
+    }
+
+    statistics.block_size = COS32_DISK_CACHE_BLOCK_SIZE;
+    statistics.total_blocks = COS32_DISK_CACHE_BLOCKS;
+}
+
+/**
+ * Returns the block with its reference count raised, its data may still be being read
+ */
+static struct disk_cache_block *disk_cache_get_async(struct disk *disk, unsigned int block)
+{
+    struct disk_cache_block *cached = disk_cache_find_for_use(disk, block);
+    if (cached)
+    {
+        statistics.hits++;
+        disk_cache_touch(cached);
+    }
+    else
+    {
+        statistics.misses++;
+        cached = disk_cache_start_read(disk, block);
+        if (ISERR(cached))
+        {
+            return cached;
+        }
+    }
+
+    cached->refcount++;
+    return cached;
+}
+
+struct disk_cache_block *disk_cache_get(struct disk *disk, unsigned int block)
+{
+    struct disk_cache_block *cached = disk_cache_get_async(disk, block);
+    if (ISERR(cached))
+    {
+        return cached;
+    }
+
+    int res = disk_cache_wait(cached);
+    if (res < 0)
+    {
+        disk_cache_put(cached);
+        return ERROR(res);
+    }
+
+    return cached;
+}
+
+void disk_cache_put(struct disk_cache_block *block)
+{
+    ASSERT(block->refcount > 0);
+    block->refcount--;
+}
+
+int disk_cache_read(struct disk *disk, unsigned int lba, int total, void *buf)
+{
+    int res = disk_cache_resolve(&disk, &lba, total);
+    char *out = buf;
+    struct disk_cache_block *batch[DISK_CACHE_READ_BATCH_BLOCKS];
+    while (total > 0 && res == 0)
+    {
+        // Every missing block of the batch is asked for before we wait for any of them so the reads can be merged
+        unsigned int first = lba / DISK_CACHE_BLOCK_SECTORS;
+        unsigned int last = (lba + total - 1) / DISK_CACHE_BLOCK_SECTORS;
+        int count = last - first + 1;
+        if (count > DISK_CACHE_READ_BATCH_BLOCKS)
+        {
+            count = DISK_CACHE_READ_BATCH_BLOCKS;
+        }
+
+        disk_plug(disk);
+        for (int i = 0; i < count; i++)
+        {
+            batch[i] = disk_cache_get_async(disk, first + i);
+        }
+        disk_unplug(disk);
+
+        // Every reference is dropped even after a failure
+        for (int i = 0; i < count; i++)
+        {
+            struct disk_cache_block *cached = batch[i];
+            int offset = lba % DISK_CACHE_BLOCK_SECTORS;
+            int sectors = DISK_CACHE_BLOCK_SECTORS - offset;
+            if (sectors > total)
+            {
+                sectors = total;
+            }
+
+            if (res == 0)
+            {
+                if (!ISERR(cached) && disk_cache_wait(cached) == 0)
+                {
+                    memcpy(out, cached->data + offset * COS32_SECTOR_SIZE, sectors * COS32_SECTOR_SIZE);
+                }
+                else
+                {
+                    // The block may run past the end of the disk or the cache may be full, read only what we were asked for
+                    res = disk_read_block_uncached(disk, lba, sectors, out);
+                }
+            }
+
+            if (!ISERR(cached))
+            {
+                disk_cache_put(cached);
+            }
+
+            lba += sectors;
+            total -= sectors;
+            out += sectors * COS32_SECTOR_SIZE;
+        }
+    }
+
+    return res;
+}
+
+/**
+ * Starts reading every block holding "total" sectors starting at "lba" that isn't cached
+ */
+static int disk_cache_start_reads(struct disk *disk, unsigned int lba, int total, bool readahead)
+{
+    int res = disk_cache_resolve(&disk, &lba, total);
+    if (res < 0)
+    {
+        return res;
+    }
+
+    unsigned int block = lba / DISK_CACHE_BLOCK_SECTORS;
+    unsigned int last = (lba + total - 1) / DISK_CACHE_BLOCK_SECTORS;
+    disk_plug(disk);
+    for (; block <= last; block++)
+    {
+        if (disk_cache_find(disk, block))
+        {
+            continue;
+        }
+
+        struct disk_cache_block *cached = disk_cache_start_read(disk, block);
+        if (ISERR(cached))
+        {
+            res = ERROR_I(cached);
+            break;
+        }
+
+        if (readahead)
+        {
+            cached->readahead = true;
+            statistics.readahead_blocks++;
+        }
+    }
+    disk_unplug(disk);
+
+    return res;
+}
+
+int disk_cache_prefetch(struct disk *disk, unsigned int lba, int total)
+{
+    return disk_cache_start_reads(disk, lba, total, true);
+}
+
+int disk_cache_read_async(struct disk *disk, unsigned int lba, int total)
+{
+    return disk_cache_start_reads(disk, lba, total, false);
+}
+
+/**
+ * Returns the block for a write with its reference count raised. A write of the whole block doesn't need
+ * what is on the disk so nothing is read
+ */
+static struct disk_cache_block *disk_cache_get_for_write(struct disk *disk, unsigned int block, bool whole)
+{
+    if (!whole || disk_cache_find(disk, block))
+    {
+        return disk_cache_get(disk, block);
+    }
+
+    // The block would run past the end of the disk, it could never be written back
+    if (disk->total_sectors && (block + 1) * DISK_CACHE_BLOCK_SECTORS > disk->total_sectors)
+    {
+        return ERROR(-EIO);
+    }
+
+    struct disk_cache_block *cached = disk_cache_claim(disk, block);
+    if (!cached)
+    {
+        return ERROR(-ENOMEM);
+    }
+
+    disk_cache_hash_add(cached);
+    cached->valid = true;
+    cached->refcount++;
+    statistics.misses++;
+    statistics.used_blocks++;
+    return cached;
+}
+
+int disk_cache_write(struct disk *disk, unsigned int lba, int total, const void *buf)
+{
+    int res = disk_cache_resolve(&disk, &lba, total);
+    const char *in = buf;
+    while (total > 0 && res == 0)
+    {
+        unsigned int block = lba / DISK_CACHE_BLOCK_SECTORS;
+        int offset = lba % DISK_CACHE_BLOCK_SECTORS;
+        int sectors = DISK_CACHE_BLOCK_SECTORS - offset;
+        if (sectors > total)
+        {
+            sectors = total;
+        }
+
+        struct disk_cache_block *cached = disk_cache_get_for_write(disk, block, sectors == DISK_CACHE_BLOCK_SECTORS);
+        if (ISERR(cached))
+        {
+            // The cache is full of changed blocks or the block runs past the end of the disk
+            res = disk_write_block_uncached(disk, lba, sectors, in);
+        }
+        else
+        {
+            memcpy(cached->data + offset * COS32_SECTOR_SIZE, (void *)in, sectors * COS32_SECTOR_SIZE);
+            disk_cache_mark_dirty(cached);
+            disk_cache_put(cached);
+        }
+
+        lba += sectors;
+        total -= sectors;
+        in += sectors * COS32_SECTOR_SIZE;
+    }
+
+    if (statistics.dirty_blocks >= COS32_DISK_CACHE_DIRTY_MAX_BLOCKS)
+    {
+        // Changed blocks can't be evicted, we don't wait for the flusher before the cache has room for nothing else
+        disk_cache_writeback();
+    }
+
+    return res;
+}
+
+/**
+ * Returns true if the block is one of "first" to "last" of the disk, a null disk matches the blocks of every disk
+ */
+static bool disk_cache_block_in(struct disk_cache_block *block, struct disk *disk, unsigned int first, unsigned int last)
+{
+    if (!block->disk)
+    {
+        return false;
+    }
+
+    return !disk || (block->disk == disk && block->block >= first && block->block <= last);
+}
+
+/**
+ * Starts writing every changed block of the range that isn't already being written, returns the first error
+ */
+static int disk_cache_start_writes(struct disk *only, unsigned int first, unsigned int last)
+{
+    int res = 0;
+    if (!statistics.dirty_blocks)
+    {
+        return 0;
+    }
+
+    // The blocks of each disk are given to it together so that neighbouring blocks are merged into one write
+    struct disk *disk = 0;
+    for (int i = 0; (disk = disk_get(i)) != 0; i++)
+    {
+        if (only && disk != only)
+        {
+            continue;
+        }
+
+        disk_plug(disk);
+        for (int b = 0; b < COS32_DISK_CACHE_BLOCKS; b++)
+        {
+            struct disk_cache_block *block = &blocks[b];
+            if (block->disk != disk || !disk_cache_block_in(block, only, first, last) || !block->dirty || block->writing)
+            {
+                continue;
+            }
+
+            int write_res = disk_cache_start_write(block);
+            if (write_res < 0 && res == 0)
+            {
+                res = write_res;
+            }
+        }
+        disk_unplug(disk);
+    }
+
+    return res;
+}
+
+/**
+ * Waits for every block of the range being written back
+ */
+static void disk_cache_wait_writes(struct disk *disk, unsigned int first, unsigned int last)
+{
+    for (int i = 0; i < COS32_DISK_CACHE_BLOCKS; i++)
+    {
+        struct disk_cache_block *block = &blocks[i];
+        if (!block->writing || !disk_cache_block_in(block, disk, first, last))
+        {
+            continue;
+        }
+
+        block->refcount++;
+        bio_wait(&block->bio);
+        disk_cache_put(block);
+    }
+}
+
+/**
+ * Writes every changed block of the range and waits for them, returns an error if any write failed
+ */
+static int disk_cache_sync_blocks(struct disk *disk, unsigned int first, unsigned int last)
+{
+    // A block changed whilst it was being written may have been written with only some of the change,
+    // we wait for it before it is written again
+    disk_cache_wait_writes(disk, first, last);
+
+    uint32_t errors = statistics.write_errors;
+    int res = disk_cache_start_writes(disk, first, last);
+    disk_cache_wait_writes(disk, first, last);
+    if (res == 0 && statistics.write_errors != errors)
+    {
+        res = -EIO;
+    }
+
+    return res;
+}
+
+void disk_cache_writeback(void)
+{
+    disk_cache_start_writes(0, 0, 0);
+}
+
+int disk_cache_sync(void)
+{
+    return disk_cache_sync_blocks(0, 0, 0);
+}
+
+int disk_cache_sync_range(struct disk *disk, unsigned int lba, int total)
+{
+    int res = disk_cache_resolve(&disk, &lba, total);
+    if (res < 0 || total <= 0)
+    {
+        return res;
+    }
+
+    return disk_cache_sync_blocks(disk, lba / DISK_CACHE_BLOCK_SECTORS, (lba + total - 1) / DISK_CACHE_BLOCK_SECTORS);
+}
+
+static void disk_cache_flusher(void *arg)
+{
+    while (1)
+    {
+        kthread_sleep(COS32_DISK_CACHE_FLUSH_INTERVAL_MS);
+
+        // The kernel is not re-entrant, we must not be interrupted whilst starting the writes
+        disable_interrupts();
+        smp_lock_kernel();
+        disk_cache_writeback();
+        smp_unlock_kernel();
+        enable_interrupts();
+    }
+}
+
+void disk_cache_flusher_start()
+{
+    if (ISERR(kthread_create("flusher", disk_cache_flusher, 0)))
+    {
+        panic("Failed to start the disk cache flusher\n");
+    }
+}
+
+void disk_cache_get_statistics(struct disk_cache_statistics *out)
+{
+    memcpy(out, &statistics, sizeof(statistics));
+}
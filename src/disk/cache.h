@@ -0,0 +1,148 @@
+#ifndef DISK_CACHE_H
+#define DISK_CACHE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+#include "bio.h"
+
+#define DISK_CACHE_BLOCK_SECTORS (COS32_DISK_CACHE_BLOCK_SIZE / COS32_SECTOR_SIZE)
+
+// The most blocks a read asks for before it waits for any of them
+#define DISK_CACHE_READ_BATCH_BLOCKS 32
+
+struct disk;
+
+// A block of consecutive sectors held in memory
+struct disk_cache_block
+{
+    struct disk *disk;
+
+    // The block number on the disk, the first sector is block * DISK_CACHE_BLOCK_SECTORS
+    unsigned int block;
+
+    // True once the data has been read from the disk
+    bool valid;
+
+    // True whilst the data is being read, the block can be found so nobody reads it twice but must be waited for
+    bool reading;
+
+    // True if the data was changed since it was last written to the disk, such blocks are never evicted
+    bool dirty;
+
+    // True whilst the data is being written back, the write holds a reference. A block may be changed again
+    // during the write in which case it is dirty once more
+    bool writing;
+
+    // Used by whichever of the read or write is in flight
+    struct bio bio;
+
+    // Blocks in use are never evicted
+    int refcount;
+
+    // True if the block was read ahead and nobody has asked for it yet
+    bool readahead;
+
+    char *data;
+
+    // The next block in the same bucket of the hash table
+    struct disk_cache_block *hash_next;
+
+    // Blocks are kept least recently used first
+    struct disk_cache_block *lru_next;
+    struct disk_cache_block *lru_prev;
+};
+
+// The layout is shared with user space
+struct disk_cache_statistics
+{
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t evictions;
+    uint32_t block_size;
+    uint32_t total_blocks;
+
+    // Blocks holding data from the disk
+    uint32_t used_blocks;
+
+    // Blocks read before anyone asked for them
+    uint32_t readahead_blocks;
+
+    // Blocks read ahead that were then asked for
+    uint32_t readahead_hits;
+
+    // Blocks read ahead that were evicted without ever being asked for
+    uint32_t readahead_wasted;
+
+    // Blocks changed and not yet written back
+    uint32_t dirty_blocks;
+
+    // Blocks written back to their disk and how many of those writes failed
+    uint32_t writebacks;
+    uint32_t write_errors;
+};
+
+/**
+ * Allocates every block of the cache, must be called before any disk is read
+ */
+void disk_cache_init();
+
+/**
+ * Returns the block holding the given block of the disk with its reference count raised, reading it if it is not cached.
+ * Returns an error if every block is in use or the disk can't be read. Blocks of a partition are kept under the drive it is on
+ * so "disk" must not be a partition, the read and write functions below take care of that
+ */
+struct disk_cache_block *disk_cache_get(struct disk *disk, unsigned int block);
+
+/**
+ * Drops a reference taken with disk_cache_get
+ */
+void disk_cache_put(struct disk_cache_block *block);
+
+/**
+ * Reads "total" sectors starting at "lba" through the cache
+ */
+int disk_cache_read(struct disk *disk, unsigned int lba, int total, void *buf);
+
+/**
+ * Starts loading the blocks holding "total" sectors starting at "lba" into the cache without reading them for anyone,
+ * returns without waiting for them
+ */
+int disk_cache_prefetch(struct disk *disk, unsigned int lba, int total);
+
+/**
+ * Starts loading the blocks holding "total" sectors starting at "lba" into the cache for a read that is coming,
+ * returns without waiting for them
+ */
+int disk_cache_read_async(struct disk *disk, unsigned int lba, int total);
+
+/**
+ * Writes "total" sectors from "buf" starting at "lba" into the cache, the blocks are written to the disk later.
+ * Sectors the cache has no room for are written straight to the disk
+ */
+int disk_cache_write(struct disk *disk, unsigned int lba, int total, const void *buf);
+
+/**
+ * Starts writing every changed block to its disk, returns without waiting for them
+ */
+void disk_cache_writeback(void);
+
+/**
+ * Writes every changed block to its disk and waits for them, returns an error if any write failed
+ */
+int disk_cache_sync(void);
+
+/**
+ * Writes the changed blocks holding the given sectors of the disk and waits for them, so that the sectors can be
+ * read from the drive without the cache. Returns an error if any write failed
+ */
+int disk_cache_sync_range(struct disk *disk, unsigned int lba, int total);
+
+/**
+ * Starts the kernel thread that writes changed blocks back every COS32_DISK_CACHE_FLUSH_INTERVAL_MS
+ */
+void disk_cache_flusher_start();
+
+void disk_cache_get_statistics(struct disk_cache_statistics *statistics);
+
+#endif
@@ -3,39 +3,56 @@
 #include "kernel.h"
 #include "status.h"
 #include "config.h"
-#include "io/io.h"
-struct disk disk;
-
-int disk_read_sector(int lba, int total, void *buf)
-{
-    outb(0x1F6, (lba >> 24) | 0xE0);
-    outb(0x1F2, total);
-    outb(0x1F3, (unsigned char)(lba & 0xff));
-    outb(0x1F4, (unsigned char)(lba >> 8));
-    outb(0x1F5, (unsigned char)(lba >> 16));
-    outb(0x1F7, 0x20);
+#include "cache.h"
+#include "ata.h"
+#include "idedma.h"
+#include "ahci.h"
+#include "mbr.h"
+#include "virtioblk.h"
+#include "task/task.h"
+#include "task/kthread.h"
+#include "smp/smp.h"
 
+static struct disk disks[COS32_MAX_DISKS];
+static int total_disks = 0;
 
-    unsigned short* ptr = (unsigned short*) buf;
-    for (int b = 0; b < total; b++)
+struct disk *disk_register(struct disk_driver *driver, void *driver_private)
+{
+    if (total_disks == COS32_MAX_DISKS)
     {
+        return 0;
+    }
 
-        // Wait until buffer is ready
-        char c = insb(0x1F7);
-        while (!(c & 0x08))
-        {
-            c = insb(0x1F7);
-        }
+    struct disk *disk = &disks[total_disks];
+    memset(disk, 0, sizeof(struct disk));
+    disk->type = COS32_DISK_TYPE_REAL;
+    disk->id = total_disks;
+    disk->sector_size = COS32_SECTOR_SIZE;
+    disk->driver = driver;
+    disk->driver_private = driver_private;
+    disk_queue_init(disk);
+    total_disks++;
+    return disk;
+}
 
-        // Copy from hard disk to memory two bytes at a time
-        for (int i = 0; i < 256; i++)
-        {
-            *ptr = insw(0x1F0);
-            ptr++;
-        }
+struct disk *disk_register_partition(struct disk *parent, unsigned int offset, unsigned int total_sectors)
+{
+    struct disk *disk = disk_register(parent->driver, parent->driver_private);
+    if (!disk)
+    {
+        return 0;
     }
 
-    return 0;
+    disk->type = COS32_DISK_TYPE_PARTITION;
+    disk->parent = parent;
+    disk->offset = offset;
+    disk->total_sectors = total_sectors;
+
+    // Bios are sized for the queue of the drive they are read through
+    disk->queue.max_sectors = parent->queue.max_sectors;
+    disk->queue.max_segments = parent->queue.max_segments;
+    disk->queue.depth = parent->queue.depth;
+    return disk;
 }
 
 /**
@@ -43,31 +60,211 @@ int disk_read_sector(int lba, int total, void *buf)
  */
 void disk_search_and_init()
 {
-    // We only have one disk right now, lets just make it the primary disk
-    // we wont bother checking if we even have a hard disk connected lets just hope we do
-    // This abstraction exists so later we can make a clean implementation when we come to implement multiple disks and possibly virtual disks
-    memset(&disk, 0, sizeof(disk));
-    disk.type = COS32_DISK_TYPE_REAL;
-    disk.id = 0;
-    disk.sector_size = COS32_SECTOR_SIZE;
-    disk.filesystem = fs_resolve(&disk);
+    disk_cache_init();
+    memset(disks, 0, sizeof(disks));
+    total_disks = 0;
+
+    // The kernel was loaded from the first drive, the primary master when there is an IDE controller otherwise
+    // the first AHCI port. Machines without either may still have the legacy ports
+    if (idedma_init() == 0)
+    {
+        ata_init();
+    }
+
+    ahci_init();
+    if (total_disks == 0)
+    {
+        ata_init();
+    }
+
+    virtio_blk_init();
+
+    // Partitions are added after every drive so the drives keep their numbers
+    int drives = total_disks;
+    for (int i = 0; i < drives; i++)
+    {
+        disks[i].filesystem = fs_resolve(&disks[i]);
+        if (!disks[i].filesystem)
+        {
+            // A drive without a filesystem of its own may be split into partitions
+            mbr_scan(&disks[i]);
+        }
+    }
+
+    for (int i = drives; i < total_disks; i++)
+    {
+        disks[i].filesystem = fs_resolve(&disks[i]);
+    }
 }
 
 struct disk *disk_get(int index)
 {
-    // We only have one disk implemented right now
-    if (index != 0)
+    if (index < 0 || index >= total_disks)
         return 0;
 
-    return &disk;
+    return &disks[index];
+}
+
+void disk_wait(volatile bool *complete, struct task **waiter, DISK_POLL_FUNCTION poll, void *private)
+{
+    struct task *task = task_current();
+    if (task && task_is_kernel_thread(task) && waiter)
+    {
+        while (!*complete)
+        {
+            // Interrupts are taken by the boot processor which runs every kernel thread, it can't wake us before we yield
+            *waiter = task;
+            task->awake = false;
+            smp_unlock_kernel();
+            kthread_yield();
+            smp_lock_kernel();
+        }
+        return;
+    }
+
+    disk_poll(complete, poll, private);
+}
+
+void disk_poll(volatile bool *complete, DISK_POLL_FUNCTION poll, void *private)
+{
+    // Nobody holds the kernel lock whilst we are booting
+    struct task *task = task_current();
+    if (!task)
+    {
+        poll(private);
+        while (!*complete)
+        {
+            __asm__ __volatile__("pause");
+            poll(private);
+        }
+        return;
+    }
+
+    poll(private);
+    while (!*complete)
+    {
+        // We only hold the lock to poll, the interrupt handler and every other processor need it whilst we wait
+        smp_unlock_kernel();
+        if (task_is_kernel_thread(task))
+        {
+            // Kernel threads polling a drive without an interrupt let the others on their processor run in between
+            kthread_yield();
+        }
+        else
+        {
+            for (int i = 0; i < DISK_POLL_SPINS && !*complete; i++)
+            {
+                __asm__ __volatile__("pause");
+            }
+        }
+        smp_lock_kernel();
+
+        if (!*complete)
+        {
+            poll(private);
+        }
+    }
 }
 
 int disk_read_block(struct disk *idisk, unsigned int lba, int total, void *buf)
 {
+    return disk_cache_read(idisk, lba, total, buf);
+}
 
-    // We have only the possibility one disk at the moment so the pointer shouldnt differ from it
-    if (idisk != &disk)
+/**
+ * Reads or writes straight from or to the disk, the transfer is split into bios that are all in flight at once
+ */
+static int disk_transfer_uncached(struct disk *idisk, unsigned int lba, int total, void *buf, bool write)
+{
+    if (!idisk || !idisk->driver)
         return -EIO;
 
-    return disk_read_sector(lba, total, buf);
-}
\ No newline at end of file
+    int res = 0;
+    struct bio bios[DISK_UNCACHED_READ_BIOS];
+    char *out = buf;
+    while (total > 0)
+    {
+        // Every bio is given to the driver at once so it can work on them together
+        int submitted = 0;
+        disk_plug(idisk);
+        while (total > 0 && submitted < DISK_UNCACHED_READ_BIOS)
+        {
+            struct bio *bio = &bios[submitted];
+            memset(bio, 0, sizeof(struct bio));
+            bio->disk = idisk;
+            bio->lba = lba;
+            bio->sectors = total < idisk->queue.max_sectors ? total : idisk->queue.max_sectors;
+            bio->buf = out;
+            bio->write = write;
+            res = bio_submit(bio);
+            if (res < 0)
+            {
+                break;
+            }
+
+            submitted++;
+            lba += bio->sectors;
+            total -= bio->sectors;
+            out += bio->sectors * COS32_SECTOR_SIZE;
+        }
+        disk_unplug(idisk);
+
+        // Every bio is waited for even if one fails, the driver may still be using the memory of the others
+        for (int i = 0; i < submitted; i++)
+        {
+            int bio_res = bio_wait(&bios[i]);
+            if (bio_res < 0)
+            {
+                res = bio_res;
+            }
+        }
+
+        if (res < 0)
+        {
+            break;
+        }
+    }
+
+    return res;
+}
+
+int disk_read_block_uncached(struct disk *idisk, unsigned int lba, int total, void *buf)
+{
+    return disk_transfer_uncached(idisk, lba, total, buf, false);
+}
+
+int disk_write_block(struct disk *idisk, unsigned int lba, int total, const void *buf)
+{
+    return disk_cache_write(idisk, lba, total, buf);
+}
+
+int disk_write_block_uncached(struct disk *idisk, unsigned int lba, int total, const void *buf)
+{
+    // The drive only reads from the memory of a write
+    return disk_transfer_uncached(idisk, lba, total, (void *)buf, true);
+}
+
+int disk_sync()
+{
+    int res = disk_cache_sync();
+    for (int i = 0; i < total_disks; i++)
+    {
+        // Partitions are written through the drive they are on
+        struct disk *disk = &disks[i];
+        if (disk->parent || !disk->driver->flush || disk->queue.statistics.writes == disk->flushed_writes)
+        {
+            continue;
+        }
+
+        uint32_t writes = disk->queue.statistics.writes;
+        int flush_res = disk->driver->flush(disk);
+        if (flush_res < 0)
+        {
+            res = flush_res;
+            continue;
+        }
+        disk->flushed_writes = writes;
+    }
+
+    return res;
+}
@@ -2,10 +2,87 @@
 #define DISK_H
 
 #include "fs/file.h"
+#include "bio.h"
+#include <stdbool.h>
 typedef unsigned int COS32_DISK_TYPE;
 
 // States this is a physical piece of hardware
 #define COS32_DISK_TYPE_REAL 0
+// States this is a partition of another disk, its sectors are read through that disk
+#define COS32_DISK_TYPE_PARTITION 1
+
+// The most sectors a single ATA command can transfer, bigger transfers are split into several commands
+#define DISK_MAX_SECTORS_PER_COMMAND 256
+
+// The most pieces of memory a single ATA command fills or empties
+#define DISK_ATA_MAX_SEGMENTS 16
+
+// The most bios an uncached read or write has in flight at once
+#define DISK_UNCACHED_READ_BIOS 16
+
+// How many times disk_poll pauses without the kernel lock before it polls the driver again
+#define DISK_POLL_SPINS 64
+
+// Set in the ATA status register when the last command failed
+#define DISK_ATA_STATUS_ERR 0x01
+// Set in the ATA status register when the drive has data ready for us
+#define DISK_ATA_STATUS_DRQ 0x08
+
+struct disk;
+struct task;
+
+/**
+ * Starts the transfer of the request, each of its bios is one segment. Drivers that can't queue may finish the
+ * transfer before they return, either way disk_request_complete is called once it's done.
+ * Returns -ENOMEM if the driver has no room for another request right now
+ */
+typedef int (*DISK_SUBMIT_FUNCTION)(struct disk *disk, struct disk_request *request);
+
+/**
+ * Called after requests have been submitted, for drivers that tell the device about new requests in one go
+ */
+typedef void (*DISK_COMMIT_FUNCTION)(struct disk *disk);
+
+/**
+ * Checks the hardware for a finished transfer when we can't sleep until its interrupt
+ */
+typedef void (*DISK_POLL_FUNCTION)(void *private);
+
+/**
+ * Makes the drive write the contents of its own write cache to the media, called once every write we care about
+ * has completed. Returns an error if the drive failed to
+ */
+typedef int (*DISK_FLUSH_FUNCTION)(struct disk *disk);
+
+struct disk_driver
+{
+    DISK_SUBMIT_FUNCTION submit;
+
+    // May be NULL
+    DISK_COMMIT_FUNCTION commit;
+
+    // Called with the disk's driver_private, may be NULL if submit completes every request before it returns
+    DISK_POLL_FUNCTION poll;
+
+    // May be NULL if the drive has no write cache or we can't ask it to flush
+    DISK_FLUSH_FUNCTION flush;
+
+    // The most sectors and segments a single request may have
+    int max_sectors;
+    int max_segments;
+
+    // The most requests the driver can have in flight at once
+    int queue_depth;
+
+    char name[20];
+};
+
+// A piece of memory a transfer fills, drivers that can scatter fill several with one request
+struct disk_segment
+{
+    void *buf;
+    int sectors;
+};
 
 struct disk
 {
@@ -14,6 +91,27 @@ struct disk
     int id;
     int sector_size;
 
+    struct disk_driver *driver;
+
+    // Private data for the driver, such as which controller the disk is on
+    void *driver_private;
+
+    // The disk a partition is on and the sector of that disk where the partition starts, NULL for a whole drive
+    struct disk *parent;
+    unsigned int offset;
+
+    // The size of the disk in sectors, zero if the driver doesn't know
+    unsigned int total_sectors;
+
+    // True if the drive's interrupt couldn't be routed to us, kernel threads poll for its transfers rather than sleeping
+    bool polled;
+
+    // Requests waiting for the driver and the ones it is working on
+    struct disk_queue queue;
+
+    // How many write requests the queue had when the drive last flushed its cache, it needs no flush until there are more
+    uint32_t flushed_writes;
+
     // Private data for filesystem to manage, the filesystem can do what he wants with this pointer everyone else leave it alone
     void* fs_private;
 };
@@ -23,6 +121,60 @@ struct disk
  */
 void disk_search_and_init();
 struct disk* disk_get(int index);
+
+/**
+ * Adds a disk read through the given driver, called by drivers as they find their disks.
+ * Drivers may lower the limits of the disk's queue once it's added.
+ * Filesystems are resolved once every disk is found. Returns NULL if we have no room for another disk
+ */
+struct disk *disk_register(struct disk_driver *driver, void *driver_private);
+
+/**
+ * Adds a disk for the "total_sectors" sectors of "parent" starting at "offset". Returns NULL if we have no room for another disk
+ */
+struct disk *disk_register_partition(struct disk *parent, unsigned int offset, unsigned int total_sectors);
+
+/**
+ * Waits until a driver's interrupt handler sets "complete". Kernel threads sleep with "waiter" set so the handler
+ * can wake them, they must hold the kernel lock with interrupts disabled. Everyone else is in a system call or
+ * still booting and can't sleep, so "poll" is called until the transfer is done.
+ * "waiter" is NULL for drives without an interrupt, kernel threads then poll too
+ */
+void disk_wait(volatile bool *complete, struct task **waiter, DISK_POLL_FUNCTION poll, void *private);
+
+/**
+ * Calls "poll" until "complete" is set. Once tasks are running the kernel lock is only held whilst "poll" runs,
+ * a kernel thread may be asleep part way through the transfer we are waiting for and needs the lock to finish it
+ */
+void disk_poll(volatile bool *complete, DISK_POLL_FUNCTION poll, void *private);
+
+/**
+ * Reads "total" sectors starting at "lba" into "buf" through the block cache, any amount of sectors may be read at once
+ */
 int disk_read_block(struct disk *idisk, unsigned int lba, int total, void *buf);
-int disk_read_sector(int lba, int total, void *buf);
+
+/**
+ * Reads "total" sectors starting at "lba" into "buf" straight from the disk, the read is split into bios
+ * that are all in flight at once
+ */
+int disk_read_block_uncached(struct disk *idisk, unsigned int lba, int total, void *buf);
+
+/**
+ * Writes "total" sectors from "buf" starting at "lba" into the block cache, the disk is written later by the
+ * flusher or disk_sync. Sectors the cache has no room for are written to the disk at once
+ */
+int disk_write_block(struct disk *idisk, unsigned int lba, int total, const void *buf);
+
+/**
+ * Writes "total" sectors from "buf" starting at "lba" straight to the disk, returns once the drive has them.
+ * The drive may still hold them in its own cache until the disk is flushed
+ */
+int disk_write_block_uncached(struct disk *idisk, unsigned int lba, int total, const void *buf);
+
+/**
+ * Writes every modified block of the cache to its disk then makes every drive flush its own cache,
+ * once this returns everything written before it was called is on the media
+ */
+int disk_sync();
+
 #endif
\ No newline at end of file
@@ -0,0 +1,254 @@
+#include "idedma.h"
+#include "disk.h"
+#include "pci/pci.h"
+#include "io/io.h"
+#include "idt/idt.h"
+#include "idt/controller.h"
+#include "task/task.h"
+#include "memory/memory.h"
+#include "memory/kheap.h"
+#include "config.h"
+#include "status.h"
+
+static struct idedma_channel channels[IDEDMA_TOTAL_CHANNELS];
+
+/**
+ * Stops the transfer and records how it went, the status registers are cleared for the next one
+ */
+static void idedma_finish(struct idedma_channel *channel, uint8_t bus_master_status)
+{
+    outb(channel->bus_master + IDEDMA_BUS_MASTER_COMMAND, IDEDMA_BUS_MASTER_COMMAND_WRITE_MEMORY);
+
+    // Reading the status register makes the drive lower its interrupt
+    channel->ata_status = insb(channel->io_base + IDEDMA_ATA_STATUS);
+    outb(channel->bus_master + IDEDMA_BUS_MASTER_STATUS, bus_master_status | IDEDMA_BUS_MASTER_STATUS_ERROR | IDEDMA_BUS_MASTER_STATUS_INTERRUPT);
+
+    channel->bus_master_status = bus_master_status;
+    channel->active = false;
+    channel->complete = true;
+    if (channel->waiter)
+    {
+        task_wake(channel->waiter);
+        channel->waiter = 0;
+    }
+}
+
+static void idedma_handle_interrupt(struct idedma_channel *channel)
+{
+    uint8_t status = insb(channel->bus_master + IDEDMA_BUS_MASTER_STATUS);
+    if (!channel->active || !(status & IDEDMA_BUS_MASTER_STATUS_INTERRUPT))
+    {
+        // Not a transfer of ours, PIO reads also make the drive interrupt
+        insb(channel->io_base + IDEDMA_ATA_STATUS);
+        return;
+    }
+
+    idedma_finish(channel, status);
+}
+
+static void idedma_primary_interrupt()
+{
+    idedma_handle_interrupt(&channels[IDEDMA_CHANNEL_PRIMARY]);
+}
+
+static void idedma_secondary_interrupt()
+{
+    idedma_handle_interrupt(&channels[IDEDMA_CHANNEL_SECONDARY]);
+}
+
+static void idedma_channel_init(struct idedma_channel *channel, uint16_t io_base, uint16_t bus_master, int irq, INTERRUPT_CALLBACK_FUNCTION callback)
+{
+    channel->io_base = io_base;
+    channel->bus_master = bus_master;
+    channel->irq = irq;
+    channel->prdt = kzalloc(COS32_PAGE_SIZE);
+    if (!channel->prdt)
+    {
+        return;
+    }
+
+    if (idt_register_interrupt_callback(INTERRUPT_CONTROLLER_IRQ_BASE + irq, callback) < 0)
+    {
+        kfree(channel->prdt);
+        channel->prdt = 0;
+        return;
+    }
+
+    interrupt_controller_enable_irq(irq);
+    outb(io_base + IDEDMA_ATA_CONTROL_OFFSET, 0);
+    channel->ready = true;
+}
+
+int idedma_init()
+{
+    memset(channels, 0, sizeof(channels));
+
+    struct pci_device device;
+    if (pci_find_class(PCI_CLASS_MASS_STORAGE, PCI_SUBCLASS_IDE, &device) < 0)
+    {
+        return -EIO;
+    }
+
+    if (!(device.prog_if & IDEDMA_PROG_IF_BUS_MASTER) || !pci_bar_is_io(&device, IDEDMA_BAR_BUS_MASTER))
+    {
+        return 0;
+    }
+
+    uint32_t bus_master = pci_bar(&device, IDEDMA_BAR_BUS_MASTER);
+    if (!bus_master)
+    {
+        return 0;
+    }
+
+    pci_enable_bus_master(&device);
+
+    // Channels in native mode have other ports and share a PCI interrupt, they are left to PIO
+    if (!(device.prog_if & IDEDMA_PROG_IF_PRIMARY_NATIVE))
+    {
+        idedma_channel_init(&channels[IDEDMA_CHANNEL_PRIMARY], IDEDMA_PRIMARY_IO_BASE, bus_master, IDEDMA_PRIMARY_IRQ, idedma_primary_interrupt);
+    }
+
+    if (!(device.prog_if & IDEDMA_PROG_IF_SECONDARY_NATIVE))
+    {
+        idedma_channel_init(&channels[IDEDMA_CHANNEL_SECONDARY], IDEDMA_SECONDARY_IO_BASE, bus_master + IDEDMA_BUS_MASTER_CHANNEL_SIZE, IDEDMA_SECONDARY_IRQ, idedma_secondary_interrupt);
+    }
+
+    return 0;
+}
+
+bool idedma_ready(int channel)
+{
+    if (channel < 0 || channel >= IDEDMA_TOTAL_CHANNELS)
+    {
+        return false;
+    }
+
+    return channels[channel].ready;
+}
+
+/**
+ * Describes the memory of every segment in the channel's PRD table, the kernel maps every address to itself.
+ * Returns the amount of sectors described
+ */
+static int idedma_build_prdt(struct idedma_channel *channel, struct disk_segment *segments, int total_segments)
+{
+    int total = 0;
+    int sectors = 0;
+    for (int i = 0; i < total_segments; i++)
+    {
+        uint32_t address = (uint32_t)segments[i].buf;
+        uint32_t bytes = segments[i].sectors * COS32_SECTOR_SIZE;
+
+        // The controller transfers words
+        if (address & 1)
+        {
+            return -EINVARG;
+        }
+
+        sectors += segments[i].sectors;
+        while (bytes > 0)
+        {
+            if (total == IDEDMA_MAX_PRDS)
+            {
+                return -EINVARG;
+            }
+
+            uint32_t boundary = (address & ~(IDEDMA_PRD_BOUNDARY - 1)) + IDEDMA_PRD_BOUNDARY;
+            uint32_t amount = boundary - address;
+            if (amount > bytes)
+            {
+                amount = bytes;
+            }
+
+            struct idedma_prd *prd = &channel->prdt[total++];
+            prd->address = address;
+            prd->bytes = amount & 0xFFFF;
+            prd->flags = 0;
+
+            address += amount;
+            bytes -= amount;
+        }
+    }
+
+    if (!total)
+    {
+        return -EINVARG;
+    }
+
+    channel->prdt[total - 1].flags = IDEDMA_PRD_END_OF_TABLE;
+    return sectors;
+}
+
+static void idedma_poll(void *private)
+{
+    struct idedma_channel *channel = private;
+    uint8_t status = insb(channel->bus_master + IDEDMA_BUS_MASTER_STATUS);
+    if (status & (IDEDMA_BUS_MASTER_STATUS_INTERRUPT | IDEDMA_BUS_MASTER_STATUS_ERROR))
+    {
+        idedma_finish(channel, status);
+    }
+}
+
+int idedma_transfer(int channel_id, bool slave, bool lba48, bool write, unsigned int lba, struct disk_segment *segments, int total_segments)
+{
+    int res = 0;
+    if (!idedma_ready(channel_id))
+    {
+        res = -EINVARG;
+        goto out;
+    }
+
+    struct idedma_channel *channel = &channels[channel_id];
+    int total = idedma_build_prdt(channel, segments, total_segments);
+    if (total < 0 || total > (lba48 ? IDEDMA_LBA48_MAX_SECTORS : DISK_MAX_SECTORS_PER_COMMAND))
+    {
+        res = -EINVARG;
+        goto out;
+    }
+
+    // The controller writes to memory when we read from the drive
+    uint8_t direction = write ? 0 : IDEDMA_BUS_MASTER_COMMAND_WRITE_MEMORY;
+    outl(channel->bus_master + IDEDMA_BUS_MASTER_PRDT, (uint32_t)channel->prdt);
+    outb(channel->bus_master + IDEDMA_BUS_MASTER_COMMAND, direction);
+    outb(channel->bus_master + IDEDMA_BUS_MASTER_STATUS, IDEDMA_BUS_MASTER_STATUS_ERROR | IDEDMA_BUS_MASTER_STATUS_INTERRUPT);
+
+    while (insb(channel->io_base + IDEDMA_ATA_STATUS) & IDEDMA_ATA_STATUS_BSY)
+    {
+    }
+
+    uint8_t command = write ? IDEDMA_ATA_COMMAND_WRITE_DMA : IDEDMA_ATA_COMMAND_READ_DMA;
+    if (lba48)
+    {
+        // Each register takes its high byte first, a count of zero asks for 65536 sectors
+        outb(channel->io_base + IDEDMA_ATA_DRIVE, IDEDMA_ATA_DRIVE_MASTER_LBA48 | (slave ? IDEDMA_ATA_DRIVE_SLAVE : 0));
+        outb(channel->io_base + IDEDMA_ATA_SECTOR_COUNT, (unsigned char)(total >> 8));
+        outb(channel->io_base + IDEDMA_ATA_LBA_LOW, (unsigned char)(lba >> 24));
+        outb(channel->io_base + IDEDMA_ATA_LBA_MID, 0);
+        outb(channel->io_base + IDEDMA_ATA_LBA_HIGH, 0);
+        command = write ? IDEDMA_ATA_COMMAND_WRITE_DMA_EXT : IDEDMA_ATA_COMMAND_READ_DMA_EXT;
+    }
+    else
+    {
+        outb(channel->io_base + IDEDMA_ATA_DRIVE, ((lba >> 24) & 0x0F) | IDEDMA_ATA_DRIVE_MASTER_LBA | (slave ? IDEDMA_ATA_DRIVE_SLAVE : 0));
+    }
+
+    // A count of zero asks for 256 sectors
+    outb(channel->io_base + IDEDMA_ATA_SECTOR_COUNT, (unsigned char)total);
+    outb(channel->io_base + IDEDMA_ATA_LBA_LOW, (unsigned char)(lba & 0xff));
+    outb(channel->io_base + IDEDMA_ATA_LBA_MID, (unsigned char)(lba >> 8));
+    outb(channel->io_base + IDEDMA_ATA_LBA_HIGH, (unsigned char)(lba >> 16));
+
+    channel->complete = false;
+    channel->active = true;
+    outb(channel->io_base + IDEDMA_ATA_COMMAND, command);
+    outb(channel->bus_master + IDEDMA_BUS_MASTER_COMMAND, direction | IDEDMA_BUS_MASTER_COMMAND_START);
+
+    disk_wait(&channel->complete, &channel->waiter, idedma_poll, channel);
+    if ((channel->bus_master_status & IDEDMA_BUS_MASTER_STATUS_ERROR) || (channel->ata_status & DISK_ATA_STATUS_ERR))
+    {
+        res = -EIO;
+    }
+
+out:
+    return res;
+}
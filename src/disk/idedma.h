@@ -0,0 +1,124 @@
+#ifndef DISK_IDEDMA_H
+#define DISK_IDEDMA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define IDEDMA_TOTAL_CHANNELS 2
+#define IDEDMA_CHANNEL_PRIMARY 0
+#define IDEDMA_CHANNEL_SECONDARY 1
+
+// The legacy ports and IRQs of a controller in compatibility mode
+#define IDEDMA_PRIMARY_IO_BASE 0x1F0
+#define IDEDMA_PRIMARY_IRQ 14
+#define IDEDMA_SECONDARY_IO_BASE 0x170
+#define IDEDMA_SECONDARY_IRQ 15
+
+// Set in the programming interface when a channel uses PCI native mode rather than the legacy ports
+#define IDEDMA_PROG_IF_PRIMARY_NATIVE 0x01
+#define IDEDMA_PROG_IF_SECONDARY_NATIVE 0x04
+// Set in the programming interface when the controller can be a bus master
+#define IDEDMA_PROG_IF_BUS_MASTER 0x80
+
+// The bus master registers are in the I/O space of BAR4, the secondary channel's registers follow the primary's
+#define IDEDMA_BAR_BUS_MASTER 4
+#define IDEDMA_BUS_MASTER_CHANNEL_SIZE 0x08
+#define IDEDMA_BUS_MASTER_COMMAND 0x00
+#define IDEDMA_BUS_MASTER_STATUS 0x02
+#define IDEDMA_BUS_MASTER_PRDT 0x04
+
+#define IDEDMA_BUS_MASTER_COMMAND_START 0x01
+// The controller writes to memory, clear to read from memory
+#define IDEDMA_BUS_MASTER_COMMAND_WRITE_MEMORY 0x08
+
+#define IDEDMA_BUS_MASTER_STATUS_ACTIVE 0x01
+#define IDEDMA_BUS_MASTER_STATUS_ERROR 0x02
+#define IDEDMA_BUS_MASTER_STATUS_INTERRUPT 0x04
+
+// ATA task file registers relative to the channel's I/O base
+#define IDEDMA_ATA_SECTOR_COUNT 0x02
+#define IDEDMA_ATA_LBA_LOW 0x03
+#define IDEDMA_ATA_LBA_MID 0x04
+#define IDEDMA_ATA_LBA_HIGH 0x05
+#define IDEDMA_ATA_DRIVE 0x06
+#define IDEDMA_ATA_COMMAND 0x07
+#define IDEDMA_ATA_STATUS 0x07
+
+// The device control register is this far past the I/O base, writing zero lets the drive raise interrupts
+#define IDEDMA_ATA_CONTROL_OFFSET 0x206
+
+#define IDEDMA_ATA_STATUS_BSY 0x80
+#define IDEDMA_ATA_COMMAND_READ_DMA 0xC8
+#define IDEDMA_ATA_COMMAND_READ_DMA_EXT 0x25
+#define IDEDMA_ATA_COMMAND_WRITE_DMA 0xCA
+#define IDEDMA_ATA_COMMAND_WRITE_DMA_EXT 0x35
+
+// Selects the master drive with LBA addressing, the slave bit picks the other drive
+#define IDEDMA_ATA_DRIVE_MASTER_LBA 0xE0
+#define IDEDMA_ATA_DRIVE_MASTER_LBA48 0x40
+#define IDEDMA_ATA_DRIVE_SLAVE 0x10
+
+// The most sectors a single LBA48 command transfers
+#define IDEDMA_LBA48_MAX_SECTORS 65536
+
+// A region described by a PRD may not cross a 64KB boundary and a byte count of zero means 64KB
+#define IDEDMA_PRD_BOUNDARY 0x10000
+#define IDEDMA_PRD_END_OF_TABLE 0x8000
+
+// The table is a page, each PRD describes at most 64KB
+#define IDEDMA_MAX_PRDS 512
+
+// A physical region descriptor, one piece of the memory a transfer reads into or writes from
+struct idedma_prd
+{
+    uint32_t address;
+    uint16_t bytes;
+    uint16_t flags;
+} __attribute__((packed));
+
+struct task;
+struct disk_segment;
+
+struct idedma_channel
+{
+    // True if the channel can do DMA, otherwise the disk falls back to PIO
+    bool ready;
+
+    uint16_t io_base;
+    uint16_t bus_master;
+    int irq;
+
+    // Must be dword aligned and not cross a 64KB boundary, a page from the kernel heap is both
+    struct idedma_prd *prdt;
+
+    // True between starting a transfer and its completion
+    bool active;
+    volatile bool complete;
+    uint8_t bus_master_status;
+    uint8_t ata_status;
+
+    // The kernel thread sleeping until the transfer completes, if any
+    struct task *waiter;
+};
+
+/**
+ * Finds the PCI IDE controller and prepares its channels for bus master DMA, channels that can't
+ * do DMA are left for PIO. Returns an error if there is no IDE controller on the PCI buses
+ */
+int idedma_init();
+
+/**
+ * Returns true if transfers on the given channel can use DMA
+ */
+bool idedma_ready(int channel);
+
+/**
+ * Reads the sectors starting at "lba" from the master or slave drive of the channel into the segments with a single command,
+ * or writes them from the segments if "write" is set. At most DISK_MAX_SECTORS_PER_COMMAND sectors or IDEDMA_LBA48_MAX_SECTORS
+ * with an LBA48 command. The segments must be kernel memory, which is mapped to itself.
+ * Kernel threads sleep until the interrupt says the transfer is done. Returns -EINVARG if the segments can't be
+ * used for DMA so the caller can fall back to PIO
+ */
+int idedma_transfer(int channel, bool slave, bool lba48, bool write, unsigned int lba, struct disk_segment *segments, int total_segments);
+
+#endif
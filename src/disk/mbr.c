@@ -0,0 +1,72 @@
+#include "mbr.h"
+#include "disk.h"
+#include "config.h"
+#include "status.h"
+#include <stdbool.h>
+
+/**
+ * Boot sectors carry the same signature so we only trust a table whose every entry makes sense
+ */
+static bool mbr_valid(struct disk *disk, struct mbr *mbr)
+{
+    if (mbr->signature != MBR_SIGNATURE)
+    {
+        return false;
+    }
+
+    for (int i = 0; i < MBR_TOTAL_PARTITIONS; i++)
+    {
+        struct mbr_partition *partition = &mbr->partitions[i];
+        if (partition->status != MBR_STATUS_INACTIVE && partition->status != MBR_STATUS_ACTIVE)
+        {
+            return false;
+        }
+
+        if (partition->type == MBR_TYPE_EMPTY)
+        {
+            continue;
+        }
+
+        // Drives whose size we don't know can't be checked
+        if (partition->lba == 0 || partition->sectors == 0 ||
+            (disk->total_sectors && (partition->lba >= disk->total_sectors || partition->sectors > disk->total_sectors - partition->lba)))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int mbr_scan(struct disk *disk)
+{
+    struct mbr mbr;
+    int res = disk_read_block(disk, 0, 1, &mbr);
+    if (res < 0)
+    {
+        return res;
+    }
+
+    if (!mbr_valid(disk, &mbr))
+    {
+        return -EFSNOTUS;
+    }
+
+    int total = 0;
+    for (int i = 0; i < MBR_TOTAL_PARTITIONS; i++)
+    {
+        struct mbr_partition *partition = &mbr.partitions[i];
+        if (partition->type == MBR_TYPE_EMPTY || partition->type == MBR_TYPE_EXTENDED || partition->type == MBR_TYPE_EXTENDED_LBA)
+        {
+            continue;
+        }
+
+        if (!disk_register_partition(disk, partition->lba, partition->sectors))
+        {
+            break;
+        }
+        total++;
+    }
+
+    return total;
+}
@@ -0,0 +1,44 @@
+#ifndef DISK_MBR_H
+#define DISK_MBR_H
+
+#include <stdint.h>
+
+#define MBR_TOTAL_PARTITIONS 4
+#define MBR_SIGNATURE 0xAA55
+
+// The boot indicator of a partition is one of these, anything else is not a partition table
+#define MBR_STATUS_INACTIVE 0x00
+#define MBR_STATUS_ACTIVE 0x80
+
+#define MBR_TYPE_EMPTY 0x00
+// Extended partitions hold a chain of further partition tables which we don't follow
+#define MBR_TYPE_EXTENDED 0x05
+#define MBR_TYPE_EXTENDED_LBA 0x0F
+
+struct mbr_partition
+{
+    uint8_t status;
+    uint8_t chs_first[3];
+    uint8_t type;
+    uint8_t chs_last[3];
+    uint32_t lba;
+    uint32_t sectors;
+} __attribute__((packed));
+
+// The first sector of a partitioned drive
+struct mbr
+{
+    uint8_t boot_code[446];
+    struct mbr_partition partitions[MBR_TOTAL_PARTITIONS];
+    uint16_t signature;
+} __attribute__((packed));
+
+struct disk;
+
+/**
+ * Adds a disk for each primary partition in the MBR of the given drive. Returns how many were added,
+ * or an error if the first sector can't be read or is not a partition table
+ */
+int mbr_scan(struct disk *disk);
+
+#endif
@@ -0,0 +1,52 @@
+#include "readahead.h"
+#include "cache.h"
+#include "config.h"
+
+void disk_readahead(struct disk *disk, struct disk_readahead *readahead, unsigned int lba, int total)
+{
+    unsigned int end = lba + total;
+    bool sequential = lba >= readahead->start && lba <= readahead->next;
+    readahead->start = lba;
+    readahead->next = end;
+
+    if (!sequential)
+    {
+        // What we read ahead for the old position is probably wasted, be more careful next time
+        readahead->window /= 2;
+        if (readahead->window < COS32_DISK_READAHEAD_MIN_SECTORS)
+        {
+            readahead->window = 0;
+        }
+        readahead->end = end;
+        return;
+    }
+
+    // Still plenty read ahead of the reader, start the next window once half of this one is used
+    if (readahead->window && end + readahead->window / 2 < readahead->end)
+    {
+        return;
+    }
+
+    if (!readahead->window)
+    {
+        readahead->window = COS32_DISK_READAHEAD_MIN_SECTORS;
+    }
+    else if (readahead->end > lba)
+    {
+        // The reader is using what we read ahead, read further next time
+        readahead->window *= 2;
+        if (readahead->window > COS32_DISK_READAHEAD_MAX_SECTORS)
+        {
+            readahead->window = COS32_DISK_READAHEAD_MAX_SECTORS;
+        }
+    }
+
+    unsigned int first = readahead->end > end ? readahead->end : end;
+    unsigned int last = end + readahead->window;
+    readahead->end = last;
+    if (first < last)
+    {
+        // Read ahead is only a hint, if it fails the reader will find out when it reads the sectors itself
+        disk_cache_prefetch(disk, first, last - first);
+    }
+}
@@ -0,0 +1,29 @@
+#ifndef DISK_READAHEAD_H
+#define DISK_READAHEAD_H
+
+struct disk;
+
+// Tracks one reader of a disk so sectors can be read into the cache before a sequential reader asks for them
+struct disk_readahead
+{
+    // The first sector of the last read
+    unsigned int start;
+
+    // The sector following the last read, a read starting between "start" and here is sequential
+    unsigned int next;
+
+    // How many sectors we read ahead of the reader, zero until the reader looks sequential
+    int window;
+
+    // The first sector past what has been read ahead
+    unsigned int end;
+};
+
+/**
+ * Called before "total" sectors starting at "lba" are read for the reader described by "readahead".
+ * Sequential readers have the sectors after the read loaded into the disk cache, the window grows
+ * whilst the reader keeps using what we read ahead and shrinks when the reader jumps elsewhere
+ */
+void disk_readahead(struct disk *disk, struct disk_readahead *readahead, unsigned int lba, int total);
+
+#endif
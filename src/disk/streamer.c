@@ -1,5 +1,6 @@
 #include "streamer.h"
 #include "memory/kheap.h"
+#include "memory/memory.h"
 #include "config.h"
 #include <stdbool.h>
 
@@ -25,41 +26,71 @@ int diskstreamer_seek(struct disk_stream* stream, int position)
 
 int diskstreamer_read(struct disk_stream* stream, void* out, int total)
 {
-    int sector = stream->pos / COS32_SECTOR_SIZE;
-    int offset = stream->pos % COS32_SECTOR_SIZE;
-    int total_to_read = total;
-    bool overflow = (offset+total_to_read) >= COS32_SECTOR_SIZE;
+    return diskstreamer_read_with_readahead(stream, &stream->readahead, out, total);
+}
 
+int diskstreamer_read_with_readahead(struct disk_stream* stream, struct disk_readahead* readahead, void* out, int total)
+{
+    int res = 0;
     char buf[COS32_SECTOR_SIZE];
+    char* ptr = out;
 
-    // If we are going to overflow the buffer then we will need to change the amount we are planning
-    // to read and process the rest later on.
-    if (overflow)
+    if (total > 0)
     {
-        total_to_read -= (offset+total_to_read) - COS32_SECTOR_SIZE;
+        unsigned int first_sector = stream->pos / COS32_SECTOR_SIZE;
+        unsigned int last_sector = (stream->pos + total - 1) / COS32_SECTOR_SIZE;
+        disk_readahead(stream->disk, readahead, first_sector, last_sector - first_sector + 1);
     }
 
-    int res = disk_read_block(stream->disk, sector, 1, buf);
-    if (res < 0)
+    // A read that starts or ends part way through a sector goes through our buffer for that sector
+    int offset = stream->pos % COS32_SECTOR_SIZE;
+    if (total > 0 && (offset || total < COS32_SECTOR_SIZE))
     {
-        goto out;
-    }
+        int amount = COS32_SECTOR_SIZE - offset;
+        if (amount > total)
+        {
+            amount = total;
+        }
 
+        res = disk_read_block(stream->disk, stream->pos / COS32_SECTOR_SIZE, 1, buf);
+        if (res < 0)
+        {
+            goto out;
+        }
 
-    for (int i = 0; i < total_to_read; i++)
+        memcpy(ptr, buf + offset, amount);
+        ptr += amount;
+        stream->pos += amount;
+        total -= amount;
+    }
+
+    // Every whole sector is read straight into the caller's memory with as few commands as possible
+    int sectors = total / COS32_SECTOR_SIZE;
+    if (sectors)
     {
-        *(char*)out++ = buf[offset+i];
+        res = disk_read_block(stream->disk, stream->pos / COS32_SECTOR_SIZE, sectors, ptr);
+        if (res < 0)
+        {
+            goto out;
+        }
+
+        ptr += sectors * COS32_SECTOR_SIZE;
+        stream->pos += sectors * COS32_SECTOR_SIZE;
+        total -= sectors * COS32_SECTOR_SIZE;
     }
 
-    // Adjust stream
-    stream->pos += total_to_read;
-    
-    // Do we have more to read? If we overflowed the sector we do
-    if (overflow)
+    if (total > 0)
     {
-        // However we just read a sector! So we should minus it from the total to read
-        res = diskstreamer_read(stream, out, total-total_to_read);
+        res = disk_read_block(stream->disk, stream->pos / COS32_SECTOR_SIZE, 1, buf);
+        if (res < 0)
+        {
+            goto out;
+        }
+
+        memcpy(ptr, buf, total);
+        stream->pos += total;
     }
+
 out:
     return res;
 }
@@ -2,16 +2,25 @@
 #define DISKSTREAMER_H
 
 #include "disk.h"
+#include "readahead.h"
 
 struct disk_stream
 {
     int pos;
     struct disk* disk;
+
+    // Used when the stream is read with diskstreamer_read
+    struct disk_readahead readahead;
 };
 
 struct disk_stream* diskstreamer_new(int disk_id);
 int diskstreamer_seek(struct disk_stream* stream, int position);
 int diskstreamer_read(struct disk_stream* stream, void* out, int total);
+
+/**
+ * Reads like diskstreamer_read but detects sequential access with "readahead", for streams shared by several readers
+ */
+int diskstreamer_read_with_readahead(struct disk_stream* stream, struct disk_readahead* readahead, void* out, int total);
 void diskstreamer_close(struct disk_stream* stream);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,335 @@
+#include "virtioblk.h"
+#include "disk.h"
+#include "pci/pci.h"
+#include "io/io.h"
+#include "memory/memory.h"
+#include "memory/kheap.h"
+#include "kernel.h"
+#include "status.h"
+
+static int virtio_blk_submit_request(struct disk *disk, struct disk_request *request);
+static void virtio_blk_commit(struct disk *disk);
+static void virtio_blk_poll(void *private);
+
+static struct disk_driver virtio_blk_driver = {
+    .submit = virtio_blk_submit_request,
+    .commit = virtio_blk_commit,
+    .poll = virtio_blk_poll,
+    .max_sectors = VIRTIO_BLK_REQUEST_SECTORS,
+    .max_segments = VIRTIO_BLK_MAX_SEGMENTS,
+    .queue_depth = COS32_VIRTIO_BLK_MAX_REQUESTS,
+    .name = "virtio-blk"};
+
+static uint32_t virtio_align(uint32_t value)
+{
+    return (value + VIRTIO_QUEUE_ALIGNMENT - 1) & ~(VIRTIO_QUEUE_ALIGNMENT - 1);
+}
+
+static uint16_t virtio_blk_alloc_descriptor(struct virtio_blk_device *device)
+{
+    uint16_t index = device->free_head;
+    device->free_head = device->descriptors[index].next;
+    device->total_free--;
+    return index;
+}
+
+/**
+ * Gives every descriptor of the chain starting at "head" back to the free list
+ */
+static void virtio_blk_free_chain(struct virtio_blk_device *device, uint16_t head)
+{
+    uint16_t index = head;
+    while (1)
+    {
+        struct virtio_descriptor *descriptor = &device->descriptors[index];
+        bool last = !(descriptor->flags & VIRTIO_DESCRIPTOR_NEXT);
+        uint16_t next = descriptor->next;
+
+        descriptor->flags = 0;
+        descriptor->next = device->free_head;
+        device->free_head = index;
+        device->total_free++;
+
+        if (last)
+        {
+            break;
+        }
+        index = next;
+    }
+}
+
+static struct virtio_blk_request *virtio_blk_find_request(struct virtio_blk_device *device, uint16_t head)
+{
+    for (int i = 0; i < COS32_VIRTIO_BLK_MAX_REQUESTS; i++)
+    {
+        struct virtio_blk_request *request = &device->requests[i];
+        if (request->used && request->head == head)
+        {
+            return request;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Completes every request the device has finished with since we last looked
+ */
+static void virtio_blk_process_used(struct virtio_blk_device *device)
+{
+    while (device->last_used != *(volatile uint16_t *)&device->used->index)
+    {
+        // The index is written after the element, don't read the element before the index
+        __asm__ __volatile__("" ::: "memory");
+        struct virtio_used_element *element = &device->used->ring[device->last_used % device->queue_size];
+        uint16_t head = element->id;
+        virtio_blk_free_chain(device, head);
+        device->last_used++;
+
+        struct virtio_blk_request *request = virtio_blk_find_request(device, head);
+        if (request)
+        {
+            // Completing the request may give the device another, which can have this one's place
+            request->used = false;
+            disk_request_complete(device->disk, request->request, request->status == VIRTIO_BLK_STATUS_OK ? 0 : -EIO);
+        }
+    }
+}
+
+static void virtio_blk_poll(void *private)
+{
+    virtio_blk_process_used(private);
+}
+
+static void virtio_blk_interrupt(void *private)
+{
+    struct virtio_blk_device *device = private;
+
+    // Reading the ISR status lowers the device's interrupt, it's zero if another device on the line interrupted
+    uint8_t status = insb(device->io_base + VIRTIO_REGISTER_ISR_STATUS);
+    if (status & VIRTIO_ISR_QUEUE)
+    {
+        virtio_blk_process_used(device);
+    }
+}
+
+struct virtio_blk_request *virtio_blk_submit(struct virtio_blk_device *device, bool write, unsigned int lba, struct disk_segment *segments, int total_segments)
+{
+    if (total_segments <= 0 || total_segments > device->max_segments)
+    {
+        return ERROR(-EINVARG);
+    }
+
+    // The header and the status take a descriptor each
+    if (device->total_free < total_segments + 2)
+    {
+        return ERROR(-ENOMEM);
+    }
+
+    struct virtio_blk_request *request = 0;
+    for (int i = 0; i < COS32_VIRTIO_BLK_MAX_REQUESTS; i++)
+    {
+        if (!device->requests[i].used)
+        {
+            request = &device->requests[i];
+            break;
+        }
+    }
+
+    if (!request)
+    {
+        return ERROR(-ENOMEM);
+    }
+
+    request->used = true;
+    request->request = 0;
+    request->status = 0xFF;
+    request->header.type = write ? VIRTIO_BLK_REQUEST_OUT : VIRTIO_BLK_REQUEST_IN;
+    request->header.reserved = 0;
+    request->header.sector = lba;
+
+    // The kernel maps every address to itself so our addresses are the ones the device needs
+    uint16_t head = virtio_blk_alloc_descriptor(device);
+    struct virtio_descriptor *descriptor = &device->descriptors[head];
+    descriptor->address = (uint32_t)&request->header;
+    descriptor->length = sizeof(request->header);
+    descriptor->flags = VIRTIO_DESCRIPTOR_NEXT;
+
+    for (int i = 0; i < total_segments; i++)
+    {
+        uint16_t index = virtio_blk_alloc_descriptor(device);
+        descriptor->next = index;
+        descriptor = &device->descriptors[index];
+        descriptor->address = (uint32_t)segments[i].buf;
+        descriptor->length = segments[i].sectors * COS32_SECTOR_SIZE;
+        // The device only reads the memory of a write
+        descriptor->flags = (write ? 0 : VIRTIO_DESCRIPTOR_WRITE) | VIRTIO_DESCRIPTOR_NEXT;
+    }
+
+    uint16_t index = virtio_blk_alloc_descriptor(device);
+    descriptor->next = index;
+    descriptor = &device->descriptors[index];
+    descriptor->address = (uint32_t)&request->status;
+    descriptor->length = sizeof(request->status);
+    descriptor->flags = VIRTIO_DESCRIPTOR_WRITE;
+
+    request->head = head;
+    device->available->ring[device->available->index % device->queue_size] = head;
+
+    // The device must see the ring entry before the index that makes it visible
+    __asm__ __volatile__("" ::: "memory");
+    device->available->index++;
+    return request;
+}
+
+void virtio_blk_notify(struct virtio_blk_device *device)
+{
+    __asm__ __volatile__("" ::: "memory");
+    outw(device->io_base + VIRTIO_REGISTER_QUEUE_NOTIFY, 0);
+}
+
+static int virtio_blk_submit_request(struct disk *disk, struct disk_request *request)
+{
+    struct virtio_blk_device *device = disk->driver_private;
+    struct disk_segment segments[VIRTIO_BLK_MAX_SEGMENTS];
+    int total = disk_request_segments(request, segments, VIRTIO_BLK_MAX_SEGMENTS);
+    if (total < 0)
+    {
+        return total;
+    }
+
+    // The device isn't told about it until the queue commits so it can't complete before we know which request it is
+    struct virtio_blk_request *virtio_request = virtio_blk_submit(device, request->write, request->lba, segments, total);
+    if (ISERR(virtio_request))
+    {
+        return ERROR_I(virtio_request);
+    }
+
+    virtio_request->request = request;
+    return 0;
+}
+
+static void virtio_blk_commit(struct disk *disk)
+{
+    virtio_blk_notify(disk->driver_private);
+}
+
+static int virtio_blk_queue_init(struct virtio_blk_device *device)
+{
+    outw(device->io_base + VIRTIO_REGISTER_QUEUE_SELECT, 0);
+    device->queue_size = insw(device->io_base + VIRTIO_REGISTER_QUEUE_SIZE);
+    if (!device->queue_size)
+    {
+        return -EIO;
+    }
+
+    uint32_t available_offset = sizeof(struct virtio_descriptor) * device->queue_size;
+    uint32_t used_offset = virtio_align(available_offset + sizeof(uint16_t) * (3 + device->queue_size));
+    uint32_t size = used_offset + virtio_align(sizeof(uint16_t) * 3 + sizeof(struct virtio_used_element) * device->queue_size);
+
+    // Kernel heap allocations start on a page which is the alignment the device needs
+    device->queue = kzalloc(size);
+    if (!device->queue)
+    {
+        return -ENOMEM;
+    }
+
+    ASSERT(((uint32_t)device->queue % VIRTIO_QUEUE_ALIGNMENT) == 0);
+    device->descriptors = device->queue;
+    device->available = device->queue + available_offset;
+    device->used = device->queue + used_offset;
+
+    for (int i = 0; i < device->queue_size; i++)
+    {
+        device->descriptors[i].next = i + 1;
+    }
+    device->free_head = 0;
+    device->total_free = device->queue_size;
+    device->last_used = 0;
+
+    outl(device->io_base + VIRTIO_REGISTER_QUEUE_ADDRESS, (uint32_t)device->queue / VIRTIO_QUEUE_ALIGNMENT);
+    return 0;
+}
+
+static int virtio_blk_device_init(struct pci_device *pci)
+{
+    int res = 0;
+    struct virtio_blk_device *device = 0;
+    if (!pci_bar_is_io(pci, VIRTIO_BAR_IO))
+    {
+        res = -EIO;
+        goto out;
+    }
+
+    device = kzalloc(sizeof(struct virtio_blk_device));
+    if (!device)
+    {
+        res = -ENOMEM;
+        goto out;
+    }
+
+    device->io_base = pci_bar(pci, VIRTIO_BAR_IO);
+    pci_enable_bus_master(pci);
+
+    // Writing zero resets the device, then we say we have found it and know how to drive it
+    outb(device->io_base + VIRTIO_REGISTER_DEVICE_STATUS, 0);
+    outb(device->io_base + VIRTIO_REGISTER_DEVICE_STATUS, VIRTIO_STATUS_ACKNOWLEDGE);
+    outb(device->io_base + VIRTIO_REGISTER_DEVICE_STATUS, VIRTIO_STATUS_ACKNOWLEDGE | VIRTIO_STATUS_DRIVER);
+
+    uint32_t features = insl(device->io_base + VIRTIO_REGISTER_DEVICE_FEATURES) & VIRTIO_BLK_FEATURE_SEG_MAX;
+    outl(device->io_base + VIRTIO_REGISTER_GUEST_FEATURES, features);
+
+    device->max_segments = 1;
+    if (features & VIRTIO_BLK_FEATURE_SEG_MAX)
+    {
+        uint32_t max_segments = insl(device->io_base + VIRTIO_BLK_REGISTER_SEG_MAX);
+        device->max_segments = max_segments > VIRTIO_BLK_MAX_SEGMENTS ? VIRTIO_BLK_MAX_SEGMENTS : max_segments;
+        if (device->max_segments < 1)
+        {
+            device->max_segments = 1;
+        }
+    }
+
+    device->capacity = insl(device->io_base + VIRTIO_BLK_REGISTER_CAPACITY);
+    device->capacity |= (uint64_t)insl(device->io_base + VIRTIO_BLK_REGISTER_CAPACITY + sizeof(uint32_t)) << 32;
+
+    res = virtio_blk_queue_init(device);
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    // Without the interrupt everyone polls the used ring for their completions
+    bool polled = pci_register_interrupt(pci, virtio_blk_interrupt, device) < 0;
+
+    device->disk = disk_register(&virtio_blk_driver, device);
+    if (!device->disk)
+    {
+        res = -ENOMEM;
+        goto out;
+    }
+    device->disk->polled = polled;
+    device->disk->queue.max_segments = device->max_segments;
+    device->disk->total_sectors = device->capacity > 0xFFFFFFFF ? 0xFFFFFFFF : device->capacity;
+
+    outb(device->io_base + VIRTIO_REGISTER_DEVICE_STATUS, VIRTIO_STATUS_ACKNOWLEDGE | VIRTIO_STATUS_DRIVER | VIRTIO_STATUS_DRIVER_OK);
+
+out:
+    if (ISERR(res) && device)
+    {
+        outb(device->io_base + VIRTIO_REGISTER_DEVICE_STATUS, VIRTIO_STATUS_FAILED);
+        kfree(device->queue);
+        kfree(device);
+    }
+    return res;
+}
+
+void virtio_blk_init()
+{
+    int index = pci_find_device(VIRTIO_VENDOR_ID, VIRTIO_BLK_DEVICE_ID_LEGACY, -1);
+    while (index >= 0)
+    {
+        virtio_blk_device_init(pci_get(index));
+        index = pci_find_device(VIRTIO_VENDOR_ID, VIRTIO_BLK_DEVICE_ID_LEGACY, index);
+    }
+}
@@ -0,0 +1,156 @@
+#ifndef DISK_VIRTIOBLK_H
+#define DISK_VIRTIOBLK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+
+// Block devices speaking the legacy interface, which QEMU offers unless told otherwise
+#define VIRTIO_VENDOR_ID 0x1AF4
+#define VIRTIO_BLK_DEVICE_ID_LEGACY 0x1001
+
+// The legacy registers are in the I/O space of BAR0
+#define VIRTIO_BAR_IO 0
+#define VIRTIO_REGISTER_DEVICE_FEATURES 0x00
+#define VIRTIO_REGISTER_GUEST_FEATURES 0x04
+#define VIRTIO_REGISTER_QUEUE_ADDRESS 0x08
+#define VIRTIO_REGISTER_QUEUE_SIZE 0x0C
+#define VIRTIO_REGISTER_QUEUE_SELECT 0x0E
+#define VIRTIO_REGISTER_QUEUE_NOTIFY 0x10
+#define VIRTIO_REGISTER_DEVICE_STATUS 0x12
+#define VIRTIO_REGISTER_ISR_STATUS 0x13
+
+// The block device configuration follows the common registers when MSI-X is off
+#define VIRTIO_BLK_REGISTER_CAPACITY 0x14
+#define VIRTIO_BLK_REGISTER_SEG_MAX 0x20
+
+#define VIRTIO_STATUS_ACKNOWLEDGE 0x01
+#define VIRTIO_STATUS_DRIVER 0x02
+#define VIRTIO_STATUS_DRIVER_OK 0x04
+#define VIRTIO_STATUS_FAILED 0x80
+
+// Set in the ISR status when the device has used buffers from a queue
+#define VIRTIO_ISR_QUEUE 0x01
+
+// The device tells us the most data segments a request may have
+#define VIRTIO_BLK_FEATURE_SEG_MAX (1 << 2)
+
+// The legacy interface takes the page number of the queue and the used ring must start on a page
+#define VIRTIO_QUEUE_ALIGNMENT 4096
+
+#define VIRTIO_DESCRIPTOR_NEXT 0x01
+// The device writes to the buffer rather than reading it
+#define VIRTIO_DESCRIPTOR_WRITE 0x02
+
+#define VIRTIO_BLK_REQUEST_IN 0
+#define VIRTIO_BLK_REQUEST_OUT 1
+#define VIRTIO_BLK_STATUS_OK 0
+
+// The most sectors we ask for in one request
+#define VIRTIO_BLK_REQUEST_SECTORS 128
+
+// The most data segments a request may have regardless of what the device allows
+#define VIRTIO_BLK_MAX_SEGMENTS 16
+
+struct virtio_descriptor
+{
+    uint64_t address;
+    uint32_t length;
+    uint16_t flags;
+    uint16_t next;
+} __attribute__((packed));
+
+// Buffers we have given the device, "ring" is followed by the queue size entries
+struct virtio_available
+{
+    uint16_t flags;
+    uint16_t index;
+    uint16_t ring[];
+} __attribute__((packed));
+
+struct virtio_used_element
+{
+    // The first descriptor of the buffer the device has finished with
+    uint32_t id;
+    uint32_t length;
+} __attribute__((packed));
+
+// Buffers the device has given back to us
+struct virtio_used
+{
+    uint16_t flags;
+    uint16_t index;
+    struct virtio_used_element ring[];
+} __attribute__((packed));
+
+struct virtio_blk_request_header
+{
+    uint32_t type;
+    uint32_t reserved;
+    uint64_t sector;
+} __attribute__((packed));
+
+struct disk;
+struct disk_request;
+struct disk_segment;
+
+struct virtio_blk_request
+{
+    // The device reads the header and writes the status, both must stay where they are until the request completes
+    struct virtio_blk_request_header header;
+    uint8_t status;
+
+    bool used;
+
+    // The first descriptor of the chain given to the device
+    uint16_t head;
+
+    // The request of the disk's queue we are carrying out
+    struct disk_request *request;
+};
+
+struct virtio_blk_device
+{
+    struct disk *disk;
+    uint16_t io_base;
+
+    // The size of the sectors read is always 512 bytes whatever the block size of the device
+    uint64_t capacity;
+
+    // The most data segments a single request may have
+    int max_segments;
+
+    uint16_t queue_size;
+    void *queue;
+    struct virtio_descriptor *descriptors;
+    struct virtio_available *available;
+    struct virtio_used *used;
+
+    // Free descriptors are chained through their "next" field
+    uint16_t free_head;
+    int total_free;
+
+    // The used ring entries we have already handled
+    uint16_t last_used;
+
+    struct virtio_blk_request requests[COS32_VIRTIO_BLK_MAX_REQUESTS];
+};
+
+/**
+ * Finds every virtio block device on the PCI buses and registers a disk for each one
+ */
+void virtio_blk_init();
+
+/**
+ * Gives the device a request to read the sectors starting at "lba" into the given segments or write them from the segments, the device
+ * is not told until virtio_blk_notify is called so several requests can be given at once.
+ * The disk's request is completed when the device is done. Returns an error if there are no free requests or descriptors
+ */
+struct virtio_blk_request *virtio_blk_submit(struct virtio_blk_device *device, bool write, unsigned int lba, struct disk_segment *segments, int total_segments);
+
+/**
+ * Tells the device there are new requests
+ */
+void virtio_blk_notify(struct virtio_blk_device *device);
+
+#endif
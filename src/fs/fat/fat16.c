@@ -2,6 +2,7 @@
 #include "memory/memory.h"
 #include "memory/kheap.h"
 #include "disk/streamer.h"
+#include "disk/cache.h"
 #include "string/string.h"
 #include "kernel.h"
 #include "status.h"
@@ -101,6 +102,9 @@ struct fat_file_descriptor
 {
     struct fat_item *item;
     uint32_t pos;
+
+    // Every open file shares the cluster stream so each tracks its own access pattern
+    struct disk_readahead readahead;
 };
 
 struct fat_private
@@ -303,7 +307,7 @@ out:
     return res;
 }
 
-static int fat16_read_internal_from_stream(struct disk *disk, struct disk_stream *stream, int cluster, int offset, int total, void *out)
+static int fat16_read_internal_from_stream(struct disk *disk, struct disk_stream *stream, struct disk_readahead *readahead, int cluster, int offset, int total, void *out)
 {
     int res = 0;
     struct fat_private *private = disk->fs_private;
@@ -326,7 +330,7 @@ static int fat16_read_internal_from_stream(struct disk *disk, struct disk_stream
         goto out;
     }
 
-    res = diskstreamer_read(stream, out, total_to_read);
+    res = diskstreamer_read_with_readahead(stream, readahead, out, total_to_read);
     if (res != COS32_ALL_OK)
     {
         goto out;
@@ -336,7 +340,7 @@ static int fat16_read_internal_from_stream(struct disk *disk, struct disk_stream
     if (total > 0)
     {
         // We have more to go lets get the next cluster from fat
-        res = fat16_read_internal_from_stream(disk, stream, cluster, offset + total_to_read, total, out + total_to_read);
+        res = fat16_read_internal_from_stream(disk, stream, readahead, cluster, offset + total_to_read, total, out + total_to_read);
     }
 
 out:
@@ -344,14 +348,68 @@ out:
     return res;
 }
 
+/**
+ * Starts reading every cluster a read touches so the disk can work on them together whilst we copy the first.
+ * Only a hint, the read finds out about any failure itself
+ */
+static void fat16_start_read(struct disk *disk, int starting_cluster, int offset, int total)
+{
+    struct fat_private *private = disk->fs_private;
+    int size_of_cluster_bytes = private->header.primary_header.sectors_per_cluster * COS32_SECTOR_SIZE;
+    int offset_from_cluster = offset % size_of_cluster_bytes;
+    if (offset_from_cluster + total <= size_of_cluster_bytes)
+    {
+        // A single cluster is read in one go anyway
+        return;
+    }
+
+    if (total > COS32_FAT16_ASYNC_READ_MAX_BYTES)
+    {
+        total = COS32_FAT16_ASYNC_READ_MAX_BYTES;
+    }
+
+    int cluster = fat16_get_cluster_for_offset(disk, starting_cluster, offset);
+    disk_plug(disk);
+    while (cluster >= 2 && cluster < COS32_FAT16_BAD_SECTOR && total > 0)
+    {
+        int amount = size_of_cluster_bytes - offset_from_cluster;
+        if (amount > total)
+        {
+            amount = total;
+        }
+
+        unsigned int lba = fat16_cluster_to_sector(private, cluster) + offset_from_cluster / COS32_SECTOR_SIZE;
+        int sectors = (offset_from_cluster % COS32_SECTOR_SIZE + amount + COS32_SECTOR_SIZE - 1) / COS32_SECTOR_SIZE;
+        if (disk_cache_read_async(disk, lba, sectors) < 0)
+        {
+            break;
+        }
+
+        total -= amount;
+        offset_from_cluster = 0;
+        if (total > 0)
+        {
+            cluster = fat16_get_fat_entry(disk, cluster);
+        }
+    }
+    disk_unplug(disk);
+}
+
 /*
  * Reads from the cluster, if reading overlaps then the next cluster is used
  */
-static int fat16_read_internal(struct disk *disk, int starting_cluster, int offset, int total, void *out)
+static int fat16_read_internal(struct disk *disk, struct disk_readahead *readahead, int starting_cluster, int offset, int total, void *out)
 {
     struct fat_private* fs_private = disk->fs_private;
     struct disk_stream *stream = fs_private->cluster_read_stream;
-    int res = fat16_read_internal_from_stream(disk, stream, starting_cluster, offset, total, out);
+    if (!readahead)
+    {
+        // Readers that don't track themselves share the state of the stream
+        readahead = &stream->readahead;
+    }
+
+    fat16_start_read(disk, starting_cluster, offset, total);
+    int res = fat16_read_internal_from_stream(disk, stream, readahead, starting_cluster, offset, total, out);
     return res;
 }
 
@@ -364,7 +422,7 @@ int fat16_read(struct disk *disk, void *descriptor, uint32_t size, uint32_t nmem
     int offset = fat_desc->pos;
     for (uint32_t i = 0; i < nmemb; i++)
     {
-        res = fat16_read_internal(disk, fat16_get_first_cluster(item), offset, size, out_ptr);
+        res = fat16_read_internal(disk, &fat_desc->readahead, fat16_get_first_cluster(item), offset, size, out_ptr);
         if (ISERR(res))
         {
             goto out;
@@ -662,7 +720,7 @@ struct fat_directory *fat16_load_fat_directory(struct disk *disk, struct fat_dir
         goto out;
     }
 
-    res = fat16_read_internal(disk, cluster, 0x00, directory_size, directory->item);
+    res = fat16_read_internal(disk, 0, cluster, 0x00, directory_size, directory->item);
     if (res != COS32_ALL_OK)
     {
         goto out;
@@ -0,0 +1,80 @@
+#include "controller.h"
+#include "controllers/apic.h"
+#include "controllers/pic.h"
+#include "config.h"
+#include "kernel.h"
+#include "memory/memory.h"
+
+static struct interrupt_controller *controllers[COS32_MAX_INTERRUPT_CONTROLLERS];
+
+// The interrupt controller that delivers our hardware interrupts
+static struct interrupt_controller *controller = 0;
+
+void interrupt_controller_insert(struct interrupt_controller *new_controller)
+{
+    for (int i = 0; i < COS32_MAX_INTERRUPT_CONTROLLERS; i++)
+    {
+        if (controllers[i] == 0)
+        {
+            controllers[i] = new_controller;
+            return;
+        }
+    }
+
+    panic("No more interrupt controller slots available, failed to register interrupt controller\n");
+}
+
+void interrupt_controller_init()
+{
+    memset(controllers, 0, sizeof(controllers));
+    interrupt_controller_insert(apic_init());
+    interrupt_controller_insert(pic_init());
+
+    for (int i = 0; i < COS32_MAX_INTERRUPT_CONTROLLERS; i++)
+    {
+        if (controllers[i] != 0 && controllers[i]->init() == 0)
+        {
+            controller = controllers[i];
+            break;
+        }
+    }
+
+    if (!controller)
+    {
+        panic("No interrupt controller could be initialized\n");
+    }
+
+    print("Interrupt controller: ");
+    print(controller->name);
+    print("\n");
+}
+
+struct interrupt_controller *interrupt_controller_current()
+{
+    return controller;
+}
+
+void interrupt_controller_eoi(int interrupt)
+{
+    controller->eoi(interrupt);
+}
+
+void interrupt_controller_enable_irq(int irq)
+{
+    controller->enable_irq(irq);
+}
+
+int interrupt_controller_enable_pci_irq(int irq)
+{
+    return controller->enable_pci_irq(irq);
+}
+
+bool interrupt_controller_has_timer()
+{
+    return controller->timer != 0;
+}
+
+void interrupt_controller_timer(uint32_t millis, bool periodic)
+{
+    controller->timer(millis, periodic);
+}
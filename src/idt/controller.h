@@ -0,0 +1,97 @@
+#ifndef INTERRUPT_CONTROLLER_H
+#define INTERRUPT_CONTROLLER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Hardware interrupts are mapped just after the intel exceptions
+#define INTERRUPT_CONTROLLER_IRQ_BASE 0x20
+#define INTERRUPT_CONTROLLER_TOTAL_IRQS 16
+
+// Legacy ISA IRQ numbers
+#define INTERRUPT_CONTROLLER_IRQ_TIMER 0
+#define INTERRUPT_CONTROLLER_IRQ_KEYBOARD 1
+
+/**
+ * Returns zero if the controller is present and is now handling interrupts
+ */
+typedef int (*INTERRUPT_CONTROLLER_INIT_FUNCTION)();
+
+/**
+ * Acknowledges the given interrupt so the controller can deliver the next one
+ */
+typedef void (*INTERRUPT_CONTROLLER_EOI_FUNCTION)(int interrupt);
+
+/**
+ * Unmasks the legacy ISA IRQ so it raises interrupt INTERRUPT_CONTROLLER_IRQ_BASE + irq
+ */
+typedef void (*INTERRUPT_CONTROLLER_IRQ_FUNCTION)(int irq);
+
+/**
+ * Unmasks the legacy IRQ a PCI device's interrupt pin is routed to. PCI interrupts are level triggered and active low
+ * unless the firmware overrides the IRQ. Returns an error if the IRQ can't be routed to us
+ */
+typedef int (*INTERRUPT_CONTROLLER_PCI_IRQ_FUNCTION)(int irq);
+
+/**
+ * Raises ISR_TIMER_INTERRUPT after "millis" milliseconds, again and again if "periodic" is true
+ */
+typedef void (*INTERRUPT_CONTROLLER_TIMER_FUNCTION)(uint32_t millis, bool periodic);
+
+struct interrupt_controller
+{
+    INTERRUPT_CONTROLLER_INIT_FUNCTION init;
+    INTERRUPT_CONTROLLER_EOI_FUNCTION eoi;
+    INTERRUPT_CONTROLLER_IRQ_FUNCTION enable_irq;
+    INTERRUPT_CONTROLLER_PCI_IRQ_FUNCTION enable_pci_irq;
+
+    // Optional, if NULL the PIT is used as the timer
+    INTERRUPT_CONTROLLER_TIMER_FUNCTION timer;
+
+    // The longest the timer can be programmed for
+    uint32_t timer_max_ms;
+
+    char name[20];
+};
+
+/**
+ * Initializes the best interrupt controller available, the legacy PIC is used when there is no APIC
+ */
+void interrupt_controller_init();
+
+/**
+ * Adds a new interrupt controller backend, backends inserted first are preferred
+ */
+void interrupt_controller_insert(struct interrupt_controller *controller);
+
+/**
+ * Returns the interrupt controller in use
+ */
+struct interrupt_controller *interrupt_controller_current();
+
+/**
+ * Acknowledges the given interrupt, interrupts that were not raised by the controller are ignored
+ */
+void interrupt_controller_eoi(int interrupt);
+
+/**
+ * Allows the given legacy ISA IRQ to interrupt us
+ */
+void interrupt_controller_enable_irq(int irq);
+
+/**
+ * Allows the legacy IRQ a PCI device's interrupt pin is routed to to interrupt us, returns an error if it can't be routed
+ */
+int interrupt_controller_enable_pci_irq(int irq);
+
+/**
+ * Returns true if the controller has its own timer to replace the PIT
+ */
+bool interrupt_controller_has_timer();
+
+/**
+ * Programs the controller's timer, only valid if interrupt_controller_has_timer returns true
+ */
+void interrupt_controller_timer(uint32_t millis, bool periodic);
+
+#endif
@@ -0,0 +1,237 @@
+#include "apic.h"
+#include "pic.h"
+#include "idt/controller.h"
+#include "idt/idt.h"
+#include "acpi/acpi.h"
+#include "cpu/cpu.h"
+#include "timer/pit.h"
+#include "config.h"
+#include "status.h"
+
+static int apic_init_controller();
+static void apic_eoi(int interrupt);
+static void apic_enable_irq(int irq);
+static int apic_enable_pci_irq(int irq);
+static void apic_timer(uint32_t millis, bool periodic);
+
+static struct interrupt_controller apic_controller = {
+    .init = apic_init_controller,
+    .eoi = apic_eoi,
+    .enable_irq = apic_enable_irq,
+    .enable_pci_irq = apic_enable_pci_irq,
+    .timer = apic_timer,
+    .timer_max_ms = 0,
+    .name = "apic"};
+
+static uint32_t local_apic_address = 0;
+static uint32_t io_apic_address = 0;
+
+// The inputs of the I/O APIC, GSIs beyond them are on an I/O APIC we don't drive
+static uint32_t io_apic_total_redirections = 0;
+
+// Local APIC timer ticks in one millisecond with the divider we use
+static uint32_t timer_ticks_per_ms = 0;
+
+struct interrupt_controller *apic_init()
+{
+    return &apic_controller;
+}
+
+static uint32_t apic_read(uint32_t reg)
+{
+    return *(volatile uint32_t *)(local_apic_address + reg);
+}
+
+static void apic_write(uint32_t reg, uint32_t value)
+{
+    *(volatile uint32_t *)(local_apic_address + reg) = value;
+}
+
+static uint32_t io_apic_read(uint32_t reg)
+{
+    *(volatile uint32_t *)(io_apic_address + IO_APIC_REGISTER_SELECT) = reg;
+    return *(volatile uint32_t *)(io_apic_address + IO_APIC_REGISTER_WINDOW);
+}
+
+static void io_apic_write(uint32_t reg, uint32_t value)
+{
+    *(volatile uint32_t *)(io_apic_address + IO_APIC_REGISTER_SELECT) = reg;
+    *(volatile uint32_t *)(io_apic_address + IO_APIC_REGISTER_WINDOW) = value;
+}
+
+int apic_id()
+{
+    return apic_read(APIC_REGISTER_ID) >> 24;
+}
+
+/**
+ * Counts the local APIC timer ticks whilst the PIT waits for a known time
+ */
+static int apic_calibrate_timer()
+{
+    apic_write(APIC_REGISTER_TIMER_DIVIDE, APIC_TIMER_DIVIDE_16);
+    apic_write(APIC_REGISTER_LVT_TIMER, APIC_LVT_MASKED | ISR_TIMER_INTERRUPT);
+    apic_write(APIC_REGISTER_TIMER_INITIAL_COUNT, 0xFFFFFFFF);
+    pit_busy_wait(APIC_TIMER_CALIBRATION_MS);
+    uint32_t elapsed = 0xFFFFFFFF - apic_read(APIC_REGISTER_TIMER_CURRENT_COUNT);
+    apic_write(APIC_REGISTER_TIMER_INITIAL_COUNT, 0);
+
+    timer_ticks_per_ms = elapsed / APIC_TIMER_CALIBRATION_MS;
+    if (timer_ticks_per_ms == 0)
+    {
+        return -EIO;
+    }
+
+    apic_controller.timer_max_ms = 0xFFFFFFFF / timer_ticks_per_ms;
+    return 0;
+}
+
+/**
+ * Enables the local APIC of the processor we are running on
+ */
+static void apic_enable_local()
+{
+    cpu_write_msr(CPU_MSR_APIC_BASE, cpu_read_msr(CPU_MSR_APIC_BASE) | CPU_MSR_APIC_BASE_ENABLE);
+    apic_write(APIC_REGISTER_TPR, 0);
+    apic_write(APIC_REGISTER_SPURIOUS, APIC_SPURIOUS_VECTOR | APIC_SOFTWARE_ENABLE);
+}
+
+static int apic_init_controller()
+{
+    int res = 0;
+    if (!COS32_APIC_ENABLED || !cpu_has_features_edx(CPU_FEATURE_EDX_APIC | CPU_FEATURE_EDX_MSR))
+    {
+        res = -EIO;
+        goto out;
+    }
+
+    res = acpi_init();
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    struct acpi_madt_info *info = acpi_madt_info();
+    local_apic_address = info->local_apic_address;
+    io_apic_address = info->io_apic_address;
+
+    apic_enable_local();
+
+    res = apic_calibrate_timer();
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    // Only now that we can't fail do we take over from the PIC
+    pic_disable();
+
+    // Every IRQ is masked until a driver asks for it
+    io_apic_total_redirections = ((io_apic_read(IO_APIC_REGISTER_VERSION) >> 16) & 0xff) + 1;
+    for (uint32_t i = 0; i < io_apic_total_redirections; i++)
+    {
+        io_apic_write(IO_APIC_REGISTER_REDIRECTION + i * 2, IO_APIC_REDIRECTION_MASKED);
+        io_apic_write(IO_APIC_REGISTER_REDIRECTION + i * 2 + 1, 0);
+    }
+
+out:
+    return res;
+}
+
+static void apic_eoi(int interrupt)
+{
+    // Spurious interrupts must not be acknowledged, interrupts from other processors must
+    bool irq = interrupt >= INTERRUPT_CONTROLLER_IRQ_BASE && interrupt < INTERRUPT_CONTROLLER_IRQ_BASE + INTERRUPT_CONTROLLER_TOTAL_IRQS;
+    if (!irq && interrupt != ISR_RESCHEDULE_INTERRUPT)
+    {
+        return;
+    }
+
+    apic_write(APIC_REGISTER_EOI, 0);
+}
+
+/**
+ * Routes the legacy IRQ to the processor calling us. "bus_flags" are the polarity and trigger mode of the bus the IRQ is on,
+ * they are used wherever the firmware's override leaves the IRQ conforming to its bus.
+ * Returns -EIO if the IRQ's GSI isn't on our I/O APIC
+ */
+static int apic_route_irq(int irq, uint16_t bus_flags)
+{
+    struct acpi_madt_info *info = acpi_madt_info();
+    struct acpi_isa_irq *isa_irq = &info->isa_irqs[irq];
+    if (isa_irq->gsi < info->io_apic_gsi_base || isa_irq->gsi - info->io_apic_gsi_base >= io_apic_total_redirections)
+    {
+        return -EIO;
+    }
+
+    uint16_t polarity = isa_irq->flags & ACPI_INTERRUPT_POLARITY_MASK;
+    if (!polarity)
+    {
+        polarity = bus_flags & ACPI_INTERRUPT_POLARITY_MASK;
+    }
+
+    uint16_t trigger = isa_irq->flags & ACPI_INTERRUPT_TRIGGER_MASK;
+    if (!trigger)
+    {
+        trigger = bus_flags & ACPI_INTERRUPT_TRIGGER_MASK;
+    }
+
+    uint32_t redirection = INTERRUPT_CONTROLLER_IRQ_BASE + irq;
+    if (polarity == ACPI_INTERRUPT_POLARITY_LOW)
+    {
+        redirection |= IO_APIC_REDIRECTION_ACTIVE_LOW;
+    }
+
+    if (trigger == ACPI_INTERRUPT_TRIGGER_LEVEL)
+    {
+        redirection |= IO_APIC_REDIRECTION_LEVEL;
+    }
+
+    uint32_t entry = isa_irq->gsi - info->io_apic_gsi_base;
+    io_apic_write(IO_APIC_REGISTER_REDIRECTION + entry * 2 + 1, apic_id() << 24);
+    io_apic_write(IO_APIC_REGISTER_REDIRECTION + entry * 2, redirection);
+    return 0;
+}
+
+static void apic_enable_irq(int irq)
+{
+    // ISA interrupts are edge triggered and active high
+    apic_route_irq(irq, 0);
+}
+
+static int apic_enable_pci_irq(int irq)
+{
+    return apic_route_irq(irq, ACPI_INTERRUPT_POLARITY_LOW | ACPI_INTERRUPT_TRIGGER_LEVEL);
+}
+
+static void apic_timer(uint32_t millis, bool periodic)
+{
+    if (millis > apic_controller.timer_max_ms)
+    {
+        millis = apic_controller.timer_max_ms;
+    }
+
+    apic_write(APIC_REGISTER_TIMER_DIVIDE, APIC_TIMER_DIVIDE_16);
+    apic_write(APIC_REGISTER_LVT_TIMER, ISR_TIMER_INTERRUPT | (periodic ? APIC_LVT_TIMER_PERIODIC : 0));
+    apic_write(APIC_REGISTER_TIMER_INITIAL_COUNT, millis * timer_ticks_per_ms);
+}
+
+bool apic_in_use()
+{
+    return interrupt_controller_current() == &apic_controller;
+}
+
+void apic_init_secondary()
+{
+    // Every local APIC runs from the same bus clock so the boot processor's timer calibration holds
+    apic_enable_local();
+}
+
+void apic_send_ipi(int apic_id, uint32_t command)
+{
+    apic_write(APIC_REGISTER_ICR_HIGH, apic_id << 24);
+    apic_write(APIC_REGISTER_ICR_LOW, command);
+    while (apic_read(APIC_REGISTER_ICR_LOW) & APIC_ICR_DELIVERY_PENDING)
+    {
+    }
+}
@@ -0,0 +1,64 @@
+#ifndef APIC_H
+#define APIC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Local APIC registers, offsets from the local APIC base address
+#define APIC_REGISTER_ID 0x20
+#define APIC_REGISTER_TPR 0x80
+#define APIC_REGISTER_EOI 0xB0
+#define APIC_REGISTER_SPURIOUS 0xF0
+#define APIC_REGISTER_ICR_LOW 0x300
+#define APIC_REGISTER_ICR_HIGH 0x310
+#define APIC_REGISTER_LVT_TIMER 0x320
+#define APIC_REGISTER_TIMER_INITIAL_COUNT 0x380
+#define APIC_REGISTER_TIMER_CURRENT_COUNT 0x390
+#define APIC_REGISTER_TIMER_DIVIDE 0x3E0
+
+#define APIC_SPURIOUS_VECTOR 0xFF
+#define APIC_SOFTWARE_ENABLE 0x100
+#define APIC_LVT_MASKED 0x10000
+#define APIC_LVT_TIMER_PERIODIC 0x20000
+// Set in the low interrupt command register whilst an IPI is still being sent
+#define APIC_ICR_DELIVERY_PENDING 0x1000
+// Divides the bus clock by 16 before it reaches the timer
+#define APIC_TIMER_DIVIDE_16 0x03
+#define APIC_TIMER_CALIBRATION_MS 10
+
+// IOAPIC registers are reached through a select register and a data window
+#define IO_APIC_REGISTER_SELECT 0x00
+#define IO_APIC_REGISTER_WINDOW 0x10
+#define IO_APIC_REGISTER_VERSION 0x01
+#define IO_APIC_REGISTER_REDIRECTION 0x10
+
+#define IO_APIC_REDIRECTION_ACTIVE_LOW 0x2000
+#define IO_APIC_REDIRECTION_LEVEL 0x8000
+#define IO_APIC_REDIRECTION_MASKED 0x10000
+
+/**
+ * The local APIC and IOAPIC found through the ACPI MADT, the local APIC timer replaces the PIT
+ */
+struct interrupt_controller *apic_init();
+
+/**
+ * Returns the local APIC id of the processor we are running on
+ */
+int apic_id();
+
+/**
+ * Returns true if the APIC is our interrupt controller
+ */
+bool apic_in_use();
+
+/**
+ * Enables the local APIC of the application processor we are running on
+ */
+void apic_init_secondary();
+
+/**
+ * Sends an inter processor interrupt to the processor with the given local APIC id
+ */
+void apic_send_ipi(int apic_id, uint32_t command);
+
+#endif
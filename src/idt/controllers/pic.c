@@ -0,0 +1,85 @@
+#include "pic.h"
+#include "idt/controller.h"
+#include "idt/idt.h"
+#include "io/io.h"
+
+static int pic_init_controller();
+static void pic_eoi(int interrupt);
+static void pic_enable_irq(int irq);
+static int pic_enable_pci_irq(int irq);
+
+static struct interrupt_controller pic_controller = {
+    .init = pic_init_controller,
+    .eoi = pic_eoi,
+    .enable_irq = pic_enable_irq,
+    .enable_pci_irq = pic_enable_pci_irq,
+    .timer = 0,
+    .timer_max_ms = 0,
+    .name = "pic"};
+
+struct interrupt_controller *pic_init()
+{
+    return &pic_controller;
+}
+
+/**
+ * The master is mapped just after the intel exceptions and the slave straight after the master
+ */
+static void pic_remap()
+{
+    outb(PIC1_COMMAND, PIC_ICW1_INIT);
+    outb(PIC2_COMMAND, PIC_ICW1_INIT);
+    outb(PIC1_DATA, INTERRUPT_CONTROLLER_IRQ_BASE);
+    outb(PIC2_DATA, INTERRUPT_CONTROLLER_IRQ_BASE + 8);
+
+    // Tell the master where the slave is and tell the slave its cascade identity
+    outb(PIC1_DATA, 1 << PIC_CASCADE_IRQ);
+    outb(PIC2_DATA, PIC_CASCADE_IRQ);
+    outb(PIC1_DATA, PIC_ICW4_8086);
+    outb(PIC2_DATA, PIC_ICW4_8086);
+}
+
+static int pic_init_controller()
+{
+    pic_remap();
+
+    // Every IRQ is masked until a driver asks for it, except the slave which we reach through the master
+    outb(PIC1_DATA, 0xFF & ~(1 << PIC_CASCADE_IRQ));
+    outb(PIC2_DATA, 0xFF);
+    return 0;
+}
+
+void pic_disable()
+{
+    pic_remap();
+    outb(PIC1_DATA, 0xFF);
+    outb(PIC2_DATA, 0xFF);
+}
+
+static void pic_eoi(int interrupt)
+{
+    if (interrupt < INTERRUPT_CONTROLLER_IRQ_BASE || interrupt >= INTERRUPT_CONTROLLER_IRQ_BASE + INTERRUPT_CONTROLLER_TOTAL_IRQS)
+    {
+        return;
+    }
+
+    // Interrupts from the slave must be acknowledged by both PICs
+    if (interrupt >= INTERRUPT_CONTROLLER_IRQ_BASE + 8)
+    {
+        outb(PIC2_COMMAND, PIC_EOI);
+    }
+    outb(PIC1_COMMAND, PIC_EOI);
+}
+
+static void pic_enable_irq(int irq)
+{
+    int port = irq < 8 ? PIC1_DATA : PIC2_DATA;
+    outb(port, insb(port) & ~(1 << (irq % 8)));
+}
+
+static int pic_enable_pci_irq(int irq)
+{
+    // The firmware sets the IRQs it gives PCI devices to level triggered in the PIC's edge/level control registers
+    pic_enable_irq(irq);
+    return 0;
+}
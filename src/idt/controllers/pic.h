@@ -0,0 +1,20 @@
+#ifndef PIC_H
+#define PIC_H
+
+// The slave PIC is connected to this IRQ of the master
+#define PIC_CASCADE_IRQ 2
+
+#define PIC_ICW1_INIT 0x11
+#define PIC_ICW4_8086 0x01
+
+/**
+ * The legacy 8259 PIC pair, always available and used when there is no APIC
+ */
+struct interrupt_controller *pic_init();
+
+/**
+ * Remaps the PICs away from the intel exceptions and masks every IRQ, used when another controller takes over
+ */
+void pic_disable();
+
+#endif
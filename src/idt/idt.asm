@@ -7,8 +7,10 @@ global enable_interrupts
 global disable_interrupts
 global isr1h_wrapper
 global isr80h_wrapper
+global isr80h_sysenter_wrapper
 
 global idt_page_fault
+global idt_device_not_available
 global isr_no_interrupt_wrapper
 global isr_invalid_tss_wrapper
 global isr_segment_not_present_wrapper
@@ -19,9 +21,17 @@ extern interrupt_handler
 extern isr0_handler
 extern isr_no_interrupt
 extern isr80h_handler
+extern isr80h_sysenter_stack_valid
+extern isr80h_sysenter_bad_stack
 extern isr_invalid_tss_handler
 extern isr_segment_not_present_handler
 extern idt_page_fault_handler
+extern idt_device_not_available_handler
+
+USER_CODE_SEG equ 0x1B
+USER_DATA_SEG equ 0x23
+; Where the saved EAX is once the command and frame pointer have been pushed after pushad
+ISR80H_FRAME_EAX equ 8 + 28
 
 
 idt_load:
@@ -103,6 +113,15 @@ idt_page_fault:
 
         iretd
 
+idt_device_not_available:
+        ; No error code is pushed for this exception so the frame is the same as any other interrupt
+        pushad
+        push esp
+        call idt_device_not_available_handler
+        pop eax
+        popad
+        iretd
+
 isr80h_wrapper:
 cli
     ; INTERRUPT FRAME START
@@ -123,17 +142,70 @@ cli
     ; EAX holds our command lets push it
     push eax
     call isr80h_handler
-    mov dword[tmp_res], eax
+    ; Store the result where popad restores EAX from, other processors may be in here too
+    mov dword[esp+ISR80H_FRAME_EAX], eax
     pop ebx
     pop ebx
     ; Restore user land registers
     popad
-
-    ; Set the EAX register to the return result stored in tmp_res
-    mov eax, [tmp_res]
     
     iretd
 
+; SYSENTER lands here on the kernel stack from the MSRs with interrupts disabled
+; ECX points at the caller's stack which holds its ECX, its EDX, the return address then the stack arguments
+; We are still on the caller's page directory so its memory can be read until we switch to the kernel page
+isr80h_sysenter_wrapper:
+    ; The caller's stack is only read once its page tables say the caller could read it
+    push eax
+    push ecx
+    push ecx
+    call isr80h_sysenter_stack_valid
+    add esp, 4
+    pop ecx
+    test al, al
+    pop eax
+    jz .bad_stack
+
+    ; Push what an interrupt gate would have pushed so the kernel can't tell the two apart
+    push dword USER_DATA_SEG
+    lea edx, [ecx+12]
+    push edx
+    pushfd
+    ; The caller had interrupts enabled, SYSENTER cleared the flag
+    or dword [esp], 0x200
+    push dword USER_CODE_SEG
+    push dword [ecx+8]
+    ; Register arguments may be in ECX and EDX
+    mov edx, [ecx+4]
+    mov ecx, [ecx]
+    pushad
+
+    push esp
+    push eax
+    call isr80h_handler
+    mov dword[esp+ISR80H_FRAME_EAX], eax
+    pop ebx
+    pop ebx
+    popad
+
+    ; SYSEXIT returns to EDX with the stack in ECX, take them from the frame
+    mov edx, [esp]
+    mov ecx, [esp+12]
+    ; Interrupts are enabled after the next instruction so nothing can interrupt us on the kernel stack
+    sti
+    sysexit
+
+.bad_stack:
+    ; We don't know where the caller came from, the frame is only needed to crash its process
+    push dword USER_DATA_SEG
+    push ecx
+    pushfd
+    push dword USER_CODE_SEG
+    push dword 0
+    pushad
+    push esp
+    call isr80h_sysenter_bad_stack
+
 
 isr_invalid_tss_wrapper:
     cld
@@ -152,9 +224,6 @@ isr_no_interrupt_wrapper:
 ; We need to make a pointer table for all the interrupt entries, these will point to the associated wrappers
 section .data
 
-; Stores the return result of the interrupt operation
-tmp_res: dd 0
-
 %macro interrupt_array_entry 1
     dd int%1
 %endmacro
@@ -14,6 +14,11 @@
 #include "video/font/font.h"
 #include "video/font/formats/psffont.h"
 #include "timer/pit.h"
+#include "controller.h"
+#include "smp/smp.h"
+#include "isr80h/trace.h"
+#include "cpu/cpu.h"
+#include "cpu/fpu.h"
 #include "status.h"
 
 
@@ -23,7 +28,9 @@ extern struct tss tss;
 void isr0_wrapper();
 void isr1h_wrapper();
 void isr80h_wrapper();
+void isr80h_sysenter_wrapper();
 void idt_page_fault();
+void idt_device_not_available();
 void isr_invalid_tss_wrapper();
 void isr_no_interrupt_wrapper();
 void isr_segment_not_present_wrapper();
@@ -58,18 +65,22 @@ bool idt_is_reserved(int interrupt)
 
 void interrupt_handler(int interrupt, struct interrupt_frame *frame)
 {
+    // Switching to another task releases the lock for us
+    smp_lock_kernel();
     kernel_page();
     if (interrupt_callbacks[interrupt] != 0)
     {
         process_mark_running(false);
         task_current_save_state(frame);
-        interrupt_callbacks[interrupt]();
+        // Callbacks shared by several interrupts can tell which one was raised
+        interrupt_callbacks[interrupt](interrupt);
         process_mark_running(true);
     }
     task_page();
 
     // Acknowledge the interrupt
-    outb(PIC1, PIC_EOI);
+    interrupt_controller_eoi(interrupt);
+    smp_unlock_kernel();
 }
 
 int idt_function_is_valid(int interrupt, INTERRUPT_CALLBACK_FUNCTION interrupt_callback)
@@ -108,7 +119,7 @@ out:
 void idt_general_protection_fault(int interrupt)
 {
     // Crash the program that faulted.
-    process_crash(process_current(), -1);
+    process_crash(task_current()->process, -1);
 
     // Go to the next task as the task of the process we crashed
     // Is now non-existant.
@@ -189,7 +200,23 @@ void print_page_fault(uint32_t bad_address)
 }
 void idt_page_fault_handler(struct interrupt_frame frame)
 {
+    smp_lock_kernel();
     paging_handle_page_fault();
+    smp_unlock_kernel();
+}
+
+void idt_device_not_available_handler(struct interrupt_frame *frame)
+{
+    smp_lock_kernel();
+    kernel_page();
+    if (!fpu_handle_device_not_available())
+    {
+        // The task can't have an FPU so it can't continue
+        task_current_save_state(frame);
+        idt_general_protection_fault(0x07);
+    }
+    task_page();
+    smp_unlock_kernel();
 }
 
 void isr80h_register_command(int command_id, ISR80H_COMMAND command)
@@ -207,7 +234,57 @@ void isr80h_register_command(int command_id, ISR80H_COMMAND command)
     isr80h_commands[command_id] = command;
 }
 
-void *isr80h_handle_command(int command, struct interrupt_frame *frame)
+void *isr80h_argument(struct isr80h_arguments *args, int index)
+{
+    return (void *)isr80h_argument_uint(args, index);
+}
+
+uint32_t isr80h_argument_uint(struct isr80h_arguments *args, int index)
+{
+    if (index < 0 || index >= ISR80H_MAX_ARGUMENTS)
+    {
+        return 0;
+    }
+    return args->values[index];
+}
+
+/**
+ * Reads the arguments the current task passed for the command, from its registers or from its stack
+ */
+static void isr80h_read_arguments(int command, struct interrupt_frame *frame, struct isr80h_arguments *args)
+{
+    memset(args, 0, sizeof(struct isr80h_arguments));
+    if (command & ISR80H_REGISTER_ABI)
+    {
+        args->values[0] = frame->ebx;
+        args->values[1] = frame->ecx;
+        args->values[2] = frame->edx;
+        args->values[3] = frame->esi;
+        args->values[4] = frame->edi;
+        args->values[5] = frame->ebp;
+        return;
+    }
+
+    // One copy rather than walking the task's page tables for every argument
+    struct task *task = task_current();
+    uint32_t *stack = (uint32_t *)task->registers.esp;
+    if (copy_from_task(task, args->values, stack, sizeof(args->values)) == 0)
+    {
+        return;
+    }
+
+    // We are at the very top of the stack, take what we can
+    for (int i = 0; i < ISR80H_MAX_ARGUMENTS; i++)
+    {
+        if (copy_from_task(task, &args->values[i], &stack[i], sizeof(uint32_t)) < 0)
+        {
+            args->values[i] = 0;
+            break;
+        }
+    }
+}
+
+void *isr80h_handle_command(int command, struct isr80h_arguments *args)
 {
     void *result = 0;
 
@@ -225,17 +302,75 @@ void *isr80h_handle_command(int command, struct interrupt_frame *frame)
         return 0;
     }
 
-    result = command_func(frame);
+    result = command_func(args);
     return result;
 }
 
+/**
+ * Called by the SYSENTER entry before it reads the caller's stack, returns true if the caller could read the
+ * stack itself. We are still on the caller's page directory without the kernel lock
+ */
+bool isr80h_sysenter_stack_valid(uint32_t stack)
+{
+    // The caller's ECX, EDX and return address
+    uint32_t end = stack + 12;
+    struct task *task = task_current();
+    if (end < stack || !task || !task->page_directory)
+    {
+        return false;
+    }
+
+    uint32_t *directory = task->page_directory->directory_entry;
+    for (uint32_t page = paging_align_value_to_lower_page(stack); page < end; page += COS32_PAGE_SIZE)
+    {
+        uint32_t directory_index = 0;
+        uint32_t table_index = 0;
+        if (paging_get_indexes((void *)page, &directory_index, &table_index) < 0 || !(directory[directory_index] & PAGING_PAGE_PRESENT))
+        {
+            return false;
+        }
+
+        // Kernel memory is mapped into every process but only the kernel may touch it
+        int flags = paging_get_flags(directory, (void *)page);
+        if ((flags & (PAGING_PAGE_PRESENT | PAGING_ACCESS_FROM_ALL)) != (PAGING_PAGE_PRESENT | PAGING_ACCESS_FROM_ALL))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * The caller of SYSENTER gave us a stack it can't read, crash it as if it had faulted
+ */
+void isr80h_sysenter_bad_stack(struct interrupt_frame *frame)
+{
+    smp_lock_kernel();
+    kernel_page();
+    task_current_save_state(frame);
+    idt_general_protection_fault(0x0D);
+}
+
 void *isr80h_handler(int command, struct interrupt_frame *frame)
 {
     void *res = 0;
     // Our interrupt handler may only be called by programs and not the kernel
+    smp_lock_kernel();
     kernel_page();
     task_current_save_state(frame);
-    res = isr80h_handle_command(command, frame);
+
+    // The process was terminated by another processor whilst we waited for the lock, we never run for it again
+    if (task_current()->flags & TASK_FLAG_REAP)
+    {
+        task_next();
+    }
+
+    struct isr80h_arguments args;
+    isr80h_read_arguments(command, frame, &args);
+    uint64_t trace_start = isr80h_trace_start();
+    res = isr80h_handle_command(command & ~ISR80H_REGISTER_ABI, &args);
+    isr80h_trace_record(command & ~ISR80H_REGISTER_ABI, &args, res, trace_start);
 
     // If the task is now in a paused state we should switch to the next task
     if (!task_current()->awake)
@@ -245,6 +380,7 @@ void *isr80h_handler(int command, struct interrupt_frame *frame)
     }
 
     task_page();
+    smp_unlock_kernel();
     return res;
 }
 
@@ -310,11 +446,31 @@ void idt_init()
     // Setup page fault handler
     idt_set(0x0e, idt_page_fault);
 
-    // Initialize the PIT timer
+    // Tasks get the FPU when they first use it after a task switch
+    idt_set(0x07, idt_device_not_available);
+
+    // Find the interrupt controller before anything asks it for interrupts
+    interrupt_controller_init();
+
+    // Initialize the timer
     pit_init();
 }
 
 void idt_load_now()
 {
     idt_load(&idtr_desc);
+}
+
+bool idt_sysenter_init(uint32_t kernel_stack)
+{
+    if (!cpu_has_features_edx(CPU_FEATURE_EDX_SEP | CPU_FEATURE_EDX_MSR))
+    {
+        return false;
+    }
+
+    // These are per processor so every processor must call us with its own stack
+    cpu_write_msr(CPU_MSR_SYSENTER_CS, COS32_CODE_SELECTOR);
+    cpu_write_msr(CPU_MSR_SYSENTER_ESP, kernel_stack);
+    cpu_write_msr(CPU_MSR_SYSENTER_EIP, (uint32_t)isr80h_sysenter_wrapper);
+    return true;
 }
\ No newline at end of file
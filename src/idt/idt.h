@@ -6,8 +6,16 @@
 
 
 struct interrupt_frame;
+struct isr80h_arguments;
 typedef void(*INTERRUPT_CALLBACK_FUNCTION)();
-typedef void*(*ISR80H_COMMAND)(struct interrupt_frame* frame);
+typedef void*(*ISR80H_COMMAND)(struct isr80h_arguments* args);
+
+// Set in EAX alongside the command when the arguments are passed in registers rather than on the stack
+#define ISR80H_REGISTER_ABI 0x80000000
+// The arguments of the register ABI in order, EBX, ECX, EDX, ESI, EDI then EBP
+#define ISR80H_MAX_REGISTER_ARGUMENTS 6
+// The most arguments a command may take with the stack ABI
+#define ISR80H_MAX_ARGUMENTS 8
 
 // ISR Definitions
 #define PIC1		0x20		/* IO base address for master PIC */
@@ -24,6 +32,9 @@ typedef void*(*ISR80H_COMMAND)(struct interrupt_frame* frame);
 #define IDT_TRAP_GATE 0x8F
 
 #define ISR_TIMER_INTERRUPT 0x20
+#define ISR_KTHREAD_YIELD_INTERRUPT 0x81
+// Sent by another processor when it makes one of our tasks runnable
+#define ISR_RESCHEDULE_INTERRUPT 0x82
 
 struct idt_desc
 {
@@ -59,12 +70,36 @@ struct interrupt_frame
     uint32_t ss;
 } __attribute__((packed));
 
+// The arguments of a system call, read once before the command runs
+struct isr80h_arguments
+{
+    // Argument zero is the first register or the last value the caller pushed to its stack
+    uint32_t values[ISR80H_MAX_ARGUMENTS];
+};
+
 void idt_init();
 void idt_load(struct idtr_desc* desc);
 void idt_load_now();
+
+/**
+ * Lets user programs make system calls with SYSENTER on the processor we are running on.
+ * Returns false if the processor does not support it, "int 0x80" always works
+ */
+bool idt_sysenter_init(uint32_t kernel_stack);
 void enable_interrupts();
 void disable_interrupts();
 void isr80h_register_command(int command_id, ISR80H_COMMAND command);
 
+/**
+ * Returns the system call argument at the given index, zero if there is no such argument
+ */
+void *isr80h_argument(struct isr80h_arguments *args, int index);
+uint32_t isr80h_argument_uint(struct isr80h_arguments *args, int index);
+
+/**
+ * Runs the given system call command for the current task, returns zero if there is no such command
+ */
+void *isr80h_handle_command(int command, struct isr80h_arguments *args);
+
 int idt_register_interrupt_callback(int interrupt, INTERRUPT_CALLBACK_FUNCTION interrupt_callback);
 #endif
\ No newline at end of file
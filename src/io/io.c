@@ -19,4 +19,14 @@ void outw (unsigned short _port, unsigned short _data){
 
 void outb (unsigned short _port, unsigned char _data){
     __asm__ __volatile__ ("outb %1, %0" : : "dN" (_port), "a" (_data));
+}
+
+unsigned int insl (unsigned short _port){
+    unsigned int rv;
+    __asm__ __volatile__ ("inl %1, %0" : "=a" (rv) : "dN" (_port));
+    return rv;
+}
+
+void outl (unsigned short _port, unsigned int _data){
+    __asm__ __volatile__ ("outl %1, %0" : : "dN" (_port), "a" (_data));
 }
\ No newline at end of file
@@ -5,4 +5,6 @@ int insb(int port);
 int insw(int port);
 void outb(int port, int value);
 void outw(int port, int value);
+unsigned int insl(int port);
+void outl(int port, unsigned int value);
 #endif
\ No newline at end of file
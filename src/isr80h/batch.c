@@ -0,0 +1,91 @@
+#include "batch.h"
+#include "isr80h.h"
+#include "task/task.h"
+#include "memory/memory.h"
+#include "status.h"
+
+/**
+ * Commands that may switch task never return to us and commands taking more arguments than an entry holds
+ * would see zero for the rest, they can't be part of a batch
+ */
+static bool isr80h_batch_allowed(int command)
+{
+    switch (command)
+    {
+    case SYSTEM_COMMAND_INVOKE:
+    case SYSTEM_COMMAND_SLEEP:
+    case SYSTEM_COMMAND_THREAD_EXIT:
+    case SYSTEM_COMMAND_THREAD_JOIN:
+    case SYSTEM_COMMAND_GET_KEY_BLOCK:
+    case SYSTEM_COMMAND_BATCH:
+    // Takes seven arguments
+    case SYSTEM_COMMAND_VIDEO_RECTANGLE_DRAW_BLOCKS:
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Runs the entries in order, returns how many ran before the task stopped being awake
+ */
+static int isr80h_batch_run(struct isr80h_batch_entry *entries, int total)
+{
+    struct isr80h_arguments args;
+    for (int i = 0; i < total; i++)
+    {
+        struct isr80h_batch_entry *entry = &entries[i];
+        if (!isr80h_batch_allowed(entry->command))
+        {
+            entry->result = -EINVARG;
+            continue;
+        }
+
+        memset(&args, 0, sizeof(args));
+        memcpy(args.values, entry->args, sizeof(entry->args));
+        entry->result = (uint32_t)isr80h_handle_command(entry->command, &args);
+
+        // The system call handler switches task for us once we return
+        if (!task_current()->awake)
+        {
+            return i + 1;
+        }
+    }
+    return total;
+}
+
+void *isr80h_command31_batch(struct isr80h_arguments *args)
+{
+    struct task *task = task_current();
+    struct isr80h_batch_entry *user_entries = isr80h_argument(args, 0);
+    int total = (int)isr80h_argument_uint(args, 1);
+    struct isr80h_batch_entry entries[ISR80H_BATCH_CHUNK];
+    int done = 0;
+
+    if (total < 0)
+    {
+        return (void *)-EINVARG;
+    }
+
+    while (done < total)
+    {
+        int count = total - done < ISR80H_BATCH_CHUNK ? total - done : ISR80H_BATCH_CHUNK;
+        if (copy_from_task(task, entries, &user_entries[done], sizeof(struct isr80h_batch_entry) * count) < 0)
+        {
+            return done == 0 ? (void *)-EINVARG : (void *)done;
+        }
+
+        int ran = isr80h_batch_run(entries, count);
+        if (copy_to_task(task, &user_entries[done], entries, sizeof(struct isr80h_batch_entry) * ran) < 0)
+        {
+            return (void *)-EINVARG;
+        }
+
+        done += ran;
+        if (ran < count)
+        {
+            break;
+        }
+    }
+
+    return (void *)done;
+}
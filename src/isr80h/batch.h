@@ -0,0 +1,30 @@
+#ifndef ISR80H_BATCH_H
+#define ISR80H_BATCH_H
+
+#include <stdint.h>
+#include "idt/idt.h"
+
+// The most batch entries copied into the kernel at once, bigger batches are run a piece at a time
+#define ISR80H_BATCH_CHUNK 16
+
+// A single command of a batch, the layout is shared with user space
+struct isr80h_batch_entry
+{
+    uint32_t command;
+
+    // Indexed like the register ABI, argument zero is the last parameter of the command
+    uint32_t args[ISR80H_MAX_REGISTER_ARGUMENTS];
+
+    // Written by the kernel once the command has run
+    uint32_t result;
+};
+
+struct isr80h_arguments;
+
+/**
+ * Runs every command in the caller's batch and writes back each result.
+ * Returns how many commands ran, we stop early if a command puts the task to sleep
+ */
+void *isr80h_command31_batch(struct isr80h_arguments *args);
+
+#endif
@@ -1,23 +1,24 @@
 #include "font.h"
+#include "idt/idt.h"
 #include "task/task.h"
 #include "task/process.h"
 #include "video/font/font.h"
 #include "kernel.h"
 
-void *isr80h_command13_font_get(struct interrupt_frame *frame)
+void *isr80h_command13_font_get(struct isr80h_arguments *args)
 {
 
-    void *font_name_user_space_addr = task_current_get_stack_item(0);
+    void *font_name_user_space_addr = isr80h_argument(args, 0);
     char buf[1024];
     ASSERT(copy_string_from_task(task_current(), font_name_user_space_addr, buf, sizeof(buf)) == 0);
     return video_font_get(buf);
 }
 
-void* isr80h_command14_font_draw(struct interrupt_frame *frame)
+void* isr80h_command14_font_draw(struct isr80h_arguments *args)
 {
-    struct video_font* font = task_current_get_stack_item(2);
-    void *out = task_current_get_stack_item(1);
-    void *text_user_space_addr = task_current_get_stack_item(0);
+    struct video_font* font = isr80h_argument(args, 2);
+    void *out = isr80h_argument(args, 1);
+    void *text_user_space_addr = isr80h_argument(args, 0);
 
     char buf[1024];
     copy_string_from_task(task_current(), text_user_space_addr, buf, sizeof(buf));
@@ -25,9 +26,9 @@ void* isr80h_command14_font_draw(struct interrupt_frame *frame)
     return 0;
 }
 
-void* isr80h_command_15_font_make_empty_string(struct interrupt_frame* frame)
+void* isr80h_command_15_font_make_empty_string(struct isr80h_arguments *args)
 {
-    struct video_font* font = task_current_get_stack_item(1);
-    int len = (int)task_current_get_stack_item_uint(0);
+    struct video_font* font = isr80h_argument(args, 1);
+    int len = (int)isr80h_argument_uint(args, 0);
     return video_font_make_empty_string_for_process(task_current()->process, font, len);
 }
@@ -4,26 +4,37 @@
 #include "idt/idt.h"
 #include "kernel.h"
 
-void *isr80h_command1_print(struct interrupt_frame *frame)
+void *isr80h_command1_print(struct isr80h_arguments *args)
 { 
-    // The message to print is the first element on the user stack
-    void *msg_user_space_addr = task_current_get_stack_item(0);
+    // The message to print is the first argument
+    void *msg_user_space_addr = isr80h_argument(args, 0);
     char buf[1024];
     ASSERT(copy_string_from_task(task_current(), msg_user_space_addr, buf, sizeof(buf)) == 0);
     task_print(buf);
     return 0;
 }
 
-void *isr80h_command2_get_key(struct interrupt_frame *frame)
+void *isr80h_command2_get_key(struct isr80h_arguments *args)
 {
     char key = keyboard_pop();
     return (void *)((int)key);
 }
 
 
-void *isr80h_command4_putchar(struct interrupt_frame *frame)
+void *isr80h_command4_putchar(struct isr80h_arguments *args)
 {
-    char c = (char)task_current_get_stack_item_uint(0);
+    char c = (char)isr80h_argument_uint(args, 0);
     task_putchar(c);
     return 0;
 }
+
+void *isr80h_command25_get_key_block(struct isr80h_arguments *args)
+{
+    char key = keyboard_pop();
+    if (!key)
+    {
+        // Nothing to pop, we sleep until a key is pressed. We will return zero so the caller asks again
+        keyboard_wait(task_current());
+    }
+    return (void *)((int)key);
+}
@@ -1,9 +1,10 @@
 #ifndef ISR80H_IO_H
 #define ISR80H_IO_H
 
-struct interrupt_frame;
-void *isr80h_command1_print(struct interrupt_frame *frame);
-void *isr80h_command2_get_key(struct interrupt_frame *frame);
-void *isr80h_command4_putchar(struct interrupt_frame *frame);
+struct isr80h_arguments;
+void *isr80h_command1_print(struct isr80h_arguments *args);
+void *isr80h_command2_get_key(struct isr80h_arguments *args);
+void *isr80h_command4_putchar(struct isr80h_arguments *args);
+void *isr80h_command25_get_key_block(struct isr80h_arguments *args);
 
 #endif
\ No newline at end of file
@@ -4,6 +4,8 @@
 #include "isr80h/isrkernel.h"
 #include "isr80h/video.h"
 #include "isr80h/font.h"
+#include "isr80h/batch.h"
+#include "isr80h/trace.h"
 #include "idt/idt.h"
 
 void isr80h_register_all()
@@ -30,4 +32,20 @@ void isr80h_register_all()
     isr80h_register_command(SYSTEM_COMMAND_PROCESS_GET_ARGUMENTS, isr80h_command19_process_get_arguments);
     isr80h_register_command(SYSTEM_COMMAND_VIDEO_BUFFER_FLUSH, isr80h_command20_video_buffer_flush);
     isr80h_register_command(SYSTEM_COMMAND_VIDEO_CLEAR_FLAG, isr80h_command21_video_clear_flag);
+    isr80h_register_command(SYSTEM_COMMAND_THREAD_CREATE, isr80h_command22_thread_create);
+    isr80h_register_command(SYSTEM_COMMAND_THREAD_EXIT, isr80h_command23_thread_exit);
+    isr80h_register_command(SYSTEM_COMMAND_THREAD_JOIN, isr80h_command24_thread_join);
+    isr80h_register_command(SYSTEM_COMMAND_GET_KEY_BLOCK, isr80h_command25_get_key_block);
+    isr80h_register_command(SYSTEM_COMMAND_TASK_SET_PRIORITY, isr80h_command26_task_set_priority);
+    isr80h_register_command(SYSTEM_COMMAND_TASK_SET_SCHEDULER, isr80h_command27_task_set_scheduler);
+    isr80h_register_command(SYSTEM_COMMAND_TASK_STATISTICS, isr80h_command28_task_statistics);
+    isr80h_register_command(SYSTEM_COMMAND_CLOCK_NS, isr80h_command29_clock_ns);
+    isr80h_register_command(SYSTEM_COMMAND_NULL, isr80h_command30_null);
+    isr80h_register_command(SYSTEM_COMMAND_BATCH, isr80h_command31_batch);
+    isr80h_register_command(SYSTEM_COMMAND_TRACE, isr80h_command32_trace);
+    isr80h_register_command(SYSTEM_COMMAND_DISK_CACHE_STATISTICS, isr80h_command33_disk_cache_statistics);
+    isr80h_register_command(SYSTEM_COMMAND_DISK_READ, isr80h_command34_disk_read);
+    isr80h_register_command(SYSTEM_COMMAND_DISK_QUEUE_STATISTICS, isr80h_command35_disk_queue_statistics);
+    isr80h_register_command(SYSTEM_COMMAND_SYNC, isr80h_command36_sync);
+    isr80h_register_command(SYSTEM_COMMAND_DISK_WRITE, isr80h_command37_disk_write);
 }
\ No newline at end of file
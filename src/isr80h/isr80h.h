@@ -24,7 +24,23 @@ enum SystemCommands
     SYSTEM_COMMAND_VIDEO_RECTANGLE_GET,
     SYSTEM_COMMAND_PROCESS_GET_ARGUMENTS,
     SYSTEM_COMMAND_VIDEO_BUFFER_FLUSH,
-    SYSTEM_COMMAND_VIDEO_CLEAR_FLAG
+    SYSTEM_COMMAND_VIDEO_CLEAR_FLAG,
+    SYSTEM_COMMAND_THREAD_CREATE,
+    SYSTEM_COMMAND_THREAD_EXIT,
+    SYSTEM_COMMAND_THREAD_JOIN,
+    SYSTEM_COMMAND_GET_KEY_BLOCK,
+    SYSTEM_COMMAND_TASK_SET_PRIORITY,
+    SYSTEM_COMMAND_TASK_SET_SCHEDULER,
+    SYSTEM_COMMAND_TASK_STATISTICS,
+    SYSTEM_COMMAND_CLOCK_NS,
+    SYSTEM_COMMAND_NULL,
+    SYSTEM_COMMAND_BATCH,
+    SYSTEM_COMMAND_TRACE,
+    SYSTEM_COMMAND_DISK_CACHE_STATISTICS,
+    SYSTEM_COMMAND_DISK_READ,
+    SYSTEM_COMMAND_DISK_QUEUE_STATISTICS,
+    SYSTEM_COMMAND_SYNC,
+    SYSTEM_COMMAND_DISK_WRITE
 };
 
 
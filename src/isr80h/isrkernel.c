@@ -2,6 +2,12 @@
 #include "idt/idt.h"
 #include "kernel.h"
 #include "task/task.h"
+#include "timer/clock.h"
+#include "disk/cache.h"
+#include "disk/disk.h"
+#include "memory/kheap.h"
+#include "config.h"
+#include "status.h"
 
 // These symbols are added during linking process automatically with "ld" command
 // Note we get the address of these symbols they are the value its self
@@ -9,10 +15,125 @@
 extern void *__BUILD_DATE;
 extern void *__BUILD_NUMBER;
 
-void *isr80h_command3_get_kernel_info(struct interrupt_frame *frame)
+void *isr80h_command3_get_kernel_info(struct isr80h_arguments *args)
 {
-    struct kernel_info *kernel_info_struct_user_space_addr = task_current_get_stack_item(0);
+    struct kernel_info *kernel_info_struct_user_space_addr = isr80h_argument(args, 0);
     copy_integer_to_task(task_current(), (void *)&kernel_info_struct_user_space_addr->build_no, (int)&__BUILD_NUMBER);
     copy_integer_to_task(task_current(), (void *)&kernel_info_struct_user_space_addr->date, (int)&__BUILD_DATE);
     return 0;
 }
+
+void *isr80h_command29_clock_ns(struct isr80h_arguments *args)
+{
+    // The result does not fit into eax so we write it to the caller
+    void *ns_user_space_addr = isr80h_argument(args, 0);
+    uint64_t ns = clock_ns();
+    return (void *)copy_to_task(task_current(), ns_user_space_addr, &ns, sizeof(ns));
+}
+
+void *isr80h_command30_null(struct isr80h_arguments *args)
+{
+    return 0;
+}
+
+void *isr80h_command33_disk_cache_statistics(struct isr80h_arguments *args)
+{
+    void *statistics_user_space_addr = isr80h_argument(args, 0);
+    struct disk_cache_statistics statistics;
+    disk_cache_get_statistics(&statistics);
+    return (void *)copy_to_task(task_current(), statistics_user_space_addr, &statistics, sizeof(statistics));
+}
+
+void *isr80h_command34_disk_read(struct isr80h_arguments *args)
+{
+    int res = 0;
+    char *buf = 0;
+    struct disk *disk = disk_get(isr80h_argument_uint(args, 0));
+    unsigned int lba = isr80h_argument_uint(args, 1);
+    int total = isr80h_argument_uint(args, 2);
+    void *out_user_space_addr = isr80h_argument(args, 3);
+    if (!disk || total <= 0 || total > COS32_DISK_READ_MAX_SECTORS)
+    {
+        res = -EINVARG;
+        goto out;
+    }
+
+    buf = kmalloc(total * COS32_SECTOR_SIZE);
+    if (!buf)
+    {
+        res = -ENOMEM;
+        goto out;
+    }
+
+    // Sectors written through the cache may not be on the drive yet
+    res = disk_cache_sync_range(disk, lba, total);
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    res = disk_read_block_uncached(disk, lba, total, buf);
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    res = copy_to_task(task_current(), out_user_space_addr, buf, total * COS32_SECTOR_SIZE);
+
+out:
+    kfree(buf);
+    return (void *)res;
+}
+
+void *isr80h_command35_disk_queue_statistics(struct isr80h_arguments *args)
+{
+    struct disk *disk = disk_get(isr80h_argument_uint(args, 0));
+    void *statistics_user_space_addr = isr80h_argument(args, 1);
+    if (!disk)
+    {
+        return ERROR(-EINVARG);
+    }
+
+    struct disk_queue_statistics statistics;
+    disk_queue_get_statistics(disk, &statistics);
+    return (void *)copy_to_task(task_current(), statistics_user_space_addr, &statistics, sizeof(statistics));
+}
+
+void *isr80h_command36_sync(struct isr80h_arguments *args)
+{
+    return (void *)disk_sync();
+}
+
+void *isr80h_command37_disk_write(struct isr80h_arguments *args)
+{
+    int res = 0;
+    char *buf = 0;
+    struct disk *disk = disk_get(isr80h_argument_uint(args, 0));
+    unsigned int lba = isr80h_argument_uint(args, 1);
+    int total = isr80h_argument_uint(args, 2);
+    void *in_user_space_addr = isr80h_argument(args, 3);
+    if (!disk || total <= 0 || total > COS32_DISK_READ_MAX_SECTORS)
+    {
+        res = -EINVARG;
+        goto out;
+    }
+
+    buf = kmalloc(total * COS32_SECTOR_SIZE);
+    if (!buf)
+    {
+        res = -ENOMEM;
+        goto out;
+    }
+
+    res = copy_from_task(task_current(), buf, in_user_space_addr, total * COS32_SECTOR_SIZE);
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    res = disk_write_block(disk, lba, total, buf);
+
+out:
+    kfree(buf);
+    return (void *)res;
+}
@@ -2,7 +2,40 @@
 #define ISR80H_KERNEL_H
 
 
-struct interrupt_frame;
-void *isr80h_command3_get_kernel_info(struct interrupt_frame *frame);
+struct isr80h_arguments;
+void *isr80h_command3_get_kernel_info(struct isr80h_arguments *args);
+void *isr80h_command29_clock_ns(struct isr80h_arguments *args);
+
+/**
+ * Does nothing, used to measure the cost of entering and leaving the kernel
+ */
+void *isr80h_command30_null(struct isr80h_arguments *args);
+
+/**
+ * Copies the hit and miss counters of the disk cache to the caller
+ */
+void *isr80h_command33_disk_cache_statistics(struct isr80h_arguments *args);
+
+/**
+ * Reads sectors of a disk straight from the drive into the caller's memory, bypassing the disk cache
+ * so benchmarks measure the driver. Changed cached blocks of the sectors are written first
+ */
+void *isr80h_command34_disk_read(struct isr80h_arguments *args);
+
+/**
+ * Copies the request queue counters of a disk to the caller
+ */
+void *isr80h_command35_disk_queue_statistics(struct isr80h_arguments *args);
+
+/**
+ * Writes every changed block of the disk cache to its disk and flushes the drives, returns once it's all on the media
+ */
+void *isr80h_command36_sync(struct isr80h_arguments *args);
+
+/**
+ * Writes sectors from the caller's memory to a disk through the disk cache, they reach the drive
+ * when the cache is next written back or synced
+ */
+void *isr80h_command37_disk_write(struct isr80h_arguments *args);
 
 #endif
\ No newline at end of file
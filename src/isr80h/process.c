@@ -1,34 +1,110 @@
 #include "process.h"
 #include "task/task.h"
 #include "task/process.h"
+#include "task/thread.h"
 #include "idt/idt.h"
+#include "status.h"
+#include "config.h"
+#include "memory/kheap.h"
 
-void *isr80h_command5_malloc(struct interrupt_frame *frame)
+void *isr80h_command5_malloc(struct isr80h_arguments *args)
 {
-    int size = task_current_get_stack_item_uint(0);
+    int size = isr80h_argument_uint(args, 0);
     return task_malloc(task_current(), size);
 }
 
-void *isr80h_command6_invoke(struct interrupt_frame *frame)
+void *isr80h_command6_invoke(struct isr80h_arguments *args)
 {
-    struct command_argument *root_command_argument = task_current_get_stack_item(0);
+    struct command_argument *root_command_argument = isr80h_argument(args, 0);
     void *result = (void *)process_run_for_argument(root_command_argument, 0, 0);
     return result;
 }
 
-void *isr80h_command7_sleep(struct interrupt_frame *frame)
+void *isr80h_command7_sleep(struct isr80h_arguments *args)
 {
-    uint32_t sleep_seconds = task_current_get_stack_item_uint(0);
+    uint32_t sleep_seconds = isr80h_argument_uint(args, 0);
     task_usleep(task_current(), sleep_seconds * 1000);
     return (void *)0x00;
 }
 
-void* isr80h_command19_process_get_arguments(struct interrupt_frame* frame)
+void* isr80h_command19_process_get_arguments(struct isr80h_arguments *args)
 {
     struct process* process = task_current()->process;
-    struct process_arguments* arguments = task_virtual_address_to_physical(task_current(), task_current_get_stack_item(0));
+    struct process_arguments* arguments = task_virtual_address_to_physical(task_current(), isr80h_argument(args, 0));
 
     // Load the argc, and argv into user passed structure
     process_get_arguments(process, &arguments->argc, &arguments->argv);
     return 0;
-}
\ No newline at end of file
+}
+
+void *isr80h_command22_thread_create(struct isr80h_arguments *args)
+{
+    void *entry = isr80h_argument(args, 0);
+    void *function = isr80h_argument(args, 1);
+    void *arg = isr80h_argument(args, 2);
+    return (void *)thread_create(task_current()->process, entry, function, arg);
+}
+
+void *isr80h_command23_thread_exit(struct isr80h_arguments *args)
+{
+    int exit_code = (int)isr80h_argument_uint(args, 0);
+    return (void *)thread_exit(task_current(), exit_code);
+}
+
+void *isr80h_command24_thread_join(struct isr80h_arguments *args)
+{
+    int thread_id = (int)isr80h_argument_uint(args, 0);
+    void *exit_code_user_space_addr = isr80h_argument(args, 1);
+    return (void *)thread_join(task_current(), thread_id, exit_code_user_space_addr);
+}
+
+void *isr80h_command26_task_set_priority(struct isr80h_arguments *args)
+{
+    int priority = (int)isr80h_argument_uint(args, 0);
+    return (void *)task_set_priority(task_current(), priority);
+}
+
+void *isr80h_command27_task_set_scheduler(struct isr80h_arguments *args)
+{
+    void *scheduler_name_user_space_addr = isr80h_argument(args, 0);
+    char buf[20];
+    if (copy_string_from_task(task_current(), scheduler_name_user_space_addr, buf, sizeof(buf)) < 0)
+    {
+        return (void *)-EINVARG;
+    }
+    return (void *)task_scheduler_set(buf);
+}
+
+void *isr80h_command28_task_statistics(struct isr80h_arguments *args)
+{
+    int res = 0;
+    void *info_user_space_addr = isr80h_argument(args, 0);
+    int max = (int)isr80h_argument_uint(args, 1);
+    if (max <= 0)
+    {
+        return (void *)-EINVARG;
+    }
+
+    if (max > COS32_MAX_TASK_INFO)
+    {
+        max = COS32_MAX_TASK_INFO;
+    }
+
+    struct task_info *info = kzalloc(sizeof(struct task_info) * max);
+    if (!info)
+    {
+        return (void *)-ENOMEM;
+    }
+
+    int total = task_get_info(info, max);
+    res = copy_to_task(task_current(), info_user_space_addr, info, sizeof(struct task_info) * total);
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    res = total;
+out:
+    kfree(info);
+    return (void *)res;
+}
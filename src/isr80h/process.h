@@ -2,11 +2,17 @@
 #define ISR80H_PROCESS_H
 
 
-struct interrupt_frame;
+struct isr80h_arguments;
 
-void *isr80h_command5_malloc(struct interrupt_frame *frame);
-void *isr80h_command6_invoke(struct interrupt_frame *frame);
-void *isr80h_command7_sleep(struct interrupt_frame *frame);
-void *isr80h_command19_process_get_arguments(struct interrupt_frame* frame);
+void *isr80h_command5_malloc(struct isr80h_arguments *args);
+void *isr80h_command6_invoke(struct isr80h_arguments *args);
+void *isr80h_command7_sleep(struct isr80h_arguments *args);
+void *isr80h_command19_process_get_arguments(struct isr80h_arguments *args);
+void *isr80h_command22_thread_create(struct isr80h_arguments *args);
+void *isr80h_command23_thread_exit(struct isr80h_arguments *args);
+void *isr80h_command24_thread_join(struct isr80h_arguments *args);
+void *isr80h_command26_task_set_priority(struct isr80h_arguments *args);
+void *isr80h_command27_task_set_scheduler(struct isr80h_arguments *args);
+void *isr80h_command28_task_statistics(struct isr80h_arguments *args);
 
 #endif 
\ No newline at end of file
@@ -0,0 +1,263 @@
+#include "trace.h"
+#include "isr80h.h"
+#include "task/task.h"
+#include "task/process.h"
+#include "timer/clock.h"
+#include "memory/memory.h"
+#include "memory/kheap.h"
+#include "status.h"
+
+// Every call we are called for is made whilst holding the kernel lock
+static uint8_t trace_flags = 0;
+
+// The statistics of every process combined, this survives the processes going away
+static struct isr80h_trace_table trace_all;
+
+static struct isr80h_trace_call trace_calls[COS32_ISR80H_TRACE_RING_SIZE];
+// Where the next call is recorded and how many calls have been recorded since the last reset
+static int trace_calls_head = 0;
+static uint32_t trace_calls_total = 0;
+
+uint64_t isr80h_trace_start()
+{
+    if (!trace_flags)
+    {
+        return 0;
+    }
+    return clock_ns();
+}
+
+static int isr80h_trace_bucket(uint32_t ns)
+{
+    int bucket = 0;
+    while (ns >>= 1)
+    {
+        bucket++;
+    }
+    return bucket;
+}
+
+static void isr80h_trace_add(struct isr80h_trace_statistics *statistics, int command, uint32_t duration_ns, bool error)
+{
+    statistics->command = command;
+    statistics->calls++;
+    statistics->total_ns += duration_ns;
+    if (error)
+    {
+        statistics->errors++;
+    }
+    if (duration_ns > statistics->max_ns)
+    {
+        statistics->max_ns = duration_ns;
+    }
+    statistics->histogram[isr80h_trace_bucket(duration_ns)]++;
+}
+
+static void isr80h_trace_add_call(struct task *task, int command, struct isr80h_arguments *args, void *result, uint64_t start, uint32_t duration_ns)
+{
+    struct isr80h_trace_call *call = &trace_calls[trace_calls_head];
+    call->timestamp_ns = start;
+    call->duration_ns = duration_ns;
+    call->command = command;
+    call->process_id = task->process ? task->process->id : -1;
+    call->thread_id = task->thread_id;
+    memcpy(call->args, args->values, sizeof(call->args));
+    call->result = (uint32_t)result;
+
+    trace_calls_head = (trace_calls_head + 1) % COS32_ISR80H_TRACE_RING_SIZE;
+    trace_calls_total++;
+}
+
+void isr80h_trace_record(int command, struct isr80h_arguments *args, void *result, uint64_t start)
+{
+    if (!trace_flags || command <= 0 || command >= COS32_MAX_ISR80H_COMMANDS)
+    {
+        return;
+    }
+
+    // Nobody should spend four seconds in the kernel, the histogram tops out there anyway
+    uint64_t elapsed = clock_ns() - start;
+    uint32_t duration_ns = elapsed > 0xFFFFFFFF ? 0xFFFFFFFF : (uint32_t)elapsed;
+    struct task *task = task_current();
+
+    if (trace_flags & ISR80H_TRACE_STATISTICS)
+    {
+        bool error = (int)result < 0;
+        isr80h_trace_add(&trace_all.commands[command], command, duration_ns, error);
+
+        struct process *process = task->process;
+        if (process && !process->trace)
+        {
+            // Not every process makes system calls so the table is only made once it needs one
+            process->trace = kzalloc(sizeof(struct isr80h_trace_table));
+        }
+
+        if (process && process->trace)
+        {
+            isr80h_trace_add(&process->trace->commands[command], command, duration_ns, error);
+        }
+    }
+
+    if (trace_flags & ISR80H_TRACE_CALLS)
+    {
+        isr80h_trace_add_call(task, command, args, result, start, duration_ns);
+    }
+}
+
+void isr80h_trace_process_free(struct process *process)
+{
+    kfree(process->trace);
+    process->trace = 0;
+}
+
+static void isr80h_trace_reset()
+{
+    memset(&trace_all, 0, sizeof(trace_all));
+    for (struct process *process = process_list_head(); process; process = process->next)
+    {
+        isr80h_trace_process_free(process);
+    }
+
+    memset(trace_calls, 0, sizeof(trace_calls));
+    trace_calls_head = 0;
+    trace_calls_total = 0;
+}
+
+/**
+ * Copies the statistics of each command that has been called to the current task.
+ * Returns how many commands were copied
+ */
+static int isr80h_trace_copy_statistics(int process_id, struct isr80h_trace_statistics *out, int max)
+{
+    int res = 0;
+    struct isr80h_trace_table *table = &trace_all;
+    struct isr80h_trace_statistics *statistics = 0;
+    if (process_id != ISR80H_TRACE_ALL_PROCESSES)
+    {
+        struct process *process = process_get(process_id);
+        if (!process)
+        {
+            res = -EINVARG;
+            goto out;
+        }
+
+        // Nothing has been recorded for this process yet
+        table = process->trace;
+        if (!table)
+        {
+            goto out;
+        }
+    }
+
+    if (max > COS32_MAX_ISR80H_COMMANDS)
+    {
+        max = COS32_MAX_ISR80H_COMMANDS;
+    }
+
+    statistics = kzalloc(sizeof(struct isr80h_trace_statistics) * max);
+    if (!statistics)
+    {
+        res = -ENOMEM;
+        goto out;
+    }
+
+    int total = 0;
+    for (int i = 0; i < COS32_MAX_ISR80H_COMMANDS && total < max; i++)
+    {
+        if (table->commands[i].calls)
+        {
+            memcpy(&statistics[total++], &table->commands[i], sizeof(struct isr80h_trace_statistics));
+        }
+    }
+
+    res = copy_to_task(task_current(), out, statistics, sizeof(struct isr80h_trace_statistics) * total);
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    res = total;
+
+out:
+    kfree(statistics);
+    return res;
+}
+
+/**
+ * Copies up to "max" of the most recent calls to the current task, oldest first.
+ * Returns how many calls were copied
+ */
+static int isr80h_trace_copy_calls(struct isr80h_trace_call *out, int max)
+{
+    int res = 0;
+    struct isr80h_trace_call *calls = 0;
+    int available = trace_calls_total < COS32_ISR80H_TRACE_RING_SIZE ? (int)trace_calls_total : COS32_ISR80H_TRACE_RING_SIZE;
+    if (max > available)
+    {
+        max = available;
+    }
+
+    if (max == 0)
+    {
+        goto out;
+    }
+
+    calls = kzalloc(sizeof(struct isr80h_trace_call) * max);
+    if (!calls)
+    {
+        res = -ENOMEM;
+        goto out;
+    }
+
+    int first = (trace_calls_head - max + COS32_ISR80H_TRACE_RING_SIZE) % COS32_ISR80H_TRACE_RING_SIZE;
+    for (int i = 0; i < max; i++)
+    {
+        memcpy(&calls[i], &trace_calls[(first + i) % COS32_ISR80H_TRACE_RING_SIZE], sizeof(struct isr80h_trace_call));
+    }
+
+    res = copy_to_task(task_current(), out, calls, sizeof(struct isr80h_trace_call) * max);
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    res = max;
+
+out:
+    kfree(calls);
+    return res;
+}
+
+void *isr80h_command32_trace(struct isr80h_arguments *args)
+{
+    int res = 0;
+    int operation = (int)isr80h_argument_uint(args, 0);
+    int value = (int)isr80h_argument_uint(args, 1);
+    void *out = isr80h_argument(args, 2);
+    int max = (int)isr80h_argument_uint(args, 3);
+
+    switch (operation)
+    {
+    case ISR80H_TRACE_OPERATION_SET_FLAGS:
+        res = trace_flags;
+        trace_flags = value & (ISR80H_TRACE_STATISTICS | ISR80H_TRACE_CALLS);
+        break;
+
+    case ISR80H_TRACE_OPERATION_RESET:
+        isr80h_trace_reset();
+        break;
+
+    case ISR80H_TRACE_OPERATION_STATISTICS:
+        res = max <= 0 ? -EINVARG : isr80h_trace_copy_statistics(value, out, max);
+        break;
+
+    case ISR80H_TRACE_OPERATION_CALLS:
+        res = max <= 0 ? -EINVARG : isr80h_trace_copy_calls(out, max);
+        break;
+
+    default:
+        res = -EINVARG;
+    }
+
+    return (void *)res;
+}
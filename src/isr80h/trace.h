@@ -0,0 +1,88 @@
+#ifndef ISR80H_TRACE_H
+#define ISR80H_TRACE_H
+
+#include <stdint.h>
+#include "config.h"
+#include "idt/idt.h"
+
+// What the tracer records, both are off until a program turns them on
+#define ISR80H_TRACE_STATISTICS 0b00000001
+#define ISR80H_TRACE_CALLS 0b00000010
+
+// Bucket "i" of the latency histogram counts commands that took between 2^i and 2^(i+1) nanoseconds
+#define ISR80H_TRACE_BUCKETS 32
+
+// Pass as the process id to read the statistics of every process combined
+#define ISR80H_TRACE_ALL_PROCESSES -1
+
+enum
+{
+    // Sets the trace flags, returns the previous flags
+    ISR80H_TRACE_OPERATION_SET_FLAGS,
+    // Throws away everything recorded so far
+    ISR80H_TRACE_OPERATION_RESET,
+    // Copies the statistics of each command that was called
+    ISR80H_TRACE_OPERATION_STATISTICS,
+    // Copies the most recent calls oldest first
+    ISR80H_TRACE_OPERATION_CALLS
+};
+
+// The statistics of a single command, the layout is shared with user space
+struct isr80h_trace_statistics
+{
+    // The total nanoseconds spent running the command
+    uint64_t total_ns;
+    uint32_t command;
+    uint32_t calls;
+
+    // Calls that returned a negative status
+    uint32_t errors;
+    uint32_t max_ns;
+    uint32_t histogram[ISR80H_TRACE_BUCKETS];
+};
+
+struct isr80h_trace_table
+{
+    struct isr80h_trace_statistics commands[COS32_MAX_ISR80H_COMMANDS];
+};
+
+// A single recorded call, the layout is shared with user space
+struct isr80h_trace_call
+{
+    // When the command started in nanoseconds since boot
+    uint64_t timestamp_ns;
+    uint32_t duration_ns;
+    uint32_t command;
+    int process_id;
+    int thread_id;
+
+    // Indexed the same way as isr80h_argument
+    uint32_t args[ISR80H_MAX_REGISTER_ARGUMENTS];
+    uint32_t result;
+};
+
+struct process;
+
+/**
+ * Returns the time to pass to isr80h_trace_record, zero when we are not tracing
+ */
+uint64_t isr80h_trace_start();
+
+/**
+ * Records a command the current task has just run. Commands that never return to their caller,
+ * such as exiting a thread are never recorded. Commands that put the task to sleep are recorded
+ * with the time spent in the kernel rather than the time asleep
+ */
+void isr80h_trace_record(int command, struct isr80h_arguments *args, void *result, uint64_t start);
+
+/**
+ * Frees the statistics of a process that is going away
+ */
+void isr80h_trace_process_free(struct process *process);
+
+/**
+ * Controls the tracer, the operation is one of ISR80H_TRACE_OPERATION_*
+ */
+void *isr80h_command32_trace(struct isr80h_arguments *args);
+
+#endif
@@ -6,97 +6,97 @@
 #include "video/font/font.h"
 #include "video/rectangle.h"
 
-void *isr80h_command8_video_rectangle_new(struct interrupt_frame *frame)
+void *isr80h_command8_video_rectangle_new(struct isr80h_arguments *args)
 {
-    int abs_x = task_current_get_stack_item_uint(3);
-    int abs_y = task_current_get_stack_item_uint(2);
-    int width = task_current_get_stack_item_uint(1);
-    int height = task_current_get_stack_item_uint(0);
-    return video_rectangle_new(process_current()->video, abs_x, abs_y, width, height);
+    int abs_x = isr80h_argument_uint(args, 3);
+    int abs_y = isr80h_argument_uint(args, 2);
+    int width = isr80h_argument_uint(args, 1);
+    int height = isr80h_argument_uint(args, 0);
+    return video_rectangle_new(task_current()->process->video, abs_x, abs_y, width, height);
 }
 
-void *isr80h_command9_video_rectangle_set_pixel(struct interrupt_frame *frame)
+void *isr80h_command9_video_rectangle_set_pixel(struct isr80h_arguments *args)
 {
-    struct video_rectangle *rect = task_current_get_stack_item(3);
-    int x = task_current_get_stack_item_uint(2);
-    int y = task_current_get_stack_item_uint(1);
-    int colour = task_current_get_stack_item_uint(0);
+    struct video_rectangle *rect = isr80h_argument(args, 3);
+    int x = isr80h_argument_uint(args, 2);
+    int y = isr80h_argument_uint(args, 1);
+    int colour = isr80h_argument_uint(args, 0);
     return (void *)video_rectangle_set_pixel(rect, x, y, colour);
 }
 
-void *isr80h_command10_video_rectangle_fill(struct interrupt_frame *frame)
+void *isr80h_command10_video_rectangle_fill(struct isr80h_arguments *args)
 {
-    struct video_rectangle *rect = task_current_get_stack_item(1);
-    int colour = task_current_get_stack_item_uint(0);
+    struct video_rectangle *rect = isr80h_argument(args, 1);
+    int colour = isr80h_argument_uint(args, 0);
     return (void *)video_rectangle_fill(rect, colour);
 }
 
-void *isr80h_command11_video_rectangle_draw_block(struct interrupt_frame *frame)
+void *isr80h_command11_video_rectangle_draw_block(struct isr80h_arguments *args)
 {
-    int pixels_per_row = (int)task_current_get_stack_item(5);
-    int total_rows = (int)task_current_get_stack_item(4);
-    int absy = (int)task_current_get_stack_item(3);
-    int absx = (int)task_current_get_stack_item(2);
-    void *ptr = task_current_get_stack_item(1);
-    struct video_rectangle *rect = task_current_get_stack_item(0);
+    int pixels_per_row = (int)isr80h_argument(args, 5);
+    int total_rows = (int)isr80h_argument(args, 4);
+    int absy = (int)isr80h_argument(args, 3);
+    int absx = (int)isr80h_argument(args, 2);
+    void *ptr = isr80h_argument(args, 1);
+    struct video_rectangle *rect = isr80h_argument(args, 0);
     video_rectangle_draw_block(rect, ptr, absx, absy, total_rows, pixels_per_row);
     return 0;
 }
 
-void *isr80h_command12_video_rectangle_draw_blocks(struct interrupt_frame *frame)
+void *isr80h_command12_video_rectangle_draw_blocks(struct isr80h_arguments *args)
 {
-    int total = (int)task_current_get_stack_item_uint(6);
-    int pixels_per_row = (int)task_current_get_stack_item_uint(5);
-    int total_rows = (int)task_current_get_stack_item_uint(4);
-    int absy = (int)task_current_get_stack_item_uint(3);
-    int absx = (int)task_current_get_stack_item_uint(2);
-    void *ptr = task_current_get_stack_item(1);
-    struct video_rectangle *rect = task_current_get_stack_item(0);
+    int total = (int)isr80h_argument_uint(args, 6);
+    int pixels_per_row = (int)isr80h_argument_uint(args, 5);
+    int total_rows = (int)isr80h_argument_uint(args, 4);
+    int absy = (int)isr80h_argument_uint(args, 3);
+    int absx = (int)isr80h_argument_uint(args, 2);
+    void *ptr = isr80h_argument(args, 1);
+    struct video_rectangle *rect = isr80h_argument(args, 0);
     video_rectangle_draw_blocks(rect, ptr, absx, absy, total_rows, pixels_per_row, total);
     return 0;
 }
 
-void *isr80h_command16_rectangle_draw_font_data(struct interrupt_frame *frame)
+void *isr80h_command16_rectangle_draw_font_data(struct isr80h_arguments *args)
 {
-    int total = (int)task_current_get_stack_item_uint(0);
-    int absy = (int)task_current_get_stack_item_uint(1);
-    int absx = (int)task_current_get_stack_item_uint(2);
-    void *ptr = task_current_get_stack_item(3);
-    struct video_font *font = task_current_get_stack_item(4);
-    struct video_rectangle *rect = task_current_get_stack_item(5);
+    int total = (int)isr80h_argument_uint(args, 0);
+    int absy = (int)isr80h_argument_uint(args, 1);
+    int absx = (int)isr80h_argument_uint(args, 2);
+    void *ptr = isr80h_argument(args, 3);
+    struct video_font *font = isr80h_argument(args, 4);
+    struct video_rectangle *rect = isr80h_argument(args, 5);
 
     video_rectangle_draw_font_data(rect, font, ptr, absx, absy, total);
     return 0;
 }
 
-void* isr80h_command17_rectangle_publish(struct interrupt_frame* frame)
+void* isr80h_command17_rectangle_publish(struct isr80h_arguments *args)
 {
-    void* user_space_rectangle_name = task_current_get_stack_item(0);
-    void* video_rect_addr = task_current_get_stack_item(1);
+    void* user_space_rectangle_name = isr80h_argument(args, 0);
+    void* video_rect_addr = isr80h_argument(args, 1);
 
     char buf[1024];
     copy_string_from_task(task_current(), user_space_rectangle_name, buf, sizeof(buf));
     return (void*) video_rectangle_publish(buf, video_rect_addr);
 }
 
-void* isr80h_command18_rectangle_get(struct interrupt_frame* frame)
+void* isr80h_command18_rectangle_get(struct isr80h_arguments *args)
 {
-    void* user_space_rectangle_name = task_current_get_stack_item(0);
+    void* user_space_rectangle_name = isr80h_argument(args, 0);
     char buf[1024];
     copy_string_from_task(task_current(), user_space_rectangle_name, buf, sizeof(buf));
     return (void*) video_rectangle_get(buf);
 }
 
-void* isr80h_command20_video_buffer_flush(struct interrupt_frame* frame)
+void* isr80h_command20_video_buffer_flush(struct isr80h_arguments *args)
 {
     // Set the flush flag so the buffer is flushed on the next draw cycle
     video_draw(task_current()->process->video);
     return 0;
 }
 
-void* isr80h_command21_video_clear_flag(struct interrupt_frame* frame)
+void* isr80h_command21_video_clear_flag(struct isr80h_arguments *args)
 {
-    int flag = (int)task_current_get_stack_item_uint(0);
+    int flag = (int)isr80h_argument_uint(args, 0);
     task_current()->process->video->flags &= ~flag;
     return 0;
 }
\ No newline at end of file
@@ -7,6 +7,7 @@
 #include "fs/pparser.h"
 #include "disk/disk.h"
 #include "disk/streamer.h"
+#include "disk/cache.h"
 #include "fs/fat/fat16.h"
 #include "io/io.h"
 #include "idt/idt.h"
@@ -23,8 +24,13 @@
 #include "task/task.h"
 #include "task/tss.h"
 #include "task/process.h"
+#include "task/kthread.h"
+#include "timer/clock.h"
 #include "video/font/formats/psffont.h"
 #include "gdt/gdt.h"
+#include "smp/smp.h"
+#include "cpu/fpu.h"
+#include "pci/pci.h"
 #include "config.h"
 void kernel_registers();
 
@@ -115,14 +121,21 @@ void kernel_main(void)
 	kernel_terminal_initialize();
 
 	memset(gdt_real, 0, sizeof(gdt_real));
+	smp_gdt_init(gdt_structured);
 	gdt_structured_to_gdt(gdt_real, gdt_structured, COS32_TOTAL_GDT_SEGMENTS);
 
 	// Load our new GDT
 	gdt_load(gdt_real, sizeof(struct gdt) * COS32_TOTAL_GDT_SEGMENTS);
 
+	// Calibrate the high resolution clock against the PIT, the timer depends on it
+	clock_init();
+
 	// Initialize interrupts
 	idt_init();
 
+	// Tasks may use the FPU and SSE from now on
+	fpu_init();
+
 	// Setup TSS
 	memset(&tss, 0, sizeof(tss));
 	tss.ss0 = COS32_DATA_SELECTOR;
@@ -131,9 +144,15 @@ void kernel_main(void)
 	// Load the TSS
 	tss_load(0x28);
 
+	// System calls made with SYSENTER use the same kernel stack as interrupts
+	idt_sysenter_init(tss.esp0);
+
 	// Initialize the heap
 	kheap_init();
 
+	// Initialize the task schedulers
+	task_scheduler_init();
+
 	// Initialize all the keyboards
 	keyboard_init();
 
@@ -143,6 +162,9 @@ void kernel_main(void)
 	// Initialize filesystems
 	fs_init();
 
+	// Find the devices on the PCI buses, the disk drivers look for their controllers here
+	pci_init();
+
 	// Find the disks
 	disk_search_and_init();
 
@@ -162,6 +184,16 @@ void kernel_main(void)
 
 	isr80h_register_all();
 
+	// Start the kernel threads, background work is done here rather than in interrupts
+	kthread_init();
+	video_compositor_start();
+	paging_worker_start();
+	disk_cache_flusher_start();
+
+	// Other processors wait for the kernel lock, running the first task releases it
+	smp_lock_kernel();
+	smp_init();
+
 
 	print("Kernel initialized\n");
 	
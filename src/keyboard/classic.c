@@ -1,6 +1,7 @@
 #include "classic.h"
 #include "memory/memory.h"
 #include "idt/idt.h"
+#include "idt/controller.h"
 #include "io/io.h"
 #include "status.h"
 #include "kernel.h"
@@ -252,6 +253,7 @@ int classic_keyboard_init()
 
     // Let's create an interrupt listener for the keyboard interrupt
     idt_register_interrupt_callback(ISR_KEYBOARD_INTERRUPT, classic_keyboard_handle_interrupt);
+    interrupt_controller_enable_irq(INTERRUPT_CONTROLLER_IRQ_KEYBOARD);
 
     print("Classic Keyboard Initialized\n");
     return 0;
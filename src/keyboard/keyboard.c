@@ -134,10 +134,32 @@ void keyboard_push(char c)
     process->keyboard.buffer[real_index] = c;
     process->keyboard.tail++;
 
+    if (process->keyboard.waiting_task)
+    {
+        // The waiting task will see zero as the result of its wait and then ask for the key again
+        struct task *task = process->keyboard.waiting_task;
+        process->keyboard.waiting_task = 0;
+        task->registers.eax = 0;
+        task_wake_interactive(task);
+    }
+
     // Let all the keyboard listeners know about this key press
     keyboard_listener_keypressed(c);
 }
 
+int keyboard_wait(struct task *task)
+{
+    struct process *process = task->process;
+    if (process->keyboard.waiting_task)
+    {
+        return -EISTKN;
+    }
+
+    process->keyboard.waiting_task = task;
+    task_pause(task);
+    return 0;
+}
+
 char keyboard_pop()
 {
     // We don't allow keyboard access when no task is running
@@ -27,6 +27,8 @@ enum SpecialKeys
 #define KEYBOARD_TOTAL_SPECIAL_KEYS 17
 #define KEYBOARD_INPUT_PORT 0x60
 
+struct task;
+
 typedef int (*KEYBOARD_INIT_FUNCTION)();
 struct keyboard
 {
@@ -68,6 +70,11 @@ bool keyboard_is_special_on(enum SpecialKeys c);
  */
 char keyboard_pop();
 
+/**
+ * Puts the given task to sleep until a key is pushed to its process. Returns below zero if another task is already waiting
+ */
+int keyboard_wait(struct task *task);
+
 void keyboard_init();
 
 #endif
\ No newline at end of file
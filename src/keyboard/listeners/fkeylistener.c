@@ -15,8 +15,15 @@ static struct keyboard_listener listener = {
     .keypress = fkeylistener_keypress,
     .special = fkeylistener_special};
 
+// The id of the shell process each function key switches to, -1 until the key is first pressed
+static int console_process_ids[FKEYLISTENER_TOTAL_CONSOLES];
+
 void fkeylistener_init()
 {
+    for (int i = 0; i < FKEYLISTENER_TOTAL_CONSOLES; i++)
+    {
+        console_process_ids[i] = -1;
+    }
     keyboard_listener_register(&listener);
 }
 
@@ -38,19 +45,22 @@ void fkeylistener_special(enum SpecialKeys key)
     int res = 0;
     if (is_released)
     {
-        res = process_load_for_slot("0:/bin/shell.e", &process, key, 0, 0);
-        if (res == -EISTKN)
+        int console = key - F1_PRESSED_OR_RELEASED;
+        process = process_get(console_process_ids[console]);
+        if (process)
         {
-            process = process_get(key);
             process_switch(process);
             return;
         }
 
+        // The console has no shell yet or its shell has gone away
+        res = process_load("0:/bin/shell.e", &process, 0, 0);
         if (res < 0)
         {
             print("Fatal error loading the process\n");
             return;
         }
+        console_process_ids[console] = process->id;
         process_start(process);
     }
 }
\ No newline at end of file
@@ -1,6 +1,9 @@
 #ifndef FKEYLISTENER_H
 #define FKEYLISTENER_H
 
+// Each of F1 to F12 has its own shell
+#define FKEYLISTENER_TOTAL_CONSOLES 12
+
 /**
  * Listens for function key presses and switches the process when it receives them
  */
@@ -2,6 +2,7 @@
 #include "heap.h"
 #include "memory/memory.h"
 #include "kernel.h"
+#include "smp/spinlock.h"
 
 struct heap kernel_heap;
 
@@ -10,6 +11,9 @@ struct heap kernel_heap;
 
 struct heap_table kernel_heap_table;
 
+// Most callers already hold the kernel lock but the heap must also be safe while processors start
+static struct spinlock kernel_heap_lock;
+
 void kheap_init()
 {
     // We want a kernel heap that has 200MB of storage
@@ -29,7 +33,9 @@ void kheap_init()
 
 void *kmalloc(int size)
 {
+    spinlock_lock(&kernel_heap_lock);
     void *ptr = heap_malloc(&kernel_heap, size);
+    spinlock_unlock(&kernel_heap_lock);
     return ptr;
 }
 
@@ -46,5 +52,7 @@ void kfree(void *ptr)
     if (!ptr)
         return;
 
-    return heap_free(&kernel_heap, ptr);
+    spinlock_lock(&kernel_heap_lock);
+    heap_free(&kernel_heap, ptr);
+    spinlock_unlock(&kernel_heap_lock);
 }
\ No newline at end of file
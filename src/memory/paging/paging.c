@@ -5,6 +5,9 @@
 #include "memory/memory.h"
 #include "task/task.h"
 #include "task/process.h"
+#include "task/kthread.h"
+#include "smp/smp.h"
+#include "idt/idt.h"
 #include "string/string.h"
 #include "memory/registers.h"
 #include "kernel.h"
@@ -16,6 +19,12 @@ static struct paging_4gb_chunk *current_chunk = 0;
 
 static struct paging_fault_handler *fault_handlers[COS32_MAX_PAGING_FAULT_HANDLERS];
 
+// The paging worker kernel thread, it only runs once a fault has been registered
+static struct task *paging_worker_task = 0;
+
+// True if faults were registered since the paging worker last processed the queues
+static bool paging_faults_pending = false;
+
 static bool paging_process_live_fault(struct paging_fault *fault);
 static void paging_process_past_fault(struct paging_fault *fault);
 
@@ -29,6 +38,41 @@ void paging_process(struct paging_4gb_chunk *chunk)
     paging_process_fault_queue(chunk);
 }
 
+static void paging_worker(void *arg)
+{
+    while (1)
+    {
+        // The kernel is not re-entrant, we must not be interrupted whilst processing
+        disable_interrupts();
+        smp_lock_kernel();
+        if (!paging_faults_pending)
+        {
+            // paging_register_fault wakes us
+            kthread_wait();
+            continue;
+        }
+
+        paging_faults_pending = false;
+        paging_process(kernel_page_get_chunk());
+        struct process *process = process_current();
+        if (process)
+        {
+            paging_process(process->task->page_directory);
+        }
+        smp_unlock_kernel();
+        enable_interrupts();
+    }
+}
+
+void paging_worker_start()
+{
+    paging_worker_task = kthread_create("pager", paging_worker, 0);
+    if (ISERR(paging_worker_task))
+    {
+        panic("Failed to start the paging worker\n");
+    }
+}
+
 // FIx the magic numbers.....
 
 struct paging_4gb_chunk *paging_new_4gb(uint8_t flags)
@@ -106,6 +150,12 @@ struct paging_fault *paging_register_fault(struct paging_4gb_chunk *chunk, void
     }
 
     fault->address = address;
+    paging_faults_pending = true;
+    if (paging_worker_task)
+    {
+        task_wake(paging_worker_task);
+    }
+
     if (chunk->faults == 0)
     {
         chunk->faults = fault;
@@ -115,7 +165,6 @@ struct paging_fault *paging_register_fault(struct paging_4gb_chunk *chunk, void
 
     chunk->last_fault->next = fault;
     chunk->last_fault = fault;
-
     return fault;
 }
 
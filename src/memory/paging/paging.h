@@ -69,6 +69,11 @@ void paging_init();
  */
 void paging_process(struct paging_4gb_chunk* chunk);
 
+/**
+ * Starts the kernel thread that processes the paging fault queues
+ */
+void paging_worker_start();
+
 struct paging_4gb_chunk *paging_new_4gb(uint8_t flags);
 
 void paging_register_fault_handler(struct paging_fault_handler *handler);
@@ -0,0 +1,222 @@
+#include "pci.h"
+#include "io/io.h"
+#include "idt/idt.h"
+#include "idt/controller.h"
+#include "memory/memory.h"
+#include "config.h"
+#include "status.h"
+
+// Every function found on every bus, the devices are fixed once we have booted
+static struct pci_device devices[COS32_MAX_PCI_DEVICES];
+static int total_devices = 0;
+
+struct pci_interrupt_handler
+{
+    int irq;
+    PCI_INTERRUPT_FUNCTION handler;
+    void *private;
+};
+
+static struct pci_interrupt_handler interrupt_handlers[COS32_MAX_PCI_INTERRUPT_HANDLERS];
+static int total_interrupt_handlers = 0;
+
+static uint32_t pci_config_address(uint8_t bus, uint8_t slot, uint8_t function, uint8_t offset)
+{
+    return PCI_CONFIG_ENABLE | ((uint32_t)bus << 16) | ((uint32_t)slot << 11) | ((uint32_t)function << 8) | (offset & 0xFC);
+}
+
+static uint32_t pci_config_read_at(uint8_t bus, uint8_t slot, uint8_t function, uint8_t offset)
+{
+    outl(PCI_CONFIG_ADDRESS, pci_config_address(bus, slot, function, offset));
+    return insl(PCI_CONFIG_DATA);
+}
+
+uint32_t pci_config_read(struct pci_device *device, uint8_t offset)
+{
+    return pci_config_read_at(device->bus, device->slot, device->function, offset);
+}
+
+void pci_config_write(struct pci_device *device, uint8_t offset, uint32_t value)
+{
+    outl(PCI_CONFIG_ADDRESS, pci_config_address(device->bus, device->slot, device->function, offset));
+    outl(PCI_CONFIG_DATA, value);
+}
+
+/**
+ * Fills in "device" from the function's configuration space, returns false if there is no such function
+ */
+static bool pci_probe(uint8_t bus, uint8_t slot, uint8_t function, struct pci_device *device)
+{
+    uint32_t id = pci_config_read_at(bus, slot, function, PCI_REGISTER_VENDOR_ID);
+    if ((id & 0xFFFF) == PCI_VENDOR_NONE)
+    {
+        return false;
+    }
+
+    uint32_t class = pci_config_read_at(bus, slot, function, PCI_REGISTER_CLASS);
+    device->bus = bus;
+    device->slot = slot;
+    device->function = function;
+    device->vendor_id = id & 0xFFFF;
+    device->device_id = id >> 16;
+    device->class_code = class >> 24;
+    device->subclass = (class >> 16) & 0xFF;
+    device->prog_if = (class >> 8) & 0xFF;
+    device->interrupt_line = pci_config_read_at(bus, slot, function, PCI_REGISTER_INTERRUPT_LINE) & 0xFF;
+    return true;
+}
+
+void pci_init()
+{
+    memset(devices, 0, sizeof(devices));
+    memset(interrupt_handlers, 0, sizeof(interrupt_handlers));
+    total_devices = 0;
+    total_interrupt_handlers = 0;
+
+    for (int bus = 0; bus < PCI_MAX_BUSES; bus++)
+    {
+        for (int slot = 0; slot < PCI_MAX_SLOTS; slot++)
+        {
+            for (int function = 0; function < PCI_MAX_FUNCTIONS; function++)
+            {
+                struct pci_device device;
+                if (!pci_probe(bus, slot, function, &device))
+                {
+                    // Without function zero there is nothing else in the slot
+                    if (function == 0)
+                    {
+                        break;
+                    }
+                    continue;
+                }
+
+                if (total_devices == COS32_MAX_PCI_DEVICES)
+                {
+                    return;
+                }
+                devices[total_devices++] = device;
+
+                uint32_t header = pci_config_read_at(bus, slot, 0, PCI_REGISTER_HEADER_TYPE) >> 16;
+                if (function == 0 && !(header & PCI_HEADER_TYPE_MULTIFUNCTION))
+                {
+                    break;
+                }
+            }
+        }
+    }
+}
+
+int pci_total()
+{
+    return total_devices;
+}
+
+struct pci_device *pci_get(int index)
+{
+    if (index < 0 || index >= total_devices)
+    {
+        return 0;
+    }
+
+    return &devices[index];
+}
+
+int pci_find_class(uint8_t class_code, uint8_t subclass, struct pci_device *device)
+{
+    for (int i = 0; i < total_devices; i++)
+    {
+        if (devices[i].class_code == class_code && devices[i].subclass == subclass)
+        {
+            *device = devices[i];
+            return 0;
+        }
+    }
+
+    return -EIO;
+}
+
+int pci_find_device(uint16_t vendor_id, uint16_t device_id, int start)
+{
+    for (int i = start + 1; i < total_devices; i++)
+    {
+        if (devices[i].vendor_id == vendor_id && devices[i].device_id == device_id)
+        {
+            return i;
+        }
+    }
+
+    return -EIO;
+}
+
+uint32_t pci_bar(struct pci_device *device, int index)
+{
+    uint32_t bar = pci_config_read(device, PCI_REGISTER_BAR0 + index * sizeof(uint32_t));
+    if (bar & PCI_BAR_IO)
+    {
+        return bar & PCI_BAR_IO_MASK;
+    }
+    return bar & PCI_BAR_MEMORY_MASK;
+}
+
+bool pci_bar_is_io(struct pci_device *device, int index)
+{
+    return pci_config_read(device, PCI_REGISTER_BAR0 + index * sizeof(uint32_t)) & PCI_BAR_IO;
+}
+
+void pci_enable_bus_master(struct pci_device *device)
+{
+    uint32_t command = pci_config_read(device, PCI_REGISTER_COMMAND);
+    // The upper half is the status register whose bits are cleared by writing ones to them
+    pci_config_write(device, PCI_REGISTER_COMMAND, (command & 0xFFFF) | PCI_COMMAND_IO | PCI_COMMAND_MEMORY | PCI_COMMAND_BUS_MASTER);
+}
+
+static void pci_interrupt(int interrupt)
+{
+    int irq = interrupt - INTERRUPT_CONTROLLER_IRQ_BASE;
+    for (int i = 0; i < total_interrupt_handlers; i++)
+    {
+        if (interrupt_handlers[i].irq == irq)
+        {
+            interrupt_handlers[i].handler(interrupt_handlers[i].private);
+        }
+    }
+}
+
+int pci_register_interrupt(struct pci_device *device, PCI_INTERRUPT_FUNCTION handler, void *private)
+{
+    int res = 0;
+
+    // The firmware leaves 0xFF when the device's pin isn't connected
+    int irq = device->interrupt_line;
+    if (irq >= INTERRUPT_CONTROLLER_TOTAL_IRQS)
+    {
+        res = -EIO;
+        goto out;
+    }
+
+    if (total_interrupt_handlers == COS32_MAX_PCI_INTERRUPT_HANDLERS)
+    {
+        res = -ENOMEM;
+        goto out;
+    }
+
+    res = idt_register_interrupt_callback(INTERRUPT_CONTROLLER_IRQ_BASE + irq, pci_interrupt);
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    struct pci_interrupt_handler *interrupt_handler = &interrupt_handlers[total_interrupt_handlers++];
+    interrupt_handler->irq = irq;
+    interrupt_handler->handler = handler;
+    interrupt_handler->private = private;
+    res = interrupt_controller_enable_pci_irq(irq);
+    if (res < 0)
+    {
+        total_interrupt_handlers--;
+        goto out;
+    }
+
+out:
+    return res;
+}
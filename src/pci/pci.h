@@ -0,0 +1,118 @@
+#ifndef PCI_H
+#define PCI_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Configuration space is reached by writing the address of a register then accessing the data port
+#define PCI_CONFIG_ADDRESS 0xCF8
+#define PCI_CONFIG_DATA 0xCFC
+#define PCI_CONFIG_ENABLE 0x80000000
+
+#define PCI_MAX_BUSES 256
+#define PCI_MAX_SLOTS 32
+#define PCI_MAX_FUNCTIONS 8
+
+// Configuration space registers
+#define PCI_REGISTER_VENDOR_ID 0x00
+#define PCI_REGISTER_COMMAND 0x04
+#define PCI_REGISTER_CLASS 0x08
+#define PCI_REGISTER_HEADER_TYPE 0x0C
+#define PCI_REGISTER_BAR0 0x10
+#define PCI_REGISTER_INTERRUPT_LINE 0x3C
+
+// Read back as the vendor when nothing is in the slot
+#define PCI_VENDOR_NONE 0xFFFF
+
+#define PCI_HEADER_TYPE_MULTIFUNCTION 0x80
+
+#define PCI_COMMAND_IO 0x01
+#define PCI_COMMAND_MEMORY 0x02
+#define PCI_COMMAND_BUS_MASTER 0x04
+
+// Set in a BAR that addresses I/O ports rather than memory
+#define PCI_BAR_IO 0x01
+#define PCI_BAR_IO_MASK 0xFFFFFFFC
+#define PCI_BAR_MEMORY_MASK 0xFFFFFFF0
+#define PCI_TOTAL_BARS 6
+
+#define PCI_CLASS_MASS_STORAGE 0x01
+#define PCI_SUBCLASS_IDE 0x01
+#define PCI_SUBCLASS_SATA 0x06
+#define PCI_PROG_IF_AHCI 0x01
+
+/**
+ * Called when the interrupt line of a device is raised, the line may be shared with other devices
+ */
+typedef void (*PCI_INTERRUPT_FUNCTION)(void *private);
+
+struct pci_device
+{
+    uint8_t bus;
+    uint8_t slot;
+    uint8_t function;
+
+    uint16_t vendor_id;
+    uint16_t device_id;
+
+    uint8_t class_code;
+    uint8_t subclass;
+    uint8_t prog_if;
+
+    // The legacy IRQ the firmware routed the device's interrupt pin to
+    uint8_t interrupt_line;
+};
+
+uint32_t pci_config_read(struct pci_device *device, uint8_t offset);
+void pci_config_write(struct pci_device *device, uint8_t offset, uint32_t value);
+
+/**
+ * Finds every function on every bus, must be called before any device is looked up
+ */
+void pci_init();
+
+/**
+ * Returns the amount of devices found by pci_init
+ */
+int pci_total();
+
+/**
+ * Returns the device at the given index, NULL if there is no such device
+ */
+struct pci_device *pci_get(int index);
+
+/**
+ * Finds the first device with the given class and subclass.
+ * Returns zero and fills in "device" if one was found
+ */
+int pci_find_class(uint8_t class_code, uint8_t subclass, struct pci_device *device);
+
+/**
+ * Finds the device with the given vendor and device id after the device at index "start", pass -1 to search from the first.
+ * Returns the index of the device found or an error
+ */
+int pci_find_device(uint16_t vendor_id, uint16_t device_id, int start);
+
+/**
+ * Returns the address in the given base address register with its type bits removed
+ */
+uint32_t pci_bar(struct pci_device *device, int index);
+
+/**
+ * Returns true if the given base address register addresses I/O ports
+ */
+bool pci_bar_is_io(struct pci_device *device, int index);
+
+/**
+ * Turns on the device's I/O and memory decoding and lets it read and write memory by itself, needed before it can do DMA
+ */
+void pci_enable_bus_master(struct pci_device *device);
+
+/**
+ * Calls "handler" with "private" whenever the device's interrupt line is raised. Lines are shared so the handler
+ * must check its device really interrupted. Returns an error if the device has no line, the line can't be routed
+ * to us or no handlers are free, the driver must then poll the device
+ */
+int pci_register_interrupt(struct pci_device *device, PCI_INTERRUPT_FUNCTION handler, void *private);
+
+#endif
@@ -0,0 +1,136 @@
+#include "diskbench.h"
+#include "cos32.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include <stddef.h>
+
+static char buffer[COS32_DISK_READ_MAX_SECTORS * COS32_SECTOR_SIZE];
+static unsigned int random_state = 12345;
+
+/**
+ * Divides without the 64 bit division routines we don't link against, the result must fit into 32 bits
+ */
+static unsigned int diskbench_divide(unsigned long long dividend, unsigned int divisor)
+{
+    unsigned long long remainder = 0;
+    unsigned int result = 0;
+    for (int i = 63; i >= 0; i--)
+    {
+        remainder = (remainder << 1) | ((dividend >> i) & 1);
+        result <<= 1;
+        if (remainder >= divisor)
+        {
+            remainder -= divisor;
+            result |= 1;
+        }
+    }
+    return result;
+}
+
+static unsigned int diskbench_random()
+{
+    random_state = random_state * 1103515245 + 12345;
+    return random_state >> 8;
+}
+
+static unsigned int diskbench_elapsed_us(unsigned long long start)
+{
+    unsigned int us = diskbench_divide(cos32_clock_ns() - start, 1000);
+    return us ? us : 1;
+}
+
+static int diskbench_sequential(int disk_id, unsigned int sectors)
+{
+    unsigned long long start = cos32_clock_ns();
+    for (unsigned int lba = 0; lba + DISKBENCH_SEQUENTIAL_SECTORS <= sectors; lba += DISKBENCH_SEQUENTIAL_SECTORS)
+    {
+        int res = cos32_disk_read(disk_id, lba, DISKBENCH_SEQUENTIAL_SECTORS, buffer);
+        if (res < 0)
+        {
+            return res;
+        }
+    }
+
+    unsigned int us = diskbench_elapsed_us(start);
+    unsigned int kb = sectors / DISKBENCH_SEQUENTIAL_SECTORS * DISKBENCH_SEQUENTIAL_SECTORS * COS32_SECTOR_SIZE / 1024;
+    printf("  sequential: %i KB in %i us, %i KB/s\n", kb, us, diskbench_divide((unsigned long long)kb * 1000000, us));
+    return 0;
+}
+
+static int diskbench_random_reads(int disk_id, unsigned int sectors)
+{
+    unsigned int positions = sectors / DISKBENCH_RANDOM_SECTORS;
+    unsigned long long start = cos32_clock_ns();
+    for (int i = 0; i < DISKBENCH_RANDOM_READS; i++)
+    {
+        unsigned int lba = (diskbench_random() % positions) * DISKBENCH_RANDOM_SECTORS;
+        int res = cos32_disk_read(disk_id, lba, DISKBENCH_RANDOM_SECTORS, buffer);
+        if (res < 0)
+        {
+            return res;
+        }
+    }
+
+    unsigned int us = diskbench_elapsed_us(start);
+    printf("  random: %i reads of %i KB in %i us, %i reads/s, %i us each\n", DISKBENCH_RANDOM_READS, DISKBENCH_RANDOM_SECTORS * COS32_SECTOR_SIZE / 1024, us,
+           diskbench_divide((unsigned long long)DISKBENCH_RANDOM_READS * 1000000, us), us / DISKBENCH_RANDOM_READS);
+    return 0;
+}
+
+static void diskbench_queue_statistics(int disk_id)
+{
+    struct cos32_disk_queue_statistics statistics;
+    if (cos32_disk_queue_statistics(disk_id, &statistics) < 0)
+    {
+        return;
+    }
+
+    printf("  queue: depth %i, %i bios, %i merged, %i requests, %i errors, %i sectors\n", statistics.depth, statistics.bios, statistics.merges,
+           statistics.requests, statistics.errors, statistics.sectors);
+    printf("  queue: most pending %i, most in flight %i, driver busy %i times\n", statistics.max_pending, statistics.max_in_flight, statistics.busy);
+}
+
+static unsigned int diskbench_parse_number(const char *str)
+{
+    unsigned int number = 0;
+    while (*str >= '0' && *str <= '9')
+    {
+        number = number * 10 + (*str - '0');
+        str++;
+    }
+    return number;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned int sectors = DISKBENCH_DEFAULT_SECTORS;
+    if (argc > 1)
+    {
+        sectors = diskbench_parse_number(argv[1]);
+    }
+
+    if (sectors < DISKBENCH_SEQUENTIAL_SECTORS)
+    {
+        sectors = DISKBENCH_SEQUENTIAL_SECTORS;
+    }
+
+    for (int disk_id = 0; disk_id < DISKBENCH_MAX_DISKS; disk_id++)
+    {
+        // Disks are numbered from zero without gaps, the first we can't read is past the last disk
+        if (cos32_disk_read(disk_id, 0, 1, buffer) < 0)
+        {
+            break;
+        }
+
+        printf("disk %i over %i sectors\n", disk_id, sectors);
+        if (diskbench_sequential(disk_id, sectors) < 0 || diskbench_random_reads(disk_id, sectors) < 0)
+        {
+            printf("  failed to read the disk, is it smaller than %i sectors?\n", sectors);
+        }
+        diskbench_queue_statistics(disk_id);
+    }
+
+    while (1)
+    {
+    }
+}
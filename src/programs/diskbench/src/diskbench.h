@@ -0,0 +1,17 @@
+#ifndef DISKBENCH_H
+#define DISKBENCH_H
+
+// The sectors read by default, eight megabytes
+#define DISKBENCH_DEFAULT_SECTORS 16384
+
+// The sectors of each sequential read
+#define DISKBENCH_SEQUENTIAL_SECTORS 128
+
+// The sectors of each random read and how many random reads we do
+#define DISKBENCH_RANDOM_SECTORS 8
+#define DISKBENCH_RANDOM_READS 512
+
+// We stop looking for disks after this many
+#define DISKBENCH_MAX_DISKS 8
+
+#endif
@@ -1,5 +1,4 @@
 #include "cos32.h"
-int start_get_arguments(struct process_arguments* arguments);
 
 int main(int argc, char** argv);
 
@@ -11,7 +10,6 @@ int main(int argc, char** argv);
  */
 int start_c_func()
 {
-    struct process_arguments arguments;
-    start_get_arguments(&arguments);
-    return main(arguments.argc, arguments.argv);
+    // The kernel shares our arguments through the info page so we need no system call
+    return main(COS32_INFO_PAGE->argc, COS32_INFO_PAGE->argv);
 }
\ No newline at end of file
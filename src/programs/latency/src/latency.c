@@ -0,0 +1,95 @@
+#include "latency.h"
+#include "cos32.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+#include <stddef.h>
+
+struct latency_result
+{
+    unsigned int average;
+    unsigned int max;
+};
+
+// True whilst the CPU bound threads should keep spinning
+static volatile bool running = false;
+
+static int latency_cpu_bound(void *arg)
+{
+    volatile unsigned int counter = 0;
+    while (running)
+    {
+        counter++;
+    }
+    return 0;
+}
+
+/**
+ * Sleeps for the shortest time possible and measures how long it takes before we run again
+ */
+static void latency_measure(struct latency_result *result)
+{
+    unsigned int total = 0;
+    result->max = 0;
+    for (int i = 0; i < LATENCY_SAMPLES; i++)
+    {
+        unsigned long long start = cos32_clock_ns();
+        cos32_sleep(0);
+        // A single sleep is far shorter than four seconds so the difference fits into 32 bits
+        unsigned int elapsed = (unsigned int)(cos32_clock_ns() - start) / 1000;
+        total += elapsed;
+        if (elapsed > result->max)
+        {
+            result->max = elapsed;
+        }
+    }
+    result->average = total / LATENCY_SAMPLES;
+}
+
+static int latency_run(const char *scheduler)
+{
+    int threads[LATENCY_CPU_BOUND_THREADS];
+    struct latency_result idle;
+    struct latency_result loaded;
+
+    if (cos32_set_scheduler(scheduler) < 0)
+    {
+        printf("The scheduler %s does not exist\n", scheduler);
+        return -1;
+    }
+
+    latency_measure(&idle);
+
+    running = true;
+    for (int i = 0; i < LATENCY_CPU_BOUND_THREADS; i++)
+    {
+        threads[i] = cos32_thread_create(latency_cpu_bound, NULL);
+    }
+
+    latency_measure(&loaded);
+
+    running = false;
+    for (int i = 0; i < LATENCY_CPU_BOUND_THREADS; i++)
+    {
+        if (threads[i] >= 0)
+        {
+            cos32_thread_join(threads[i], 0);
+        }
+    }
+
+    printf("%s: idle avg=%i max=%i, loaded avg=%i max=%i\n", scheduler, idle.average, idle.max, loaded.average, loaded.max);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    printf("Wake up latency in microseconds with %i CPU bound threads\n", LATENCY_CPU_BOUND_THREADS);
+    latency_run("roundrobin");
+    latency_run("mlfq");
+
+    // Leave the system on the default scheduler
+    cos32_set_scheduler("mlfq");
+    while (1)
+    {
+    }
+}
@@ -0,0 +1,10 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+// The amount of CPU bound threads competing with the sleeping thread
+#define LATENCY_CPU_BOUND_THREADS 4
+
+// The amount of sleeps measured for each scheduler
+#define LATENCY_SAMPLES 50
+
+#endif
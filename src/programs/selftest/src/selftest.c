@@ -0,0 +1,106 @@
+#include "selftest.h"
+#include "cos32.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+#include <stddef.h>
+
+static int failures = 0;
+
+static void selftest_result(const char *name, bool passed)
+{
+    printf("%s: %s\n", name, passed ? "pass" : "FAIL");
+    if (!passed)
+    {
+        failures++;
+    }
+}
+
+static struct task_info *selftest_find_task(struct task_info *tasks, int total, const char *name)
+{
+    for (int i = 0; i < total; i++)
+    {
+        // Kernel threads have no process
+        if (tasks[i].process_id < 0 && strncmp(tasks[i].name, name, TASK_INFO_NAME_SIZE) == 0)
+        {
+            return &tasks[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Kernel workers with nothing to do must sleep until they are woken rather than wake on every timer tick
+ */
+static void selftest_idle_workers()
+{
+    static struct task_info before[SELFTEST_MAX_TASKS];
+    static struct task_info after[SELFTEST_MAX_TASKS];
+    static const char *workers[] = {"pager", "flusher"};
+
+    int total_before = cos32_task_statistics(before, SELFTEST_MAX_TASKS);
+    cos32_sleep(SELFTEST_IDLE_WINDOW_MS);
+    int total_after = cos32_task_statistics(after, SELFTEST_MAX_TASKS);
+
+    bool passed = true;
+    int total_workers = sizeof(workers) / sizeof(workers[0]);
+    for (int i = 0; i < total_workers; i++)
+    {
+        struct task_info *first = selftest_find_task(before, total_before, workers[i]);
+        struct task_info *second = selftest_find_task(after, total_after, workers[i]);
+        if (!first || !second)
+        {
+            printf("  no %s kernel thread\n", workers[i]);
+            passed = false;
+            continue;
+        }
+
+        unsigned int switches = second->statistics.switches - first->statistics.switches;
+        if (switches > SELFTEST_IDLE_MAX_SWITCHES)
+        {
+            printf("  %s ran %i times in %ims\n", workers[i], switches, SELFTEST_IDLE_WINDOW_MS);
+            passed = false;
+        }
+    }
+
+    selftest_result("idle workers", passed);
+}
+
+static int selftest_stack_thread(void *arg)
+{
+    // Our exit code is an address on our own stack
+    volatile int local = 0;
+    volatile int *address = &local;
+    return (int)address;
+}
+
+/**
+ * The stack of a joined thread goes back to the kernel heap, the process must no longer be able to reach it
+ */
+static void selftest_joined_stack()
+{
+    int stack = 0;
+    int thread_id = cos32_thread_create(selftest_stack_thread, NULL);
+    if (thread_id < 0 || cos32_thread_join(thread_id, &stack) < 0)
+    {
+        selftest_result("joined stack", false);
+        return;
+    }
+
+    // The kernel refuses to write to memory we can't access. Were the stack still ours the kernel would write
+    // one entry into it, which is no worse than what we could already do ourselves
+    struct task_info *info = (struct task_info *)(stack & ~0xfff);
+    selftest_result("joined stack", cos32_task_statistics(info, 1) < 0);
+}
+
+int main(int argc, char **argv)
+{
+    selftest_idle_workers();
+    selftest_joined_stack();
+    printf("%i checks failed\n", failures);
+
+    while (1)
+    {
+    }
+}
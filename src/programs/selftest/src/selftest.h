@@ -0,0 +1,12 @@
+#ifndef SELFTEST_H
+#define SELFTEST_H
+
+#define SELFTEST_MAX_TASKS 32
+
+// How long the kernel threads are watched whilst they should have nothing to do
+#define SELFTEST_IDLE_WINDOW_MS 1000
+
+// A worker polling on every timer tick is switched to around 18 times a second
+#define SELFTEST_IDLE_MAX_SWITCHES 2
+
+#endif
@@ -0,0 +1,70 @@
+#include "smpbench.h"
+#include "cos32.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include <stddef.h>
+
+static int smpbench_worker(void *arg)
+{
+    unsigned int iterations = (unsigned int)arg;
+    volatile unsigned int counter = 0;
+    for (unsigned int i = 0; i < iterations; i++)
+    {
+        counter++;
+    }
+    return 0;
+}
+
+/**
+ * Runs the total work split between the given amount of threads and returns the time taken in microseconds
+ */
+static unsigned int smpbench_run(int total_threads)
+{
+    int threads[SMPBENCH_MAX_THREADS];
+    unsigned int iterations = SMPBENCH_TOTAL_WORK / total_threads;
+
+    unsigned long long start = cos32_clock_ns();
+    for (int i = 0; i < total_threads; i++)
+    {
+        threads[i] = cos32_thread_create(smpbench_worker, (void *)iterations);
+    }
+
+    for (int i = 0; i < total_threads; i++)
+    {
+        if (threads[i] >= 0)
+        {
+            cos32_thread_join(threads[i], 0);
+        }
+    }
+
+    // Shifting avoids a 64 bit division that we have no library for, it is within 3% of microseconds
+    return (unsigned int)((cos32_clock_ns() - start) >> 10);
+}
+
+int main(int argc, char **argv)
+{
+    unsigned int single = 0;
+    printf("Splitting %i iterations between threads\n", SMPBENCH_TOTAL_WORK);
+    for (int total_threads = 1; total_threads <= SMPBENCH_MAX_THREADS; total_threads *= 2)
+    {
+        unsigned int elapsed = smpbench_run(total_threads);
+        if (elapsed == 0)
+        {
+            elapsed = 1;
+        }
+
+        if (total_threads == 1)
+        {
+            single = elapsed;
+        }
+
+        // Speedup is shown with two decimal places
+        unsigned int speedup = single * 100 / elapsed;
+        printf("%i threads: time=%i throughput=%i speedup=%i.%i%i\n", total_threads, elapsed,
+               SMPBENCH_TOTAL_WORK / elapsed, speedup / 100, (speedup / 10) % 10, speedup % 10);
+    }
+
+    while (1)
+    {
+    }
+}
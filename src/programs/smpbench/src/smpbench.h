@@ -0,0 +1,10 @@
+#ifndef SMPBENCH_H
+#define SMPBENCH_H
+
+// The total loop iterations shared between the threads of every run
+#define SMPBENCH_TOTAL_WORK 100000000
+
+// The most threads a single run uses
+#define SMPBENCH_MAX_THREADS 8
+
+#endif
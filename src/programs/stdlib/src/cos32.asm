@@ -6,7 +6,6 @@ section .text
 
 global print:function
 global cos32_getkey:function
-global kernel_information:function
 global cos32_putchar:function
 global cos32_getkeyblock:function
 global cos32_malloc:function
@@ -23,25 +22,58 @@ global cos32_video_font_make_empty_string:function
 global cos32_video_rectangle_draw_font_data:function
 global cos32_video_rectangle_publish:function
 global cos32_video_rectangle_get:function
-global cos32_get_arguments:function
 global cos32_flush_video_buffer:function
 global cos32_video_clear_flag:function
+global cos32_thread_create:function
+global cos32_thread_exit:function
+global cos32_thread_join:function
+global cos32_set_priority:function
+global cos32_set_scheduler:function
+global cos32_task_statistics:function
+global cos32_clock_ns_kernel:function
+global cos32_null:function
+global cos32_null_int80:function
+global cos32_syscall_is_fast:function
+global cos32_trace:function
+global cos32_disk_cache_statistics:function
+global cos32_disk_read:function
+global cos32_disk_queue_statistics:function
+global cos32_sync:function
+global cos32_disk_write:function
+global cos32_batch_execute:function
+
+; Every system call goes through the entry chosen by cos32_syscall_detect with the command in EAX
+; and the arguments on the stack. ECX and EDX are not preserved
+%macro SYSCALL 0
+    call [cos32_syscall_entry]
+%endmacro
+
+; The same but with up to six arguments in EBX, ECX, EDX, ESI, EDI then EBP. The first register holds
+; the argument the kernel would find on top of the stack, so the last one pushed with SYSCALL
+%macro SYSCALL_REGS 0
+    or eax, ISR80H_REGISTER_ABI
+    call [cos32_syscall_regs_entry]
+%endmacro
+
+CPUID_FEATURE_EDX_SEP equ 0x800
+ISR80H_REGISTER_ABI equ 0x80000000
 
 ; WARNING AVOID USING ALL GENERAL PURPOSE REGISTERS EXCEPT EAX TO RETURN A RESULT
 ; I AM NOT SURE WHICH REGISTERS GCC RELIES ON THE VALUE BEING THE SAME
 ; HOWEVER EBX IS CONFIRMED.
 print:
+    push ebx
     mov eax, 1 ; Command 1 = Print
-    push dword [esp+4]  ; Push it to the stack
-    int 0x80 ; Invoke kernel to print
-    add esp, 4 ; Restore stack
+    mov ebx, [esp+8] ; The message to print
+    SYSCALL_REGS ; Invoke kernel to print
+    pop ebx
     ret
 
 cos32_getkey:
     push ebp
     mov ebp, esp
     mov eax, 2 ; Command 2 = Get key
-    int 0x80 ; Invoke COS32 kernel
+    SYSCALL_REGS ; Invoke COS32 kernel
     ; EAX contains the result
     pop ebp
     ret
@@ -50,95 +82,96 @@ cos32_getkeyblock:
     push ebp
     mov ebp, esp
 .try_again:
-    mov eax, 2 ; Command 2 = Get key
-    int 0x80
+    mov eax, 25 ; Command 25 = Get key, sleeping until a key is pressed
+    SYSCALL_REGS
     cmp eax, 0x00
     je .try_again
     pop ebp
     ret
 
-kernel_information:
-    push ebp
-    mov ebp, esp
-    mov eax, 3 ; Command 3 = Kernel information
-    push dword [ebp+8]
-    int 0x80
-    add esp, 4
-    pop ebp
-    ret
-
 cos32_putchar:
+    push ebx
     mov eax, 4 ; Command 4 = putchar write to stdout
-    push dword [esp+4]
-    int 0x80
-    add esp, 4
+    mov ebx, [esp+8]
+    SYSCALL_REGS
+    pop ebx
     ret
 
 
 cos32_malloc:
     push ebp
     mov ebp, esp
+    push ebx
     mov eax, 5 ; Command 5 = malloc for entire process
-    push dword [ebp+8] ; Size in bytes
-    int 0x80
-    add esp, 4
+    mov ebx, [ebp+8] ; Size in bytes
+    SYSCALL_REGS
+    pop ebx
     pop ebp
     ret
 
 cos32_invoke_command:
     push ebp
     mov ebp, esp
+    push ebx
     mov eax, 6 ; Command 6 = Invoke command. SYSTEM command essentially
-    push dword [ebp+8] ; The pointer to the "command_argument" structure
-    int 0x80
-    add esp, 4
+    mov ebx, [ebp+8] ; The pointer to the "command_argument" structure
+    SYSCALL_REGS
+    pop ebx
     pop ebp
     ret
 
 cos32_sleep:
     push ebp
     mov ebp, esp
+    push ebx
     mov eax, 7 ; Command 7 = Task sleep. The task is put to sleep
-    push dword [ebp+8] ; Total milli seconds to sleep for
-    int 0x80
-    add esp, 4
+    mov ebx, [ebp+8] ; Total milli seconds to sleep for
+    SYSCALL_REGS
+    pop ebx
     pop ebp
     ret
 
 cos32_video_rectangle_new:
     push ebp
     mov ebp, esp
+    push ebx
+    push esi
     mov eax, 8 ; Comamnd 8 = Video rectangle new. Creates a new video rectangle
-    push dword [ebp+8] ; X
-    push dword [ebp+12] ; Y
-    push dword [ebp+16] ; Width
-    push dword [ebp+20] ; Height
-    int 0x80
-    add esp, 16
+    mov esi, [ebp+8] ; X
+    mov edx, [ebp+12] ; Y
+    mov ecx, [ebp+16] ; Width
+    mov ebx, [ebp+20] ; Height
+    SYSCALL_REGS
+    pop esi
+    pop ebx
     pop ebp
     ret
 
 cos32_video_rectangle_set_pixel:
     push ebp
     mov ebp, esp
+    push ebx
+    push esi
     mov eax, 9 ; Command 9 = video set pixel. Sets a pixel in this rectangle
-    push dword [ebp+8] ; The video rectangle
-    push dword [ebp+12] ; X coordinate
-    push dword [ebp+16] ; Y Coordinate
-    push dword [ebp+20] ; The colour of the pixel
-    int 0x80
-    add esp, 16
+    mov esi, [ebp+8] ; The video rectangle
+    mov edx, [ebp+12] ; X coordinate
+    mov ecx, [ebp+16] ; Y Coordinate
+    mov ebx, [ebp+20] ; The colour of the pixel
+    SYSCALL_REGS
+    pop esi
+    pop ebx
     pop ebp
     ret
 
 cos32_video_rectangle_fill:
     push ebp
     mov ebp, esp
+    push ebx
     mov eax, 10 ; Command 10 = video fill. Fills the rectangle with a given colour
-    push dword [ebp+8] ; The video rectangle
-    push dword [ebp+12] ; The colour to fill the rectangle as
-    int 0x80
-    add esp, 8
+    mov ecx, [ebp+8] ; The video rectangle
+    mov ebx, [ebp+12] ; The colour to fill the rectangle as
+    SYSCALL_REGS
+    pop ebx
     pop ebp
     ret
 
@@ -146,15 +179,20 @@ cos32_video_rectangle_fill:
 cos32_video_rectangle_draw_block:
     push ebp
     mov ebp, esp
+    push ebx
+    push esi
+    push edi
     mov eax, 11 ; Command 11 draw rectangle block
-    push dword [ebp+8] ; The video rectangle
-    push dword [ebp+12] ; The pointer to the data to draw the block for
-    push dword [ebp+16] ; The absolute x position to draw on the rectangle
-    push dword [ebp+20] ; The absolute y position to draw on the rectangle
-    push dword [ebp+24]  ; The total rows to draw on the rectangle
-    push dword [ebp+28] ; THe pixels per row to draw
-    int 0x80
-    add esp, 24
+    mov edi, [ebp+12] ; The pointer to the data to draw the block for
+    mov esi, [ebp+16] ; The absolute x position to draw on the rectangle
+    mov edx, [ebp+20] ; The absolute y position to draw on the rectangle
+    mov ecx, [ebp+24]  ; The total rows to draw on the rectangle
+    mov ebx, [ebp+28] ; THe pixels per row to draw
+    mov ebp, [ebp+8] ; The video rectangle
+    SYSCALL_REGS
+    pop edi
+    pop esi
+    pop ebx
     pop ebp
     ret
 
@@ -162,6 +200,7 @@ cos32_video_rectangle_draw_block:
 cos32_video_rectangle_draw_blocks:
     push ebp
     mov ebp, esp
+    ; Seven arguments is more than fit into registers so this command still uses the stack
     mov eax, 12 ; Command 12 draw rectangle blocks 
     push dword [ebp+8] ; The video rectangle
     push dword [ebp+12] ; The pointer to the draw to draw the block for
@@ -170,7 +209,7 @@ cos32_video_rectangle_draw_blocks:
     push dword [ebp+24] ; The total rows to draw on the rectangle
     push dword [ebp+28] ; the pixels per row to draw
     push dword [ebp+32] ; THe total amount of pixel blocks in the provided array
-    int 0x80
+    SYSCALL
     add esp, 28
     pop ebp
     ret
@@ -178,49 +217,56 @@ cos32_video_rectangle_draw_blocks:
 cos32_video_font_get:
     push ebp
     mov ebp, esp
+    push ebx
     mov eax, 13 ; Command 13 get video font
     mov ebx, [ebp+8] ; The font name to load
-    push ebx
-    int 0x80
-    add esp, 4
+    SYSCALL_REGS
+    pop ebx
     pop ebp
     ret
 
 cos32_video_font_draw:
     push ebp
     mov ebp, esp
+    push ebx
     mov eax, 14 ; Command 14 Draw character pixel data into buffer
-    push dword [ebp+8] ; The pointer to the font
-    push dword [ebp+12] ; THe pointer to the buffer we wish to put the pixel data into
-    push dword [ebp+16] ; The pointer to the character array that we wish to draw as pixels
-    int 0x80
-    add esp, 12
+    mov edx, [ebp+8] ; The pointer to the font
+    mov ecx, [ebp+12] ; THe pointer to the buffer we wish to put the pixel data into
+    mov ebx, [ebp+16] ; The pointer to the character array that we wish to draw as pixels
+    SYSCALL_REGS
+    pop ebx
     pop ebp
     ret
 
 cos32_video_font_make_empty_string:
     push ebp
     mov ebp, esp
+    push ebx
     mov eax, 15 ; Command 15 create an empty string for font pixel data
-    push dword [ebp+8] ; A pointer to the font
-    push dword [ebp+12] ; THe pointer to the "len" integer specifying how many characters we need this buffer to store 
-    int 0x80
-    add esp, 8
+    mov ecx, [ebp+8] ; A pointer to the font
+    mov ebx, [ebp+12] ; THe pointer to the "len" integer specifying how many characters we need this buffer to store 
+    SYSCALL_REGS
+    pop ebx
     pop ebp
     ret
 
 cos32_video_rectangle_draw_font_data:
     push ebp
     mov ebp, esp
+    push ebx
+    push esi
+    push edi
     mov eax, 16 ; Command 16 draws the given font pixel data into the rectangle
-    push dword [ebp+8] ; Rectangle
-    push dword [ebp+12] ; FOnt : video_font
-    push dword [ebp+16] ; The pixel buffer that contains the pixel blocks
-    push dword [ebp+20] ; THe absolute x coordiante to tdraw in this rectangle
-    push dword [ebp+24] ; The absolute y coordinate to draw in this rectangle
-    push dword [ebp+28] ; The total number of pixel characters stored in the buffer
-    int 0x80
-    add esp, 24
+    mov edi, [ebp+12] ; FOnt : video_font
+    mov esi, [ebp+16] ; The pixel buffer that contains the pixel blocks
+    mov edx, [ebp+20] ; THe absolute x coordiante to tdraw in this rectangle
+    mov ecx, [ebp+24] ; The absolute y coordinate to draw in this rectangle
+    mov ebx, [ebp+28] ; The total number of pixel characters stored in the buffer
+    mov ebp, [ebp+8] ; Rectangle
+    SYSCALL_REGS
+    pop edi
+    pop esi
+    pop ebx
     pop ebp
     ret
 
@@ -228,11 +274,12 @@ cos32_video_rectangle_draw_font_data:
 cos32_video_rectangle_publish:
     push ebp
     mov ebp, esp
+    push ebx
     mov eax, 17 ; Command 17 publishes the given rectangle
-    push dword [ebp+8] ; The rectangle
-    push dword [ebp+12] ; The address of the name of the rectangle
-    int 0x80
-    add esp, 8
+    mov ecx, [ebp+8] ; The rectangle
+    mov ebx, [ebp+12] ; The address of the name of the rectangle
+    SYSCALL_REGS
+    pop ebx
     pop ebp
     ret
 
@@ -240,38 +287,299 @@ cos32_video_rectangle_publish:
 cos32_video_rectangle_get:
     push ebp
     mov ebp, esp
+    push ebx
     mov eax, 18 ; Command 18 get the published rectangle by name
-    push dword [ebp+8] ; The rectangle name
-    int 0x80
-    add esp, 4
+    mov ebx, [ebp+8] ; The rectangle name
+    SYSCALL_REGS
+    pop ebx
     pop ebp
     ret
 
-; int cos32_get_arguments(struct process_arguments* arguments);
-cos32_get_arguments:
+cos32_flush_video_buffer:
     push ebp
     mov ebp, esp
-    mov eax, 19 ; Command 19 get the process arguments, argc, and argv.
-    push dword [ebp+8] ; The process_arguments structure to be populated
-    int 0x80    ; Invoke the kernel!
-    add esp, 4
+    mov eax, 20 ; Command 20 flush the video buffer
+    SYSCALL_REGS
     pop ebp
     ret
 
-cos32_flush_video_buffer:
+cos32_video_clear_flag:
     push ebp
     mov ebp, esp
-    mov eax, 20 ; Command 20 flush the video buffer
-    int 0x80 ; Invoke the kernel!
+    push ebx
+    mov eax, 21 ; Command 21 clear video flag
+    mov ebx, [ebp+8]
+    SYSCALL_REGS
+    pop ebx
     pop ebp
     ret
 
-cos32_video_clear_flag:
+; int cos32_thread_create(int (*function)(void* arg), void* arg);
+cos32_thread_create:
     push ebp
     mov ebp, esp
-    mov eax, 21 ; Command 21 clear video flag
-    push dword [ebp+8]
+    push ebx
+    mov eax, 22 ; Command 22 create a thread sharing our address space
+    mov edx, [ebp+12] ; The argument to pass to the function
+    mov ecx, [ebp+8] ; The function the thread should run
+    mov ebx, cos32_thread_start ; Where the thread starts executing
+    SYSCALL_REGS
+    pop ebx
+    pop ebp
+    ret
+
+; New threads start here with the function and its argument on their stack
+cos32_thread_start:
+    pop eax ; The function to run, the argument is now on top of the stack
+    call eax
+    ; The function returned so we exit with its result
+    push eax
+    call cos32_thread_exit
+    ; We never return from exiting
+    jmp $
+
+; void cos32_thread_exit(int exit_code);
+cos32_thread_exit:
+    push ebp
+    mov ebp, esp
+    push ebx
+    mov eax, 23 ; Command 23 exit the current thread
+    mov ebx, [ebp+8] ; The exit code
+    SYSCALL_REGS
+    pop ebx
+    pop ebp
+    ret
+
+; int cos32_thread_join(int thread_id, int* exit_code);
+cos32_thread_join:
+    push ebp
+    mov ebp, esp
+    push ebx
+    mov eax, 24 ; Command 24 wait for the thread to exit
+    mov ecx, [ebp+12] ; Where the exit code is written, may be NULL
+    mov ebx, [ebp+8] ; The thread id to wait for
+    SYSCALL_REGS
+    pop ebx
+    pop ebp
+    ret
+
+; int cos32_set_priority(int priority);
+cos32_set_priority:
+    push ebp
+    mov ebp, esp
+    push ebx
+    mov eax, 26 ; Command 26 set the priority of the current thread
+    mov ebx, [ebp+8] ; The priority, zero is the highest
+    SYSCALL_REGS
+    pop ebx
+    pop ebp
+    ret
+
+; int cos32_set_scheduler(const char* name);
+cos32_set_scheduler:
+    push ebp
+    mov ebp, esp
+    push ebx
+    mov eax, 27 ; Command 27 select the kernel scheduler
+    mov ebx, [ebp+8] ; The name of the scheduler
+    SYSCALL_REGS
+    pop ebx
+    pop ebp
+    ret
+
+; int cos32_task_statistics(struct task_info* info, int max);
+cos32_task_statistics:
+    push ebp
+    mov ebp, esp
+    push ebx
+    mov eax, 28 ; Command 28 take a snapshot of the running tasks
+    mov ecx, [ebp+12] ; The maximum amount of tasks to return
+    mov ebx, [ebp+8] ; The task information array
+    SYSCALL_REGS
+    pop ebx
+    pop ebp
+    ret
+
+; unsigned long long cos32_clock_ns_kernel();
+cos32_clock_ns_kernel:
+    push ebp
+    mov ebp, esp
+    sub esp, 8 ; Room for the kernel to write the 64 bit result
+    push ebx
+    mov eax, 29 ; Command 29 get the nanoseconds since boot
+    lea ebx, [ebp-8]
+    SYSCALL_REGS
+    pop ebx
+    ; 64 bit values are returned in edx:eax
+    mov eax, [ebp-8]
+    mov edx, [ebp-4]
+    add esp, 8
+    pop ebp
+    ret
+
+; int cos32_null();
+cos32_null:
+    mov eax, 30 ; Command 30 does nothing, used to measure system call overhead
+    SYSCALL_REGS
+    ret
+
+; int cos32_null_int80();
+cos32_null_int80:
+    mov eax, 30 | ISR80H_REGISTER_ABI ; Command 30 does nothing, always through "int 0x80" so the paths can be compared
     int 0x80
-    add esp, 4
+    ret
+
+; int cos32_batch_execute(struct cos32_batch_entry* entries, int total);
+cos32_batch_execute:
+    push ebp
+    mov ebp, esp
+    push ebx
+    mov eax, 31 ; Command 31 run many commands with a single system call
+    mov ecx, [ebp+12] ; The amount of commands
+    mov ebx, [ebp+8] ; The commands to run, results are written back to them
+    SYSCALL_REGS
+    pop ebx
     pop ebp
-    ret
\ No newline at end of file
+    ret
+
+; int cos32_trace(int operation, int value, void* out, int max);
+cos32_trace:
+    push ebp
+    mov ebp, esp
+    push ebx
+    push esi
+    mov eax, 32 ; Command 32 control the system call tracer
+    mov esi, [ebp+20] ; The most entries to write to "out"
+    mov edx, [ebp+16] ; Where snapshots are written
+    mov ecx, [ebp+12] ; The flags or process id depending on the operation
+    mov ebx, [ebp+8] ; The operation
+    SYSCALL_REGS
+    pop esi
+    pop ebx
+    pop ebp
+    ret
+
+; int cos32_disk_cache_statistics(struct cos32_disk_cache_statistics* statistics);
+cos32_disk_cache_statistics:
+    push ebp
+    mov ebp, esp
+    push ebx
+    mov eax, 33 ; Command 33 get the disk cache counters
+    mov ebx, [ebp+8] ; Where the counters are written
+    SYSCALL_REGS
+    pop ebx
+    pop ebp
+    ret
+
+; int cos32_disk_read(int disk_id, unsigned int lba, int total, void* out);
+cos32_disk_read:
+    push ebp
+    mov ebp, esp
+    push ebx
+    push esi
+    mov eax, 34 ; Command 34 read sectors straight from a disk
+    mov esi, [ebp+20] ; Where the sectors are written
+    mov edx, [ebp+16] ; The amount of sectors
+    mov ecx, [ebp+12] ; The first sector
+    mov ebx, [ebp+8] ; The disk
+    SYSCALL_REGS
+    pop esi
+    pop ebx
+    pop ebp
+    ret
+
+; int cos32_disk_queue_statistics(int disk_id, struct cos32_disk_queue_statistics* statistics);
+cos32_disk_queue_statistics:
+    push ebp
+    mov ebp, esp
+    push ebx
+    mov eax, 35 ; Command 35 get the request queue counters of a disk
+    mov ecx, [ebp+12] ; Where the counters are written
+    mov ebx, [ebp+8] ; The disk
+    SYSCALL_REGS
+    pop ebx
+    pop ebp
+    ret
+
+; int cos32_sync();
+cos32_sync:
+    mov eax, 36 ; Command 36 write everything the disk cache holds to the disks
+    SYSCALL_REGS
+    ret
+
+; int cos32_disk_write(int disk_id, unsigned int lba, int total, const void* in);
+cos32_disk_write:
+    push ebp
+    mov ebp, esp
+    push ebx
+    push esi
+    mov eax, 37 ; Command 37 write sectors to a disk through the disk cache
+    mov esi, [ebp+20] ; Where the sectors are read from
+    mov edx, [ebp+16] ; The amount of sectors
+    mov ecx, [ebp+12] ; The first sector
+    mov ebx, [ebp+8] ; The disk
+    SYSCALL_REGS
+    pop esi
+    pop ebx
+    pop ebp
+    ret
+
+; bool cos32_syscall_is_fast();
+cos32_syscall_is_fast:
+    ; Makes sure the entry has been chosen
+    call cos32_null
+    xor eax, eax
+    cmp dword [cos32_syscall_entry], cos32_syscall_sysenter
+    sete al
+    ret
+
+; The first system call picks the fastest entry the processor supports then continues through it
+cos32_syscall_detect:
+    ; CPUID overwrites all four, ECX and EDX may hold arguments of the register ABI
+    push eax
+    push ebx
+    push ecx
+    push edx
+    mov eax, 1
+    cpuid
+    mov dword [cos32_syscall_entry], cos32_syscall_int80
+    mov dword [cos32_syscall_regs_entry], cos32_syscall_regs_int80
+    ; The feature bits are tested before EDX is restored
+    test edx, CPUID_FEATURE_EDX_SEP
+    jz .detected
+    mov dword [cos32_syscall_entry], cos32_syscall_sysenter
+    mov dword [cos32_syscall_regs_entry], cos32_syscall_sysenter
+.detected:
+    pop edx
+    pop ecx
+    pop ebx
+    pop eax
+    ; The register ABI flag tells us which entry the caller wanted
+    test eax, ISR80H_REGISTER_ABI
+    jnz .registers
+    jmp [cos32_syscall_entry]
+.registers:
+    jmp [cos32_syscall_regs_entry]
+
+; Removes our return address so the kernel finds the arguments where "int 0x80" would leave them
+cos32_syscall_int80:
+    pop edx
+    int 0x80
+    jmp edx
+
+; Arguments are in registers so the stack does not matter to the kernel
+cos32_syscall_regs_int80:
+    int 0x80
+    ret
+
+; Used for both ABIs, the kernel restores ECX and EDX from the stack and returns straight to our caller
+; with our return address removed. Keep the layout in sync with isr80h_sysenter_wrapper
+cos32_syscall_sysenter:
+    push edx
+    push ecx
+    mov ecx, esp
+    sysenter
+
+section .data
+cos32_syscall_entry: dd cos32_syscall_detect
+cos32_syscall_regs_entry: dd cos32_syscall_detect
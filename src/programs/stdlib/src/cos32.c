@@ -111,4 +111,110 @@ void cos32_terminal_readline(char *out, int max, bool output_while_typing)
 
     // Add the null terminator
     out[i] = 0x00;
-}
\ No newline at end of file
+}
+
+void cos32_batch_init(struct cos32_batch *batch, struct cos32_batch_entry *entries, int max)
+{
+    batch->entries = entries;
+    batch->total = 0;
+    batch->max = max;
+}
+
+struct cos32_batch_entry *cos32_batch_add(struct cos32_batch *batch, int command, int total_args, unsigned int *args)
+{
+    if (batch->total >= batch->max || total_args > COS32_BATCH_MAX_ARGUMENTS)
+    {
+        return 0;
+    }
+
+    struct cos32_batch_entry *entry = &batch->entries[batch->total];
+    entry->command = command;
+    entry->result = 0;
+
+    // The kernel expects the arguments in the order they would be found on the stack
+    for (int i = 0; i < total_args; i++)
+    {
+        entry->args[i] = args[total_args - i - 1];
+    }
+
+    batch->total++;
+    return entry;
+}
+
+struct cos32_batch_entry *cos32_batch_rectangle_set_pixel(struct cos32_batch *batch, void *rect, int x, int y, char colour)
+{
+    unsigned int args[] = {(unsigned int)rect, x, y, colour};
+    return cos32_batch_add(batch, COS32_COMMAND_VIDEO_RECTANGLE_SET_PIXEL, 4, args);
+}
+
+struct cos32_batch_entry *cos32_batch_rectangle_fill(struct cos32_batch *batch, void *rect, char colour)
+{
+    unsigned int args[] = {(unsigned int)rect, colour};
+    return cos32_batch_add(batch, COS32_COMMAND_VIDEO_RECTANGLE_FILL, 2, args);
+}
+
+struct cos32_batch_entry *cos32_batch_font_draw(struct cos32_batch *batch, void *font, void *ptr, const char *message)
+{
+    unsigned int args[] = {(unsigned int)font, (unsigned int)ptr, (unsigned int)message};
+    return cos32_batch_add(batch, COS32_COMMAND_VIDEO_FONT_DRAW, 3, args);
+}
+
+struct cos32_batch_entry *cos32_batch_rectangle_draw_font_data(struct cos32_batch *batch, void *rect, void *font, void *ptr, int absx, int absy, int total)
+{
+    unsigned int args[] = {(unsigned int)rect, (unsigned int)font, (unsigned int)ptr, absx, absy, total};
+    return cos32_batch_add(batch, COS32_COMMAND_VIDEO_RECTANGLE_DRAW_FONT_DATA, 6, args);
+}
+
+struct cos32_batch_entry *cos32_batch_flush_video_buffer(struct cos32_batch *batch)
+{
+    return cos32_batch_add(batch, COS32_COMMAND_VIDEO_BUFFER_FLUSH, 0, 0);
+}
+
+int cos32_batch_submit(struct cos32_batch *batch)
+{
+    if (batch->total == 0)
+    {
+        return 0;
+    }
+
+    int res = cos32_batch_execute(batch->entries, batch->total);
+    batch->total = 0;
+    return res;
+}
+
+void kernel_information(struct kernel_info *info)
+{
+    info->build_no = COS32_INFO_PAGE->build_no;
+    info->date = COS32_INFO_PAGE->date;
+}
+
+int cos32_get_arguments(struct process_arguments *arguments)
+{
+    arguments->argc = COS32_INFO_PAGE->argc;
+    arguments->argv = COS32_INFO_PAGE->argv;
+    return 0;
+}
+
+int cos32_getpid()
+{
+    return COS32_INFO_PAGE->process_id;
+}
+
+unsigned long long cos32_clock_ns()
+{
+    unsigned int mult = COS32_INFO_PAGE->tsc_mult;
+    if (!mult)
+    {
+        return cos32_clock_ns_kernel();
+    }
+
+    unsigned long long tsc;
+    __asm__ volatile("rdtsc" : "=A"(tsc));
+    unsigned long long cycles = tsc - COS32_INFO_PAGE->tsc_start;
+
+    // Scale the halves separately like the kernel does so nothing overflows and no 64 bit division is needed
+    unsigned int shift = COS32_INFO_PAGE->tsc_shift;
+    unsigned int high = cycles >> 32;
+    unsigned int low = cycles & 0xffffffff;
+    return (((unsigned long long)high * mult) << (32 - shift)) + (((unsigned long long)low * mult) >> shift);
+}
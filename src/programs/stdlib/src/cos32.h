@@ -24,6 +24,55 @@ struct process_arguments
     char **argv;
 };
 
+// The kernel maps this page read only into every process, keep in sync with the kernel's struct info_page
+struct cos32_info_page
+{
+    unsigned int version;
+    unsigned int build_no;
+    unsigned int date;
+    unsigned int process_id;
+
+    int argc;
+    char **argv;
+
+    // Nanoseconds are ((tsc - tsc_start) * tsc_mult) >> tsc_shift, zero if there is no time stamp counter
+    unsigned int tsc_mult;
+    unsigned int tsc_shift;
+    unsigned long long tsc_start;
+};
+
+#define COS32_INFO_PAGE ((const volatile struct cos32_info_page *)0x3FF000)
+
+struct task_statistics
+{
+    // Timer ticks spent running in user space
+    unsigned int user_ticks;
+    // Timer ticks spent running in the kernel
+    unsigned int kernel_ticks;
+    // The amount of times this task was switched to
+    unsigned int switches;
+    // The amount of times this task gave up the processor because it slept, paused or exited
+    unsigned int voluntary_switches;
+    // The amount of times this task was switched out whilst it still wanted to run
+    unsigned int involuntary_switches;
+    // Timer ticks spent awake but waiting for another task to finish running
+    unsigned int wait_ticks;
+};
+
+#define TASK_INFO_NAME_SIZE 20
+
+struct task_info
+{
+    // The id of the process this task belongs to, below zero for kernel threads
+    int process_id;
+    int thread_id;
+    char name[TASK_INFO_NAME_SIZE];
+    int awake;
+    int priority;
+    int level;
+    struct task_statistics statistics;
+};
+
 
 
 /*
@@ -132,6 +181,238 @@ void cos32_flush_video_buffer();
  */
 void cos32_video_clear_flag(int flag);
 
+/**
+ * Creates a new thread that runs "function" with the given argument, the thread shares our memory.
+ * When the function returns the thread exits with the returned value as its exit code.
+ * Returns the thread id or below zero on error
+ */
+int cos32_thread_create(int (*function)(void *arg), void *arg);
+
+/**
+ * Exits the current thread with the given exit code, the main thread cannot exit this way
+ */
+void cos32_thread_exit(int exit_code);
+
+/**
+ * Waits for the given thread to exit and writes its exit code to "exit_code" unless it is NULL.
+ * Returns zero on success or below zero on error
+ */
+int cos32_thread_join(int thread_id, int *exit_code);
+
+/**
+ * Sets the priority of the current thread, zero is the highest priority
+ */
+int cos32_set_priority(int priority);
+
+/**
+ * Selects the kernel scheduler for the whole system, either "roundrobin" or "mlfq"
+ */
+int cos32_set_scheduler(const char *name);
+
+/**
+ * Takes a snapshot of up to "max" running tasks including kernel threads.
+ * Returns the amount of tasks written to "info", below zero is an error
+ */
+int cos32_task_statistics(struct task_info *info, int max);
+
+/**
+ * Returns the nanoseconds since the kernel started, this never goes backwards.
+ * Read from the time stamp counter without a system call when the kernel allows it
+ */
+unsigned long long cos32_clock_ns();
+
+/**
+ * Asks the kernel for the nanoseconds since it started with a system call
+ */
+unsigned long long cos32_clock_ns_kernel();
+
+/**
+ * Returns the id of our process
+ */
+int cos32_getpid();
+
+// System call commands that can be added to a batch with cos32_batch_add
+#define COS32_COMMAND_VIDEO_RECTANGLE_SET_PIXEL 9
+#define COS32_COMMAND_VIDEO_RECTANGLE_FILL 10
+#define COS32_COMMAND_VIDEO_FONT_DRAW 14
+#define COS32_COMMAND_VIDEO_RECTANGLE_DRAW_FONT_DATA 16
+#define COS32_COMMAND_VIDEO_BUFFER_FLUSH 20
+
+#define COS32_BATCH_MAX_ARGUMENTS 6
+
+// Keep in sync with the kernel's struct isr80h_batch_entry
+struct cos32_batch_entry
+{
+    unsigned int command;
+    // The last parameter of the command comes first
+    unsigned int args[COS32_BATCH_MAX_ARGUMENTS];
+    int result;
+};
+
+// Commands waiting to be sent to the kernel with a single system call
+struct cos32_batch
+{
+    struct cos32_batch_entry *entries;
+    int total;
+    int max;
+};
+
+/**
+ * Prepares a batch that stores up to "max" commands in the provided entries
+ */
+void cos32_batch_init(struct cos32_batch *batch, struct cos32_batch_entry *entries, int max);
+
+/**
+ * Adds a command to the batch, "args" are in the order the command's function takes them.
+ * Returns the entry that will hold the result or zero if the batch is full
+ */
+struct cos32_batch_entry *cos32_batch_add(struct cos32_batch *batch, int command, int total_args, unsigned int *args);
+
+struct cos32_batch_entry *cos32_batch_rectangle_set_pixel(struct cos32_batch *batch, void *rect, int x, int y, char colour);
+struct cos32_batch_entry *cos32_batch_rectangle_fill(struct cos32_batch *batch, void *rect, char colour);
+struct cos32_batch_entry *cos32_batch_font_draw(struct cos32_batch *batch, void *font, void *ptr, const char *message);
+struct cos32_batch_entry *cos32_batch_rectangle_draw_font_data(struct cos32_batch *batch, void *rect, void *font, void *ptr, int absx, int absy, int total);
+struct cos32_batch_entry *cos32_batch_flush_video_buffer(struct cos32_batch *batch);
+
+/**
+ * Runs every command in the batch with one system call then empties it.
+ * Returns how many commands ran, each result is written to its entry
+ */
+int cos32_batch_submit(struct cos32_batch *batch);
+
+/**
+ * Runs the given commands with a single system call, returns how many ran
+ */
+int cos32_batch_execute(struct cos32_batch_entry *entries, int total);
+
+/**
+ * System call that does nothing, through SYSENTER when the processor supports it
+ */
+int cos32_null();
+
+/**
+ * System call that does nothing, always through "int 0x80"
+ */
+int cos32_null_int80();
+
+/**
+ * Returns true if system calls are made with SYSENTER rather than "int 0x80"
+ */
+bool cos32_syscall_is_fast();
+
+// What the system call tracer records, pass to COS32_TRACE_OPERATION_SET_FLAGS
+#define COS32_TRACE_STATISTICS 0b00000001
+#define COS32_TRACE_CALLS 0b00000010
+
+#define COS32_TRACE_OPERATION_SET_FLAGS 0
+#define COS32_TRACE_OPERATION_RESET 1
+#define COS32_TRACE_OPERATION_STATISTICS 2
+#define COS32_TRACE_OPERATION_CALLS 3
+
+// Bucket "i" of a latency histogram counts calls that took between 2^i and 2^(i+1) nanoseconds
+#define COS32_TRACE_BUCKETS 32
+#define COS32_TRACE_ALL_PROCESSES -1
+
+// Keep in sync with the kernel's struct isr80h_trace_statistics
+struct cos32_trace_statistics
+{
+    unsigned long long total_ns;
+    unsigned int command;
+    unsigned int calls;
+    unsigned int errors;
+    unsigned int max_ns;
+    unsigned int histogram[COS32_TRACE_BUCKETS];
+};
+
+// Keep in sync with the kernel's struct isr80h_trace_call
+struct cos32_trace_call
+{
+    unsigned long long timestamp_ns;
+    unsigned int duration_ns;
+    unsigned int command;
+    int process_id;
+    int thread_id;
+    // The argument registers in the order EBX, ECX, EDX, ESI, EDI and EBP
+    unsigned int args[COS32_BATCH_MAX_ARGUMENTS];
+    int result;
+};
+
+/**
+ * Controls the system call tracer.
+ * COS32_TRACE_OPERATION_SET_FLAGS - "value" is the new flags, returns the previous flags
+ * COS32_TRACE_OPERATION_RESET - Throws away everything recorded so far
+ * COS32_TRACE_OPERATION_STATISTICS - Writes the statistics of each called command for the process id "value" to "out",
+ *                                    use COS32_TRACE_ALL_PROCESSES for every process
+ * COS32_TRACE_OPERATION_CALLS - Writes the most recent calls of every process to "out" oldest first
+ * Snapshots return how many entries were written, below zero is an error
+ */
+int cos32_trace(int operation, int value, void *out, int max);
+
+// Keep in sync with the kernel's struct disk_cache_statistics
+struct cos32_disk_cache_statistics
+{
+    unsigned int hits;
+    unsigned int misses;
+    unsigned int evictions;
+    unsigned int block_size;
+    unsigned int total_blocks;
+    unsigned int used_blocks;
+    unsigned int readahead_blocks;
+    unsigned int readahead_hits;
+    unsigned int readahead_wasted;
+    unsigned int dirty_blocks;
+    unsigned int writebacks;
+    unsigned int write_errors;
+};
+
+/**
+ * Writes the hit, miss and read ahead counters of the kernel's disk cache to "statistics"
+ */
+int cos32_disk_cache_statistics(struct cos32_disk_cache_statistics *statistics);
+
+// The most sectors cos32_disk_read and cos32_disk_write move at once
+#define COS32_DISK_READ_MAX_SECTORS 256
+#define COS32_SECTOR_SIZE 512
+
+/**
+ * Reads "total" sectors starting at "lba" from the given disk into "out", straight from the drive rather
+ * than through the kernel's disk cache, sectors written with cos32_disk_write are seen even before the cache
+ * writes them back. Returns zero on success or below zero on error
+ */
+int cos32_disk_read(int disk_id, unsigned int lba, int total, void *out);
+
+/**
+ * Writes "total" sectors from "in" to the given disk starting at "lba". The sectors go into the kernel's disk cache
+ * and reach the drive when the cache is next written back, see cos32_sync. Returns zero on success or below zero on error
+ */
+int cos32_disk_write(int disk_id, unsigned int lba, int total, const void *in);
+
+/**
+ * Writes everything the kernel's disk cache holds for the disks to them and waits until the drives have it on their media.
+ * Returns zero on success or below zero if a write failed
+ */
+int cos32_sync();
+
+// Keep in sync with the kernel's struct disk_queue_statistics
+struct cos32_disk_queue_statistics
+{
+    unsigned int bios;
+    unsigned int merges;
+    unsigned int requests;
+    unsigned int errors;
+    unsigned int sectors;
+    unsigned int busy;
+    unsigned int max_pending;
+    unsigned int max_in_flight;
+    unsigned int depth;
+    unsigned int writes;
+};
+
+/**
+ * Writes the counters of the given disk's request queue to "statistics"
+ */
+int cos32_disk_queue_statistics(int disk_id, struct cos32_disk_queue_statistics *statistics);
+
 
 
 #endif
\ No newline at end of file
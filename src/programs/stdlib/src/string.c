@@ -50,6 +50,22 @@ int strnlen(const char *str, int max)
     return i;
 }
 
+int strncmp(const char *s1, const char *s2, int n)
+{
+    unsigned char u1, u2;
+
+    while (n-- > 0)
+    {
+        u1 = (unsigned char)*s1++;
+        u2 = (unsigned char)*s2++;
+        if (u1 != u2)
+            return u1 - u2;
+        if (u1 == '\0')
+            return 0;
+    }
+    return 0;
+}
+
 int isdigit(char c)
 {
     return c >= 48 && c <= 57;
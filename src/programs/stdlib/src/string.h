@@ -5,6 +5,7 @@
 char *strtok(char *str, const char *delimiters);
 size_t strlen(const char *str);
 int strnlen(const char *str, int max);
+int strncmp(const char *s1, const char *s2, int n);
 char *strncpy(char *dest, const char *src, int n);
 char *strcpy(char *dest, const char *src);
 
@@ -0,0 +1,302 @@
+#include "strace.h"
+#include "cos32.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+#include <stddef.h>
+
+// Indexed by command, keep in sync with the kernel's enum SystemCommands
+static const char *command_names[] = {
+    "exit",
+    "print",
+    "get_key",
+    "get_kernel_info",
+    "putchar",
+    "malloc",
+    "invoke",
+    "sleep",
+    "rect_new",
+    "rect_set_pixel",
+    "rect_fill",
+    "rect_draw_block",
+    "rect_draw_blocks",
+    "font_get",
+    "font_draw",
+    "font_make_empty_string",
+    "rect_draw_font_data",
+    "rect_publish",
+    "rect_get",
+    "get_arguments",
+    "video_buffer_flush",
+    "video_clear_flag",
+    "thread_create",
+    "thread_exit",
+    "thread_join",
+    "get_key_block",
+    "set_priority",
+    "set_scheduler",
+    "task_statistics",
+    "clock_ns",
+    "null",
+    "batch",
+    "trace",
+    "disk_cache_statistics",
+    "disk_read",
+    "disk_queue_statistics",
+    "sync",
+    "disk_write"};
+
+static struct cos32_trace_statistics statistics[STRACE_MAX_COMMANDS];
+static struct cos32_trace_call calls[STRACE_MAX_CALLS];
+
+static const char *strace_command_name(unsigned int command)
+{
+    if (command >= sizeof(command_names) / sizeof(command_names[0]))
+    {
+        return "unknown";
+    }
+    return command_names[command];
+}
+
+/**
+ * Divides without the 64 bit division routines we don't link against, the result must fit into 32 bits
+ */
+static unsigned int strace_divide(unsigned long long dividend, unsigned int divisor)
+{
+    unsigned long long remainder = 0;
+    unsigned int result = 0;
+    for (int i = 63; i >= 0; i--)
+    {
+        remainder = (remainder << 1) | ((dividend >> i) & 1);
+        result <<= 1;
+        if (remainder >= divisor)
+        {
+            remainder -= divisor;
+            result |= 1;
+        }
+    }
+    return result;
+}
+
+/**
+ * Appends "str" to the line at "pos" padded with spaces to at least "width" characters
+ */
+static void strace_append(char *line, int *pos, const char *str, int width, bool right_align)
+{
+    int len = strnlen(str, STRACE_LINE_LENGTH - *pos);
+    int padding = width - len;
+    if (right_align)
+    {
+        for (int i = 0; i < padding && *pos < STRACE_LINE_LENGTH; i++)
+        {
+            line[(*pos)++] = ' ';
+        }
+    }
+
+    for (int i = 0; i < len; i++)
+    {
+        line[(*pos)++] = str[i];
+    }
+
+    if (!right_align)
+    {
+        for (int i = 0; i < padding && *pos < STRACE_LINE_LENGTH; i++)
+        {
+            line[(*pos)++] = ' ';
+        }
+    }
+
+    // Each column is separated by a single space
+    if (*pos < STRACE_LINE_LENGTH)
+    {
+        line[(*pos)++] = ' ';
+    }
+    line[*pos] = 0;
+}
+
+/**
+ * Writes "whole.fraction" into "out" with the fraction padded to "digits" digits
+ */
+static void strace_fixed(char *out, unsigned int whole, unsigned int fraction, int digits)
+{
+    int pos = 0;
+    const char *str = itoa(whole);
+    while (*str)
+    {
+        out[pos++] = *str++;
+    }
+
+    out[pos++] = '.';
+    for (int i = digits - 1; i >= 0; i--)
+    {
+        out[pos + i] = '0' + fraction % 10;
+        fraction /= 10;
+    }
+    out[pos + digits] = 0;
+}
+
+static void strace_append_number(char *line, int *pos, unsigned int number)
+{
+    strace_append(line, pos, itoa(number), 11, true);
+}
+
+/**
+ * Shows the statistics like "strace -c", the most expensive commands first
+ */
+static void strace_show_statistics(int total, bool histograms)
+{
+    char line[STRACE_LINE_LENGTH + 1];
+    char number[16];
+    unsigned int total_us = 0;
+    unsigned int total_calls = 0;
+    unsigned int total_errors = 0;
+
+    // Sort by the time spent, there are only a handful of commands
+    for (int i = 0; i < total; i++)
+    {
+        for (int j = i + 1; j < total; j++)
+        {
+            if (statistics[j].total_ns > statistics[i].total_ns)
+            {
+                struct cos32_trace_statistics tmp = statistics[i];
+                statistics[i] = statistics[j];
+                statistics[j] = tmp;
+            }
+        }
+        total_us += strace_divide(statistics[i].total_ns, 1000);
+        total_calls += statistics[i].calls;
+        total_errors += statistics[i].errors;
+    }
+
+    printf("%% time     seconds  usecs/call       calls      errors syscall\n");
+    printf("------ ----------- ----------- ----------- ----------- ----------------\n");
+    for (int i = 0; i < total; i++)
+    {
+        struct cos32_trace_statistics *s = &statistics[i];
+        unsigned int us = strace_divide(s->total_ns, 1000);
+        unsigned int hundredths = total_us ? strace_divide((unsigned long long)us * 10000, total_us) : 0;
+        int pos = 0;
+
+        strace_fixed(number, hundredths / 100, hundredths % 100, 2);
+        strace_append(line, &pos, number, 6, true);
+        strace_fixed(number, us / 1000000, us % 1000000, 6);
+        strace_append(line, &pos, number, 11, true);
+        strace_append_number(line, &pos, us / s->calls);
+        strace_append_number(line, &pos, s->calls);
+        strace_append(line, &pos, s->errors ? itoa(s->errors) : "", 11, true);
+        strace_append(line, &pos, strace_command_name(s->command), 0, false);
+        printf("%s\n", line);
+
+        if (!histograms)
+        {
+            continue;
+        }
+
+        for (int bucket = 0; bucket < COS32_TRACE_BUCKETS; bucket++)
+        {
+            if (s->histogram[bucket])
+            {
+                // Bucket "i" holds calls taking at least 2^i nanoseconds
+                printf("        >= 2^%i ns: %i\n", bucket, s->histogram[bucket]);
+            }
+        }
+    }
+
+    int pos = 0;
+    printf("------ ----------- ----------- ----------- ----------- ----------------\n");
+    strace_append(line, &pos, "100.00", 6, true);
+    strace_fixed(number, total_us / 1000000, total_us % 1000000, 6);
+    strace_append(line, &pos, number, 11, true);
+    strace_append_number(line, &pos, total_calls ? total_us / total_calls : 0);
+    strace_append_number(line, &pos, total_calls);
+    strace_append(line, &pos, total_errors ? itoa(total_errors) : "", 11, true);
+    strace_append(line, &pos, "total", 0, false);
+    printf("%s\n", line);
+}
+
+static void strace_show_calls(int total, int process_id)
+{
+    for (int i = 0; i < total; i++)
+    {
+        struct cos32_trace_call *call = &calls[i];
+        if (process_id != COS32_TRACE_ALL_PROCESSES && call->process_id != process_id)
+        {
+            continue;
+        }
+
+        printf("[%i:%i] %s(", call->process_id, call->thread_id, strace_command_name(call->command));
+        for (int arg = 0; arg < COS32_BATCH_MAX_ARGUMENTS; arg++)
+        {
+            printf(arg == 0 ? "%i" : ", %i", call->args[arg]);
+        }
+        printf(") = %i <%i ns>\n", call->result, call->duration_ns);
+    }
+}
+
+static int strace_parse_number(const char *str)
+{
+    int number = 0;
+    while (*str >= '0' && *str <= '9')
+    {
+        number = number * 10 + (*str - '0');
+        str++;
+    }
+    return number;
+}
+
+int main(int argc, char **argv)
+{
+    int process_id = COS32_TRACE_ALL_PROCESSES;
+    int flags = COS32_TRACE_STATISTICS;
+    bool histograms = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strncmp(argv[i], "-t", 3) == 0)
+        {
+            flags = COS32_TRACE_CALLS;
+        }
+        else if (strncmp(argv[i], "-h", 3) == 0)
+        {
+            histograms = true;
+        }
+        else
+        {
+            process_id = strace_parse_number(argv[i]);
+        }
+    }
+
+    cos32_trace(COS32_TRACE_OPERATION_RESET, 0, NULL, 0);
+    cos32_trace(COS32_TRACE_OPERATION_SET_FLAGS, flags, NULL, 0);
+    cos32_sleep(STRACE_PERIOD_MILLIS);
+    cos32_trace(COS32_TRACE_OPERATION_SET_FLAGS, 0, NULL, 0);
+
+    if (flags & COS32_TRACE_CALLS)
+    {
+        int total = cos32_trace(COS32_TRACE_OPERATION_CALLS, 0, calls, STRACE_MAX_CALLS);
+        if (total < 0)
+        {
+            printf("Failed to read the traced calls\n");
+        }
+        else
+        {
+            strace_show_calls(total, process_id);
+        }
+    }
+    else
+    {
+        int total = cos32_trace(COS32_TRACE_OPERATION_STATISTICS, process_id, statistics, STRACE_MAX_COMMANDS);
+        if (total < 0)
+        {
+            printf("No process with the id %i\n", process_id);
+        }
+        else
+        {
+            strace_show_statistics(total, histograms);
+        }
+    }
+
+    while (1)
+    {
+    }
+}
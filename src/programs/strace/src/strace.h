@@ -0,0 +1,16 @@
+#ifndef STRACE_H
+#define STRACE_H
+
+// How long we record system calls for before showing what happened
+#define STRACE_PERIOD_MILLIS 5000
+
+// The most commands we show statistics for
+#define STRACE_MAX_COMMANDS 64
+
+// The most recent calls shown with "-t"
+#define STRACE_MAX_CALLS 32
+
+// The amount of characters on a single line
+#define STRACE_LINE_LENGTH 80
+
+#endif
@@ -0,0 +1,39 @@
+#include "syscallbench.h"
+#include "cos32.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include <stddef.h>
+
+/**
+ * Makes the system call many times and returns the average nanoseconds for each call
+ */
+static unsigned int syscallbench_measure(int (*syscall)())
+{
+    unsigned long long start = cos32_clock_ns();
+    for (int i = 0; i < SYSCALLBENCH_CALLS; i++)
+    {
+        syscall();
+    }
+
+    // The loop takes well under four seconds so the difference fits into 32 bits
+    unsigned int elapsed = (unsigned int)(cos32_clock_ns() - start);
+    return elapsed / SYSCALLBENCH_CALLS;
+}
+
+int main(int argc, char **argv)
+{
+    printf("Null system call latency in nanoseconds over %i calls\n", SYSCALLBENCH_CALLS);
+    printf("int 0x80: %i\n", syscallbench_measure(cos32_null_int80));
+    if (!cos32_syscall_is_fast())
+    {
+        printf("sysenter: not supported by this processor\n");
+    }
+    else
+    {
+        printf("sysenter: %i\n", syscallbench_measure(cos32_null));
+    }
+
+    while (1)
+    {
+    }
+}
@@ -0,0 +1,7 @@
+#ifndef SYSCALLBENCH_H
+#define SYSCALLBENCH_H
+
+// The amount of system calls averaged for each entry path
+#define SYSCALLBENCH_CALLS 100000
+
+#endif
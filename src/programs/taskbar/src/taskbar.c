@@ -48,11 +48,14 @@ int initialize()
   return 0;
 }
 
+// The whole frame is drawn and flushed with a single system call
+struct cos32_batch_entry frame_entries[3];
+struct cos32_batch frame;
+
 void info_rect_update()
 {
-  cos32_video_rectangle_fill(info_rect, 28);
-  cos32_video_rectangle_draw_font_data(info_rect, default_font, info_text_use_function_keys_ptr, 10, 1, info_text_use_function_keys_ptr_len);
-  cos32_sleep(3000);
+  cos32_batch_rectangle_fill(&frame, info_rect, 28);
+  cos32_batch_rectangle_draw_font_data(&frame, info_rect, default_font, info_text_use_function_keys_ptr, 10, 1, info_text_use_function_keys_ptr_len);
 }
 
 void update()
@@ -63,11 +66,14 @@ void update()
 
 void redraw()
 {
-    cos32_flush_video_buffer();
+    cos32_batch_flush_video_buffer(&frame);
+    cos32_batch_submit(&frame);
+    cos32_sleep(3000);
 }
 
 int main(int argc, char **argv)
 {
+  cos32_batch_init(&frame, frame_entries, 3);
   initialize();
   while (1)
   {
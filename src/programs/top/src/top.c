@@ -0,0 +1,253 @@
+#include "top.h"
+#include "cos32.h"
+#include "stdlib.h"
+#include "string.h"
+#include <stddef.h>
+
+struct top_snapshot
+{
+    struct task_info tasks[TOP_MAX_TASKS];
+    int total;
+};
+
+// Two snapshots are kept so we can show what happened between each refresh
+static struct top_snapshot snapshots[2];
+
+static void *font = 0;
+static void *rect = 0;
+
+// Rendered pixel data for each line, the header and column line come first
+static void *lines[TOP_MAX_ROWS + 2];
+
+// The text of each line must live until the frame's batch is submitted
+static char texts[TOP_MAX_ROWS + 2][TOP_LINE_LENGTH + 1];
+
+// A whole frame is drawn with a single system call
+static struct cos32_batch_entry batch_entries[TOP_BATCH_SIZE];
+static struct cos32_batch batch;
+
+/**
+ * Appends "str" to the line at "pos" padded with spaces to exactly "width" characters
+ */
+static void top_append(char *line, int *pos, const char *str, int width, bool right_align)
+{
+    int len = strnlen(str, width);
+    int padding = width - len;
+    if (right_align)
+    {
+        for (int i = 0; i < padding; i++)
+        {
+            line[(*pos)++] = ' ';
+        }
+    }
+
+    for (int i = 0; i < len; i++)
+    {
+        line[(*pos)++] = str[i];
+    }
+
+    if (!right_align)
+    {
+        for (int i = 0; i < padding; i++)
+        {
+            line[(*pos)++] = ' ';
+        }
+    }
+
+    // Each column is separated by a single space
+    if (*pos < TOP_LINE_LENGTH)
+    {
+        line[(*pos)++] = ' ';
+    }
+}
+
+static unsigned int top_percent(unsigned int value, unsigned int total)
+{
+    if (total == 0)
+    {
+        return 0;
+    }
+    return value * 100 / total;
+}
+
+/**
+ * Finds the task in the previous snapshot that matches the given task.
+ * Kernel threads share the same name so we skip over the ones we have already matched
+ */
+static struct task_info *top_find_previous(struct top_snapshot *previous, struct task_info *task, bool *used)
+{
+    for (int i = 0; i < previous->total; i++)
+    {
+        struct task_info *candidate = &previous->tasks[i];
+        if (used[i] || candidate->process_id != task->process_id || candidate->thread_id != task->thread_id)
+        {
+            continue;
+        }
+
+        if (strncmp(candidate->name, task->name, TASK_INFO_NAME_SIZE) != 0)
+        {
+            continue;
+        }
+
+        used[i] = true;
+        return candidate;
+    }
+
+    return 0;
+}
+
+/**
+ * Calculates what the given task did since the previous snapshot
+ */
+static void top_difference(struct task_info *task, struct task_info *previous, struct task_statistics *out)
+{
+    *out = task->statistics;
+    if (!previous)
+    {
+        return;
+    }
+
+    out->user_ticks -= previous->statistics.user_ticks;
+    out->kernel_ticks -= previous->statistics.kernel_ticks;
+    out->switches -= previous->statistics.switches;
+    out->voluntary_switches -= previous->statistics.voluntary_switches;
+    out->involuntary_switches -= previous->statistics.involuntary_switches;
+    out->wait_ticks -= previous->statistics.wait_ticks;
+}
+
+static void top_draw_line(int index, const char *text)
+{
+    strncpy(texts[index], text, sizeof(texts[index]));
+    cos32_batch_font_draw(&batch, font, lines[index], texts[index]);
+    cos32_batch_rectangle_draw_font_data(&batch, rect, font, lines[index], 0, index * TOP_LINE_HEIGHT, TOP_LINE_LENGTH);
+}
+
+static void top_draw(struct top_snapshot *current, struct top_snapshot *previous)
+{
+    struct task_statistics differences[TOP_MAX_TASKS];
+    bool used[TOP_MAX_TASKS];
+    unsigned int total_ticks = 0;
+    unsigned int idle_ticks = 0;
+
+    for (int i = 0; i < TOP_MAX_TASKS; i++)
+    {
+        used[i] = false;
+    }
+
+    for (int i = 0; i < current->total; i++)
+    {
+        struct task_info *task = &current->tasks[i];
+        top_difference(task, top_find_previous(previous, task, used), &differences[i]);
+        unsigned int ticks = differences[i].user_ticks + differences[i].kernel_ticks;
+        total_ticks += ticks;
+        if (strncmp(task->name, "idle", TASK_INFO_NAME_SIZE) == 0)
+        {
+            idle_ticks += ticks;
+        }
+    }
+
+    char line[TOP_LINE_LENGTH + 1];
+    int pos = 0;
+    top_append(line, &pos, "COS32 top tasks:", 16, false);
+    top_append(line, &pos, itoa(current->total), 3, false);
+    top_append(line, &pos, "idle%:", 6, false);
+    top_append(line, &pos, itoa(top_percent(idle_ticks, total_ticks)), TOP_LINE_LENGTH - pos - 1, false);
+    line[pos] = 0;
+    top_draw_line(0, line);
+
+    pos = 0;
+    top_append(line, &pos, "PID", 3, true);
+    top_append(line, &pos, "TID", 3, true);
+    top_append(line, &pos, "NAME", 9, false);
+    top_append(line, &pos, "S", 1, false);
+    top_append(line, &pos, "CPU", 3, true);
+    top_append(line, &pos, "SYS", 3, true);
+    top_append(line, &pos, "WAIT", 4, true);
+    top_append(line, &pos, "SWCH", 5, true);
+    line[pos] = 0;
+    top_draw_line(1, line);
+
+    for (int i = 0; i < TOP_MAX_ROWS; i++)
+    {
+        pos = 0;
+        if (i >= current->total)
+        {
+            top_append(line, &pos, "", TOP_LINE_LENGTH, false);
+            line[pos] = 0;
+            top_draw_line(i + 2, line);
+            continue;
+        }
+
+        struct task_info *task = &current->tasks[i];
+        struct task_statistics *difference = &differences[i];
+        top_append(line, &pos, task->process_id < 0 ? "k" : itoa(task->process_id), 3, true);
+        top_append(line, &pos, itoa(task->thread_id), 3, true);
+        top_append(line, &pos, task->name, 9, false);
+        top_append(line, &pos, task->awake ? "R" : "S", 1, false);
+        top_append(line, &pos, itoa(top_percent(difference->user_ticks + difference->kernel_ticks, total_ticks)), 3, true);
+        top_append(line, &pos, itoa(top_percent(difference->kernel_ticks, total_ticks)), 3, true);
+        top_append(line, &pos, itoa(top_percent(difference->wait_ticks, total_ticks)), 4, true);
+        top_append(line, &pos, itoa(difference->switches), 5, true);
+        line[pos] = 0;
+        top_draw_line(i + 2, line);
+    }
+}
+
+static int top_initialize()
+{
+    cos32_batch_init(&batch, batch_entries, TOP_BATCH_SIZE);
+
+    font = cos32_video_font_get("Default");
+    if (!font)
+    {
+        return -1;
+    }
+
+    // Leave the taskbar visible at the top of the screen
+    rect = cos32_video_rectangle_new(0, 20, 320, 180);
+    if (!rect)
+    {
+        return -1;
+    }
+
+    for (int i = 0; i < TOP_MAX_ROWS + 2; i++)
+    {
+        lines[i] = cos32_video_font_make_empty_string(font, TOP_LINE_LENGTH);
+        if (!lines[i])
+        {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    if (top_initialize() < 0)
+    {
+        print("Failed to initialize top\n");
+        return -1;
+    }
+
+    int current = 0;
+    while (cos32_getkey() != 'q')
+    {
+        struct top_snapshot *snapshot = &snapshots[current];
+        struct top_snapshot *previous = &snapshots[!current];
+        snapshot->total = cos32_task_statistics(snapshot->tasks, TOP_MAX_TASKS);
+        if (snapshot->total < 0)
+        {
+            print("Failed to get the task statistics\n");
+            return -1;
+        }
+
+        cos32_batch_rectangle_fill(&batch, rect, 0);
+        top_draw(snapshot, previous);
+        cos32_batch_submit(&batch);
+        cos32_sleep(TOP_REFRESH_MILLIS);
+        current = !current;
+    }
+
+    return 0;
+}
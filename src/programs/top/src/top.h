@@ -0,0 +1,22 @@
+#ifndef TOP_H
+#define TOP_H
+
+// The maximum amount of tasks we take a snapshot of
+#define TOP_MAX_TASKS 32
+
+// The amount of tasks shown on screen, the rest are left out
+#define TOP_MAX_ROWS 9
+
+// The amount of characters on a single line
+#define TOP_LINE_LENGTH 38
+
+// The height in pixels of a single line of text
+#define TOP_LINE_HEIGHT 16
+
+// Clearing the screen then drawing the text of every line
+#define TOP_BATCH_SIZE (1 + (TOP_MAX_ROWS + 2) * 2)
+
+// How long we wait between each refresh
+#define TOP_REFRESH_MILLIS 1000
+
+#endif
@@ -0,0 +1,48 @@
+[BITS 16]
+section .asm
+
+global smp_trampoline_start
+global smp_trampoline_end
+
+; Keep in sync with smp.h
+SMP_TRAMPOLINE_ADDRESS equ 0x8000
+SMP_TRAMPOLINE_DATA_ADDRESS equ 0x8F00
+CODE_SEG equ 0x08
+DATA_SEG equ 0x10
+
+; This code is copied to SMP_TRAMPOLINE_ADDRESS, application processors start here in real mode
+; Nothing here may rely on where the kernel placed it so every address is relative to the copy
+smp_trampoline_start:
+    cli
+    xor ax, ax
+    mov ds, ax
+    ; The operand size prefix loads all 32 bits of the GDT base
+    o32 lgdt [SMP_TRAMPOLINE_DATA_ADDRESS]
+    mov eax, cr0
+    or eax, 0x01
+    mov cr0, eax
+    jmp dword CODE_SEG:(SMP_TRAMPOLINE_ADDRESS + smp_trampoline_32 - smp_trampoline_start)
+
+[BITS 32]
+smp_trampoline_32:
+    mov ax, DATA_SEG
+    mov ds, ax
+    mov es, ax
+    mov fs, ax
+    mov gs, ax
+    mov ss, ax
+    mov esp, [SMP_TRAMPOLINE_DATA_ADDRESS + 8]
+
+    ; Use the kernel page directory, everything is identity mapped so we keep running
+    mov eax, [SMP_TRAMPOLINE_DATA_ADDRESS + 12]
+    mov cr3, eax
+    mov eax, cr0
+    or eax, 0x80000000
+    mov cr0, eax
+
+    ; A relative call would be wrong once copied so we call through a register
+    mov eax, [SMP_TRAMPOLINE_DATA_ADDRESS + 16]
+    call eax
+    ; We never return from the entry point
+    jmp $
+smp_trampoline_end:
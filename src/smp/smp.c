@@ -0,0 +1,186 @@
+#include "smp.h"
+#include "spinlock.h"
+#include "cpu/cpu.h"
+#include "cpu/fpu.h"
+#include "acpi/acpi.h"
+#include "idt/idt.h"
+#include "idt/controller.h"
+#include "idt/controllers/apic.h"
+#include "gdt/gdt.h"
+#include "task/tss.h"
+#include "task/task.h"
+#include "task/kthread.h"
+#include "timer/pit.h"
+#include "memory/memory.h"
+#include "memory/kheap.h"
+#include "config.h"
+#include "status.h"
+#include "kernel.h"
+
+extern struct gdt gdt_real[COS32_TOTAL_GDT_SEGMENTS];
+
+static struct spinlock kernel_lock;
+
+// The boot processor uses the kernel's TSS, every other processor has one here
+static struct tss ap_tss[COS32_MAX_CPUS - 1];
+
+// Set by an application processor once it no longer needs the trampoline
+static volatile bool ap_started = false;
+
+void smp_lock_kernel()
+{
+    spinlock_lock(&kernel_lock);
+}
+
+void smp_unlock_kernel()
+{
+    spinlock_unlock(&kernel_lock);
+}
+
+void smp_reschedule(int cpu_id)
+{
+    struct cpu *cpu = cpu_get(cpu_id);
+    if (!cpu || !cpu->online || cpu == cpu_current())
+    {
+        return;
+    }
+
+    apic_send_ipi(cpu->apic_id, SMP_IPI_FIXED | ISR_RESCHEDULE_INTERRUPT);
+}
+
+static void smp_reschedule_interrupt()
+{
+    // A busy processor may need its timeslice cut short, an idle one looks for work once we return
+    pit_reschedule();
+
+    // Our task may have been stopped by another processor, such as when its process was terminated
+    if (!task_current()->awake)
+    {
+        interrupt_controller_eoi(ISR_RESCHEDULE_INTERRUPT);
+        task_next();
+    }
+}
+
+static int smp_tss_selector(int cpu_id)
+{
+    return (SMP_AP_TSS_FIRST_SEGMENT + cpu_id - 1) * sizeof(struct gdt);
+}
+
+void smp_gdt_init(struct gdt_structured *gdt_structured)
+{
+    for (int i = 0; i < COS32_MAX_CPUS - 1; i++)
+    {
+        struct gdt_structured *entry = &gdt_structured[SMP_AP_TSS_FIRST_SEGMENT + i];
+        entry->base = (uint32_t)&ap_tss[i];
+        entry->limit = sizeof(struct tss);
+        entry->type = 0xE9;
+    }
+}
+
+/**
+ * Application processors arrive here from the trampoline with paging enabled on their own stack
+ */
+static void smp_ap_main()
+{
+    struct cpu *cpu = cpu_current();
+    tss_load(smp_tss_selector(cpu->id));
+    idt_load_now();
+    idt_sysenter_init(ap_tss[cpu->id - 1].esp0);
+    fpu_init();
+    apic_init_secondary();
+
+    // The boot processor may now reuse the trampoline for the next processor
+    ap_started = true;
+
+    // The boot processor releases the lock once it runs its first task
+    smp_lock_kernel();
+    kthread_init_idle();
+    pit_init_secondary();
+    cpu_set_online(cpu);
+
+    // Returns to a task which releases the kernel lock, we never come back here
+    task_next();
+}
+
+static int smp_start_ap(struct smp_trampoline_data *data, int apic_id)
+{
+    int res = 0;
+    int id = cpu_register(apic_id);
+    if (id < 0)
+    {
+        res = id;
+        goto out;
+    }
+
+    struct cpu *cpu = cpu_get(id);
+    cpu->stack = kzalloc(SMP_AP_STACK_SIZE);
+    if (!cpu->stack)
+    {
+        res = -ENOMEM;
+        goto out;
+    }
+
+    struct tss *tss = &ap_tss[id - 1];
+    memset(tss, 0, sizeof(struct tss));
+    tss->ss0 = COS32_DATA_SELECTOR;
+    tss->esp0 = (uint32_t)cpu->stack + SMP_AP_STACK_SIZE;
+    data->stack = tss->esp0;
+    ap_started = false;
+
+    // The startup sequence from the Intel multiprocessor specification, INIT then up to two SIPIs
+    apic_send_ipi(apic_id, SMP_IPI_INIT);
+    pit_busy_wait(10);
+    for (int i = 0; i < 2 && !ap_started; i++)
+    {
+        apic_send_ipi(apic_id, SMP_IPI_STARTUP | (SMP_TRAMPOLINE_ADDRESS >> 12));
+        pit_busy_wait(1);
+    }
+
+    for (int waited = 0; waited < SMP_AP_START_TIMEOUT_MS && !ap_started; waited++)
+    {
+        pit_busy_wait(1);
+    }
+
+    if (!ap_started)
+    {
+        res = -EIO;
+    }
+
+out:
+    return res;
+}
+
+void smp_init()
+{
+    struct acpi_madt_info *madt = acpi_madt_info();
+    if (!apic_in_use() || !madt || madt->total_cpus < 2)
+    {
+        return;
+    }
+
+    cpu_enable_lookup();
+    ASSERT(idt_register_interrupt_callback(ISR_RESCHEDULE_INTERRUPT, smp_reschedule_interrupt) == 0);
+
+    int trampoline_size = (uint32_t)smp_trampoline_end - (uint32_t)smp_trampoline_start;
+    memcpy((void *)SMP_TRAMPOLINE_ADDRESS, (void *)smp_trampoline_start, trampoline_size);
+
+    struct smp_trampoline_data *data = (struct smp_trampoline_data *)SMP_TRAMPOLINE_DATA_ADDRESS;
+    data->gdt_limit = sizeof(struct gdt) * COS32_TOTAL_GDT_SEGMENTS - 1;
+    data->gdt_base = (uint32_t)gdt_real;
+    data->page_directory = (uint32_t)kernel_get_page_directory();
+    data->entry = (uint32_t)smp_ap_main;
+
+    int bsp_apic_id = apic_id();
+    for (int i = 0; i < madt->total_cpus; i++)
+    {
+        if (madt->cpu_apic_ids[i] == bsp_apic_id)
+        {
+            continue;
+        }
+
+        if (smp_start_ap(data, madt->cpu_apic_ids[i]) < 0)
+        {
+            print("Failed to start an application processor\n");
+        }
+    }
+}
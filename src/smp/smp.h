@@ -0,0 +1,70 @@
+#ifndef SMP_H
+#define SMP_H
+
+#include <stdint.h>
+
+// The real mode trampoline that application processors start in, must be below 1MB and page aligned
+#define SMP_TRAMPOLINE_ADDRESS 0x8000
+// The trampoline reads its startup data from here, keep in sync with smp.asm
+#define SMP_TRAMPOLINE_DATA_ADDRESS 0x8F00
+
+// The first GDT entry used for application processor TSS segments, entries before this are the standard segments
+#define SMP_AP_TSS_FIRST_SEGMENT 6
+
+#define SMP_AP_STACK_SIZE 1024 * 16
+
+// How long we wait for an application processor to tell us it started
+#define SMP_AP_START_TIMEOUT_MS 200
+
+// Interrupt command register values
+#define SMP_IPI_INIT 0x4500
+#define SMP_IPI_STARTUP 0x4600
+// Delivers the vector in the low byte like any other interrupt
+#define SMP_IPI_FIXED 0x4000
+
+struct gdt_structured;
+
+struct smp_trampoline_data
+{
+    // The GDT pointer loaded by the trampoline with lgdt
+    uint16_t gdt_limit;
+    uint32_t gdt_base;
+    uint16_t reserved;
+
+    uint32_t stack;
+    uint32_t page_directory;
+    uint32_t entry;
+} __attribute__((packed));
+
+/**
+ * Adds a TSS segment for each application processor to the provided GDT, called before the GDT is loaded
+ */
+void smp_gdt_init(struct gdt_structured *gdt_structured);
+
+/**
+ * Starts every application processor found in the ACPI MADT, does nothing without an APIC.
+ * The caller must hold the kernel lock, the processors wait for it before they schedule tasks
+ */
+void smp_init();
+
+/**
+ * Interrupts the processor with the given index so it looks at its tasks again, for when one of them
+ * became runnable. Does nothing if the processor is not online
+ */
+void smp_reschedule(int cpu_id);
+
+/**
+ * Takes the big kernel lock, only one processor may run kernel code at a time.
+ * Interrupts must be disabled as the lock is not recursive
+ */
+void smp_lock_kernel();
+
+/**
+ * Releases the big kernel lock, called just before returning to a task
+ */
+void smp_unlock_kernel();
+
+void smp_trampoline_start();
+void smp_trampoline_end();
+
+#endif
@@ -0,0 +1,27 @@
+[BITS 32]
+section .asm
+
+global spinlock_lock
+global spinlock_unlock
+
+; void spinlock_lock(struct spinlock* lock)
+spinlock_lock:
+    mov eax, [esp+4]
+.try_again:
+    ; Atomically set the lock bit, the carry flag holds its old value
+    lock bts dword [eax], 0
+    jc .spin
+    ret
+.spin:
+    ; Wait without hammering the bus until the lock looks free
+    pause
+    test dword [eax], 1
+    jnz .spin
+    jmp .try_again
+
+; void spinlock_unlock(struct spinlock* lock)
+spinlock_unlock:
+    mov eax, [esp+4]
+    ; Aligned stores are atomic and x86 does not reorder them before earlier stores
+    mov dword [eax], 0
+    ret
@@ -0,0 +1,18 @@
+#ifndef SPINLOCK_H
+#define SPINLOCK_H
+
+#include <stdint.h>
+
+struct spinlock
+{
+    // Non zero whilst a processor holds the lock
+    volatile uint32_t locked;
+};
+
+/**
+ * Spins until we own the lock, interrupts should be disabled as the lock is not recursive
+ */
+void spinlock_lock(struct spinlock *lock);
+void spinlock_unlock(struct spinlock *lock);
+
+#endif
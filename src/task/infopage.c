@@ -0,0 +1,58 @@
+#include "infopage.h"
+#include "task.h"
+#include "process.h"
+#include "timer/clock.h"
+#include "memory/kheap.h"
+#include "memory/paging/paging.h"
+#include "config.h"
+#include "status.h"
+
+// These symbols are added during linking process automatically with "ld" command
+extern void *__BUILD_DATE;
+extern void *__BUILD_NUMBER;
+
+/**
+ * Allocates the page and fills in everything that is known before the process starts
+ */
+static struct info_page *info_page_new()
+{
+    // The kernel heap hands out whole pages so this is page aligned
+    struct info_page *page = kzalloc(COS32_PAGE_SIZE);
+    if (!page)
+    {
+        return 0;
+    }
+
+    page->version = INFO_PAGE_VERSION;
+    page->build_no = (uint32_t)&__BUILD_NUMBER;
+    page->date = (uint32_t)&__BUILD_DATE;
+    page->tsc_mult = clock_tsc_mult();
+    page->tsc_shift = CLOCK_SHIFT;
+    page->tsc_start = clock_tsc_start();
+    return page;
+}
+
+int info_page_map(struct task *task)
+{
+    struct process *process = task->process;
+    if (!process->info_page)
+    {
+        process->info_page = info_page_new();
+        if (!process->info_page)
+        {
+            return -ENOMEM;
+        }
+    }
+
+    // Not writeable so the process can't lie to its self about the time
+    return paging_map(task->page_directory->directory_entry, (void *)COS32_INFO_PAGE_VIRTUAL_ADDRESS, process->info_page,
+                      PAGING_PAGE_PRESENT | PAGING_ACCESS_FROM_ALL);
+}
+
+void info_page_update(struct process *process)
+{
+    struct info_page *page = process->info_page;
+    page->process_id = process->id;
+    page->argc = process->arguments.argc;
+    page->argv = process->arguments.argv;
+}
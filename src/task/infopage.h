@@ -0,0 +1,40 @@
+#ifndef INFOPAGE_H
+#define INFOPAGE_H
+
+#include <stdint.h>
+
+// Bumped whenever the layout of struct info_page changes
+#define INFO_PAGE_VERSION 1
+
+struct task;
+struct process;
+
+// A page the kernel shares read only with every process so common queries need no system call
+// The layout is shared with user space, keep in sync with the stdlib
+struct info_page
+{
+    uint32_t version;
+    uint32_t build_no;
+    uint32_t date;
+    uint32_t process_id;
+
+    int argc;
+    char **argv;
+
+    // Nanoseconds are ((tsc - tsc_start) * tsc_mult) >> tsc_shift, zero if there is no time stamp counter
+    uint32_t tsc_mult;
+    uint32_t tsc_shift;
+    uint64_t tsc_start;
+};
+
+/**
+ * Maps the info page of the task's process at COS32_INFO_PAGE_VIRTUAL_ADDRESS, creating it if needed
+ */
+int info_page_map(struct task *task);
+
+/**
+ * Writes the process id and arguments into the info page, called once they are known
+ */
+void info_page_update(struct process *process);
+
+#endif
@@ -0,0 +1,10 @@
+[BITS 32]
+section .asm
+
+global kthread_yield
+
+; void kthread_yield()
+kthread_yield:
+    ; The interrupt handler saves our state for us and moves onto the next task
+    int 0x81
+    ret
@@ -0,0 +1,153 @@
+#include "kthread.h"
+#include "task.h"
+#include "memory/kheap.h"
+#include "memory/memory.h"
+#include "timer/pit.h"
+#include "idt/idt.h"
+#include "status.h"
+#include "config.h"
+#include "kernel.h"
+#include "smp/smp.h"
+
+static void kthread_yield_interrupt()
+{
+    // Our state was saved by the interrupt handler so we can just move on
+    task_next();
+}
+
+static void kthread_idle(void *arg)
+{
+    while (1)
+    {
+        // Wait for the next interrupt, sti only takes effect after hlt so nothing can slip in before we halt
+        __asm__ __volatile__("sti; hlt; cli");
+
+        // The interrupt may have woken a task for us, timers no longer come round often enough to wait for them
+        kthread_yield();
+    }
+}
+
+static struct task *kthread_new(KTHREAD_FUNCTION function, void *arg)
+{
+    int res = 0;
+    struct task *task = kzalloc(sizeof(struct task));
+    if (!task)
+    {
+        res = -ENOMEM;
+        goto out;
+    }
+
+    task->kernel_stack = kzalloc(COS32_KTHREAD_STACK_SIZE);
+    if (!task->kernel_stack)
+    {
+        res = -ENOMEM;
+        goto out;
+    }
+
+    // Interrupts taken by a kernel thread run on its own stack, so only the boot processor may run them
+    task->flags = TASK_FLAG_KERNEL_THREAD | TASK_FLAG_PINNED;
+    task->cpu = 0;
+    task->running_cpu = -1;
+    task->page_directory = kernel_page_get_chunk();
+    task->awake = true;
+
+    // When the function returns it will return into kthread_exit, stack grows downwards
+    uint32_t *sp_ptr = (uint32_t *)(task->kernel_stack + COS32_KTHREAD_STACK_SIZE);
+    *--sp_ptr = (uint32_t)arg;
+    *--sp_ptr = (uint32_t)kthread_exit;
+
+    task->registers.ip = (uint32_t)function;
+    task->registers.cs = KERNEL_CODE_SEGMENT;
+    task->registers.ss = KERNEL_DATA_SEGMENT;
+    task->registers.esp = (uint32_t)sp_ptr;
+
+    // Kernel threads start with interrupts enabled so they can be preempted
+    task->registers.flags = 0x202;
+
+out:
+    if (ISERR(res))
+    {
+        if (task)
+        {
+            kfree(task->kernel_stack);
+        }
+        kfree(task);
+        return ERROR(res);
+    }
+
+    return task;
+}
+
+void kthread_init_idle()
+{
+    // The idle thread is not part of the task queue, it only runs when nothing else is awake
+    struct task *idle = kthread_new(kthread_idle, 0);
+    if (ISERR(idle))
+    {
+        panic("Failed to create the idle kernel thread\n");
+    }
+
+    task_set_idle(idle);
+}
+
+void kthread_init()
+{
+    ASSERT(kernel_page_get_chunk());
+    ASSERT(idt_register_interrupt_callback(ISR_KTHREAD_YIELD_INTERRUPT, kthread_yield_interrupt) == 0);
+    kthread_init_idle();
+}
+
+struct task *kthread_create(const char *name, KTHREAD_FUNCTION function, void *arg)
+{
+    struct task *task = kthread_new(function, arg);
+    if (ISERR(task))
+    {
+        return task;
+    }
+
+    task->name = name;
+    task_list_add(task);
+    return task;
+}
+
+void kthread_exit()
+{
+    // Nothing must interrupt us between pausing and switching away
+    disable_interrupts();
+    smp_lock_kernel();
+
+    struct task *task = task_current();
+    ASSERT(task_is_kernel_thread(task));
+
+    // We can't free the stack we are running on, the task is freed once no processor is running it
+    task_pause(task);
+    task->flags |= TASK_FLAG_REAP;
+
+    task_next();
+}
+
+void kthread_sleep(uint32_t millis)
+{
+    // We must not be preempted between going to sleep and yielding
+    disable_interrupts();
+    smp_lock_kernel();
+    struct task *task = task_current();
+    task->awake = false;
+    task->awake_at = pit_get_millis() + millis;
+    pit_reschedule();
+
+    // Only the boot processor wakes tasks and it can't until we have yielded, interrupts are still off
+    smp_unlock_kernel();
+    kthread_yield();
+    enable_interrupts();
+}
+
+void kthread_wait()
+{
+    task_pause(task_current());
+
+    // From here on a waker finds us asleep, waking us before we yield just means we are picked again
+    smp_unlock_kernel();
+    kthread_yield();
+    enable_interrupts();
+}
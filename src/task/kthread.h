@@ -0,0 +1,52 @@
+#ifndef KTHREAD_H
+#define KTHREAD_H
+
+#include <stdint.h>
+
+struct task;
+
+typedef void (*KTHREAD_FUNCTION)(void *arg);
+
+/**
+ * Creates the idle kernel thread and registers the kernel thread yield interrupt.
+ * Must be called once paging is setup for the kernel
+ */
+void kthread_init();
+
+/**
+ * Creates the idle kernel thread for the processor we are running on
+ */
+void kthread_init_idle();
+
+/**
+ * Creates a new kernel thread that will run the given function with the given argument.
+ * Kernel threads have no process, no video memory and run in ring zero on the kernel page.
+ * The thread is scheduled alongside user tasks and exits when the function returns.
+ * The name is shown in task statistics and must outlive the thread
+ */
+struct task *kthread_create(const char *name, KTHREAD_FUNCTION function, void *arg);
+
+/**
+ * Terminates the current kernel thread, we never return from this function
+ */
+void kthread_exit();
+
+/**
+ * Gives up the processor to the next task, the current kernel thread will run again when it is next scheduled
+ */
+void kthread_yield();
+
+/**
+ * Puts the current kernel thread to sleep for the given amount of milliseconds.
+ * Must be called with interrupts enabled
+ */
+void kthread_sleep(uint32_t millis);
+
+/**
+ * Puts the current kernel thread to sleep until another task wakes it with task_wake.
+ * Must be called with interrupts disabled whilst holding the kernel lock so nobody can wake us between
+ * checking for work and going to sleep. Returns with interrupts enabled and the lock released
+ */
+void kthread_wait();
+
+#endif
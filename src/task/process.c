@@ -13,6 +13,9 @@
 #include "loader/library.h"
 
 #include "task.h"
+#include "thread.h"
+#include "infopage.h"
+#include "isr80h/trace.h"
 #include "kernel.h"
 
 // The current process that was just running or is running
@@ -20,7 +23,18 @@ struct process *current_process = 0;
 // This is true if the process is running right now
 bool process_is_running = 0;
 
-struct process *processes[COS32_MAX_PROCESSES] = {};
+// Every process in the order they were loaded
+static struct process *process_head = 0;
+static struct process *process_tail = 0;
+
+// Processes that were terminated whilst their tasks ran on another processor, waiting for them to be reaped
+static struct process *process_dying_head = 0;
+
+// Each bucket is a list of processes chained through "hash_next"
+static struct process *process_hash[COS32_PROCESS_HASH_BUCKETS];
+
+// The id the next process gets
+static int process_next_id = 0;
 
 static void process_init(struct process *process)
 {
@@ -198,31 +212,100 @@ int process_start(struct process *process)
 
     process->started = true;
 
+    // The process id and arguments are known now
+    info_page_update(process);
+
     // As we have started a process we should switch to it
     process_switch(process);
 
     return 0;
 }
 
-int process_get_free_slot()
+static int process_hash_index(int id)
+{
+    return (uint32_t)id % COS32_PROCESS_HASH_BUCKETS;
+}
+
+struct process *process_get(int id)
+{
+    struct process *process = process_hash[process_hash_index(id)];
+    while (process)
+    {
+        if (process->id == id)
+        {
+            return process;
+        }
+        process = process->hash_next;
+    }
+
+    return NULL;
+}
+
+struct process *process_list_head()
 {
-    for (int i = 0; i < COS32_MAX_PROCESSES; i++)
+    return process_head;
+}
+
+static int process_new_id()
+{
+    // Only once the ids wrap around can the next one still be in use
+    while (process_get(process_next_id))
     {
-        if (processes[i] == 0)
-            return i;
+        process_next_id = (process_next_id + 1) & 0x7FFFFFFF;
     }
 
-    return -1;
+    int id = process_next_id;
+    process_next_id = (process_next_id + 1) & 0x7FFFFFFF;
+    return id;
 }
 
-struct process *process_get(int index)
+static void process_list_add(struct process *process)
 {
-    // Out of bounds
-    if (index < 0 || index >= COS32_MAX_PROCESSES)
+    process->prev = process_tail;
+    if (process_tail)
+    {
+        process_tail->next = process;
+    }
+    process_tail = process;
+
+    if (!process_head)
     {
-        return NULL;
+        process_head = process;
     }
-    return processes[index];
+
+    int index = process_hash_index(process->id);
+    process->hash_next = process_hash[index];
+    process_hash[index] = process;
+}
+
+static void process_list_remove(struct process *process)
+{
+    if (process->prev)
+    {
+        process->prev->next = process->next;
+    }
+
+    if (process->next)
+    {
+        process->next->prev = process->prev;
+    }
+
+    if (process == process_head)
+    {
+        process_head = process->next;
+    }
+
+    if (process == process_tail)
+    {
+        process_tail = process->prev;
+    }
+
+    struct process **link = &process_hash[process_hash_index(process->id)];
+    while (*link != process)
+    {
+        link = &(*link)->hash_next;
+    }
+    *link = process->hash_next;
 }
 
 static int process_load_binary_data(const char *filename, struct process *process)
@@ -464,6 +547,12 @@ int process_crash(struct process *process, int error_code)
     struct command_argument *root_argument = 0;
     int res = 0;
 
+    // A task of a process terminated from another processor may fault before it leaves its processor
+    if (process->dying)
+    {
+        goto out;
+    }
+
     // Store the filename of the crashed process
     char filename[COS32_MAX_PATH];
     strncpy(filename, process->filename, sizeof(filename));
@@ -511,7 +600,7 @@ int process_terminate(struct process *process, int error_code)
     return 0;
 }
 
-int process_load_for_slot(const char *filename, struct process **process, int process_slot, struct process *parent, PROCESS_FLAGS flags)
+int process_load(const char *filename, struct process **process, struct process *parent, PROCESS_FLAGS flags)
 {
     int res = 0;
     struct task *task = 0;
@@ -525,13 +614,6 @@ int process_load_for_slot(const char *filename, struct process **process, int pr
         goto out;
     }
 
-    // A process with the given id is already taken
-    if (process_get(process_slot) != 0)
-    {
-        res = -EISTKN;
-        goto out;
-    }
-
     _process = kzalloc(sizeof(struct process));
     if (!_process)
     {
@@ -577,6 +659,7 @@ int process_load_for_slot(const char *filename, struct process **process, int pr
     }
 
     _process->task = task;
+    _process->threads[0] = task;
     // We now need to map the process memory into real memory
     res = process_map_memory(_process);
     if (res < 0)
@@ -585,13 +668,12 @@ int process_load_for_slot(const char *filename, struct process **process, int pr
     }
 
     // Set the process ID so we can reference it later.
-    _process->id = process_slot;
+    _process->id = process_new_id();
 
     // We have the program loaded :o
     *process = _process;
 
-    // Add the process to the array
-    processes[process_slot] = _process;
+    process_list_add(_process);
 
 out:
     if (ISERR(res))
@@ -608,12 +690,14 @@ out:
 
 static struct process *process_get_first_ignore(struct process *process)
 {
-    for (int i = 0; i < COS32_MAX_PROCESSES; i++)
+    struct process *current = process_head;
+    while (current)
     {
-        if (processes[i] != 0 && processes[i] != process)
+        if (current != process)
         {
-            return processes[i];
+            return current;
         }
+        current = current->next;
     }
 
     return NULL;
@@ -632,7 +716,7 @@ void **process_get_free_heap_allocation_slot(struct process *process)
 
 int process_paging_map_to(struct process *process, void *virt, void *phys, void *phys_end, int flags)
 {
-    // Currently only one task per process exists
+    // All threads of the process share the page directory of the main task
     return paging_map_to(process->task->page_directory->directory_entry, virt, phys, phys_end, flags);
 }
 
@@ -720,12 +804,17 @@ static void process_free_allocations(struct process *process)
 void process_terminate_subprocesses(struct process *process)
 {
     // We must loop through all the processes and if their parent is the one provided we must terminate them
-    for (int i = 0; i < COS32_MAX_PROCESSES; i++)
+    struct process *current = process_head;
+    while (current)
     {
-        if (processes[i] != 0 && processes[i]->parent == process)
+        if (current->parent == process)
         {
-            process_free(processes[i]);
+            // Freeing a subprocess frees its own subprocesses too so we start again from the top
+            process_free(current);
+            current = process_head;
+            continue;
         }
+        current = current->next;
     }
 }
 
@@ -743,8 +832,38 @@ void process_pause(struct process *process)
     task_pause(process->task);
 }
 
+/**
+ * Frees the memory of a process that has no tasks left
+ */
+static void process_release(struct process *process)
+{
+    // Delete the process allocations
+    process_free_allocations(process);
+
+    // Let's delete the process data
+    process_free_data(process);
+
+    // Free the video memory, only if we are the ones responsible for it
+    if (!(process->flags & PROCESS_USE_PARENT_VIDEO_MEMORY))
+    {
+        video_free(process->video);
+    }
+
+    kfree(process->info_page);
+    isr80h_trace_process_free(process);
+
+    // Delete the process memory
+    kfree(process);
+}
+
 void process_free(struct process *process)
 {
+    // The tasks of a dying process may still crash or exit on their way off their processor
+    if (process->dying)
+    {
+        return;
+    }
+
     /**
     * In the event the system runs out of running processes, unsure how to respond
     * maybe we start a new process or just panic the system like this....
@@ -764,43 +883,47 @@ void process_free(struct process *process)
     // We must first terminate all subprocesses
     process_terminate_subprocesses(process);
 
-    // Delete the process allocations
-    process_free_allocations(process);
-
-    // Delete the task in question
-    task_free(process->task);
-
-    // Let's delete the process data
-    process_free_data(process);
-
-    // Free the video memory, only if we are the ones responsible for it
-    if (!(process->flags & PROCESS_USE_PARENT_VIDEO_MEMORY))
+    if (process->flags & PROCESS_UNPAUSE_PARENT_ON_DEATH)
     {
-        video_free(process->video);
+        process_wake(process->parent);
     }
 
-    if (process->flags & PROCESS_UNPAUSE_PARENT_ON_DEATH)
+    // Nobody may find the process once its memory is gone
+    process_list_remove(process);
+
+    // Another processor would be left running a freed task, the task mechanism reaps our tasks once they have left
+    if (task_stop_process(process))
     {
-        process_wake(process->parent);
+        process->dying = true;
+        process->dying_page_directory = process->task->page_directory;
+        process->next = process_dying_head;
+        process_dying_head = process;
+        return;
     }
-    // Delete the process memory
-    kfree(process);
 
-    // Let's free up the process slot
-    processes[process->id] = 0;
+    // Delete the threads before the main task as they share its page directory
+    thread_free_all(process);
+
+    // Delete the task in question
+    task_free(process->task);
+
+    process_release(process);
 }
 
-int process_load(const char *filename, struct process **process, struct process *parent, PROCESS_FLAGS flags)
+void process_reap()
 {
-    int res = 0;
-    int process_slot = process_get_free_slot();
-    if (process_slot < 0)
+    struct process **link = &process_dying_head;
+    while (*link)
     {
-        res = -ENOMEM;
-        goto out;
-    }
+        struct process *process = *link;
+        if (task_process_has_tasks(process))
+        {
+            link = &process->next;
+            continue;
+        }
 
-    res = process_load_for_slot(filename, process, process_slot, parent, flags);
-out:
-    return res;
+        *link = process->next;
+        paging_free_4gb(process->dying_page_directory);
+        process_release(process);
+    }
 }
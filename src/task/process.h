@@ -36,13 +36,16 @@ struct process_arguments
 
 struct process
 {
-    // The id of this process
-    uint8_t id;
+    // The id of this process, ids are not reused until they wrap around
+    int id;
 
     char filename[COS32_MAX_PATH];
-    // Each process has a task for its self
+    // Each process has a task for its self, this is the main thread. Other threads share its page directory
     struct task *task;
 
+    // The threads of this process indexed by thread id, index zero is the main task. NULL if the slot is free
+    struct task *threads[COS32_MAX_THREADS_PER_PROCESS];
+
     // These are all the heap allocations that this process has, if its not NULL then its allocated
     // Limiting the user process to maximum allocations is not the best idea
     // maybe switch to linked list..
@@ -85,14 +88,37 @@ struct process
         char buffer[COS32_KEYBOARD_BUFFER_SIZE];
         int tail;
         int head;
+
+        // The task sleeping until a key is pressed, NULL if nobody is waiting
+        struct task *waiting_task;
     } keyboard;
 
     // Process arguments passed to this process
     struct process_arguments arguments;
 
+    // Shared read only with the process, see infopage.h
+    struct info_page *info_page;
+
+    // System call statistics for this process, NULL until the tracer records a call
+    struct isr80h_trace_table *trace;
+
     // The video memory for this process, when we switch to this process the video memory
     // Should be wrote back out overwriting the current screen memory
     struct video *video;
+
+    // The next and previous process in the list of every process, a dying process is kept on its own list through "next"
+    struct process *next;
+    struct process *prev;
+
+    // True once the process was terminated whilst one of its tasks was still running on another processor.
+    // Nobody can find it any more, it is freed when the last of its tasks has been reaped
+    bool dying;
+
+    // The page directory the tasks of a dying process share, it is freed with the process
+    struct paging_4gb_chunk *dying_page_directory;
+
+    // The next process in the same bucket of the id hash table
+    struct process *hash_next;
 };
 
 int process_load(const char *filename, struct process **process, struct process *parent, PROCESS_FLAGS flags);
@@ -125,8 +151,16 @@ int process_count_command_arguments(struct command_argument *argument);
  */
 int process_run_for_argument(struct command_argument *root_argument, struct process *parent, PROCESS_FLAGS flags);
 int process_load_start(const char *path, struct process *parent, PROCESS_FLAGS flags, struct command_argument *root_argument);
-int process_load_for_slot(const char *filename, struct process **process, int process_slot, struct process *parent, PROCESS_FLAGS flags);
-struct process *process_get(int index);
+
+/**
+ * Returns the process with the given id, NULL if there is no such process
+ */
+struct process *process_get(int id);
+
+/**
+ * Returns the first process in the list of every process, follow "next" for the rest
+ */
+struct process *process_list_head();
 bool process_running();
 void process_mark_running(bool running);
 struct process *process_current();
@@ -137,10 +171,16 @@ struct process *process_current();
 void *process_malloc(struct process *process, int size);
 
 /**
- * Frees and unloads the given process
+ * Frees and unloads the given process. If one of its tasks is running on another processor the process only
+ * dies now, it is freed by process_reap once that task has left the processor
  */
 void process_free(struct process *process);
 
+/**
+ * Frees the dying processes whose tasks have all been reaped, called by the task mechanism after it reaps tasks
+ */
+void process_reap();
+
 /**
  * Maps pages into memory starting at the physical address until the physical end address is reached.
  * Pages are mapped into the address starting at "virt"
@@ -0,0 +1,130 @@
+#include "mlfq.h"
+#include "task/task.h"
+
+static struct task *mlfq_next(struct task *current);
+static bool mlfq_tick(struct task *current);
+static void mlfq_boost(struct task *task);
+
+static struct task_scheduler mlfq_scheduler = {
+    .next = mlfq_next,
+    .tick = mlfq_tick,
+    .boost = mlfq_boost,
+    .priority_changed = mlfq_boost,
+    .name = "mlfq"};
+
+// Timer ticks since we last moved every task back up to its priority
+static int ticks_since_boost = 0;
+
+struct task_scheduler *mlfq_init()
+{
+    return &mlfq_scheduler;
+}
+
+static int mlfq_time_slice(int level)
+{
+    return MLFQ_BASE_TIME_SLICE << level;
+}
+
+static int mlfq_level(struct task *task)
+{
+    // A task is never above the priority it asked for
+    return task->level < task->priority ? task->priority : task->level;
+}
+
+/**
+ * Finds the next runnable task at the given level after the current task, flipping back around
+ * when we reach the end of the task queue so tasks of the same level take turns
+ */
+static struct task *mlfq_next_at_level(struct task *current, int level)
+{
+    struct task *task = current ? current->next : 0;
+    struct task *start = task;
+    do
+    {
+        if (!task)
+        {
+            task = task_list_head();
+        }
+
+        if (task_is_runnable(task) && mlfq_level(task) == level)
+        {
+            return task;
+        }
+
+        task = task->next;
+    } while (task != start);
+
+    return 0;
+}
+
+static struct task *mlfq_next(struct task *current)
+{
+    for (int level = 0; level < TASK_PRIORITY_LEVELS; level++)
+    {
+        struct task *task = mlfq_next_at_level(current, level);
+        if (task)
+        {
+            return task;
+        }
+    }
+
+    return 0;
+}
+
+static void mlfq_boost(struct task *task)
+{
+    task->level = task->priority;
+    task->ticks_used = 0;
+}
+
+static void mlfq_boost_all()
+{
+    struct task *task = task_list_head();
+    while (task)
+    {
+        mlfq_boost(task);
+        task = task->next;
+    }
+}
+
+static bool mlfq_higher_level_awake(struct task *current)
+{
+    int level = mlfq_level(current);
+    struct task *task = task_list_head();
+    while (task)
+    {
+        if (task_is_runnable(task) && mlfq_level(task) < level)
+        {
+            return true;
+        }
+        task = task->next;
+    }
+
+    return false;
+}
+
+static bool mlfq_tick(struct task *current)
+{
+    ticks_since_boost++;
+    if (ticks_since_boost >= MLFQ_BOOST_INTERVAL_TICKS)
+    {
+        ticks_since_boost = 0;
+        mlfq_boost_all();
+        return true;
+    }
+
+    // The time slice is counted across sleeps so a task can't stay up high by sleeping just before it runs out
+    current->ticks_used++;
+    if (current->ticks_used >= mlfq_time_slice(mlfq_level(current)))
+    {
+        if (mlfq_level(current) < TASK_PRIORITY_LEVELS - 1)
+        {
+            current->level = mlfq_level(current) + 1;
+        }
+        current->ticks_used = 0;
+        return true;
+    }
+
+    // Someone more important may have woken up since we started running
+    return mlfq_higher_level_awake(current);
+}
@@ -0,0 +1,17 @@
+#ifndef MLFQ_H
+#define MLFQ_H
+
+// The amount of timer ticks a task gets at level zero, each lower level doubles it
+#define MLFQ_BASE_TIME_SLICE 1
+
+// Every so many timer ticks all tasks are moved back up to their priority so nobody starves
+#define MLFQ_BOOST_INTERVAL_TICKS 50
+
+/**
+ * Multilevel feedback queue scheduler. Tasks that use their full time slice are moved down a level,
+ * the highest level with an awake task always runs first. Tasks waking up from waiting on user input are
+ * moved back up to their priority so the shell stays responsive under load
+ */
+struct task_scheduler *mlfq_init();
+
+#endif
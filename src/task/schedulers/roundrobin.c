@@ -0,0 +1,44 @@
+#include "roundrobin.h"
+#include "task/task.h"
+
+static struct task *roundrobin_next(struct task *current);
+static bool roundrobin_tick(struct task *current);
+
+static struct task_scheduler roundrobin_scheduler = {
+    .next = roundrobin_next,
+    .tick = roundrobin_tick,
+    .name = "roundrobin"};
+
+struct task_scheduler *roundrobin_init()
+{
+    return &roundrobin_scheduler;
+}
+
+static struct task *roundrobin_next(struct task *current)
+{
+    // Start with the task after the current one, flipping back around when we reach the end of the task queue
+    struct task *task = current ? current->next : 0;
+    struct task *start = task;
+    do
+    {
+        if (!task)
+        {
+            task = task_list_head();
+        }
+
+        if (task_is_runnable(task))
+        {
+            return task;
+        }
+
+        task = task->next;
+    } while (task != start);
+
+    return 0;
+}
+
+static bool roundrobin_tick(struct task *current)
+{
+    // Everyone gets one tick at a time
+    return true;
+}
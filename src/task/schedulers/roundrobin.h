@@ -0,0 +1,9 @@
+#ifndef ROUNDROBIN_H
+#define ROUNDROBIN_H
+
+/**
+ * The simple scheduler, every awake task gets one timer tick in turn. Priorities are ignored
+ */
+struct task_scheduler *roundrobin_init();
+
+#endif
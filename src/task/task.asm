@@ -2,6 +2,7 @@
 section .asm
 
 global task_return
+global task_return_kernel
 global user_registers
 global restore_general_purpose_registers
 
@@ -70,6 +71,39 @@ task_return:
     ; Let's leave and execute!
     iretd
 
+; void task_return_kernel(struct registers* regs)
+task_return_kernel:
+    ; Let's access the structure passed to us
+    mov ebx, [esp+4]
+
+    ; Returning to ring zero will not pop a stack pointer so we must switch to the kernel threads stack ourselves
+    mov esp, [ebx+40]
+
+    ; Push the flags the kernel thread had when we left it
+    push dword[ebx+36]
+
+    ; Push the code segment
+    push dword[ebx+32]
+
+    ; Push the IP we want to execute
+    push dword[ebx+28]
+
+    ; Kernel threads use the kernel data segment
+    mov ax, [ebx+44]
+    mov ds, ax
+    mov es, ax
+    mov fs, ax
+    mov gs, ax
+
+    ; Restore the registers provided to us
+    push ebx
+    call restore_general_purpose_registers
+    ; We can't pop this or we will corrupt a register, lets adjust the stack pointer to discard
+    add esp, 4
+
+    ; Let's leave and execute!
+    iretd
+
 ; void restore_general_purpose_registers(struct registers* registers)
 restore_general_purpose_registers:
     push esp
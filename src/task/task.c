@@ -8,13 +8,23 @@
 #include "timer/pit.h"
 #include "idt/idt.h"
 #include "process.h"
+#include "infopage.h"
+#include "schedulers/roundrobin.h"
+#include "schedulers/mlfq.h"
 #include "status.h"
 #include "config.h"
 #include "kernel.h"
-struct task *current_task = 0;
+#include "cpu/cpu.h"
+#include "cpu/fpu.h"
+#include "smp/smp.h"
 struct task *task_tail = 0;
 struct task *task_head = 0;
 
+static struct task_scheduler *schedulers[COS32_MAX_SCHEDULERS];
+
+// The scheduler that decides which task runs next
+static struct task_scheduler *scheduler = 0;
+
 void user_registers();
 
 void task_current_save_state(struct interrupt_frame *frame)
@@ -39,6 +49,7 @@ void task_usleep(struct task *task, uint32_t millis)
 {
     task->awake = false;
     task->awake_at = pit_get_millis() + millis;
+    pit_reschedule();
 
     // Let's switch to the next task if the current task is us as we are sleeping now and should not return
     if (task == task_current())
@@ -47,10 +58,35 @@ void task_usleep(struct task *task, uint32_t millis)
     }
 }
 
+/**
+ * Returns the processor that looks after the given task, its timer wakes the task and ends its timeslices
+ */
+static int task_cpu(struct task *task)
+{
+    return (task->flags & TASK_FLAG_PINNED) ? task->cpu : task->home_cpu;
+}
+
+/**
+ * Lets the processor of a task that just became runnable know, it may be idle or need its timeslice cut short
+ */
+static void task_notify(struct task *task)
+{
+    int cpu_id = task_cpu(task);
+    if (cpu_id != cpu_current()->id)
+    {
+        smp_reschedule(cpu_id);
+        return;
+    }
+
+    // An idle processor picks the task once the interrupt we are handling returns
+    pit_reschedule();
+}
+
 void task_wake(struct task *task)
 {
     task->awake = true;
     task->awake_at = -1;
+    task_notify(task);
 }
 
 void task_wake_tasks()
@@ -72,9 +108,111 @@ void task_wake_tasks()
     }
 }
 
+long task_next_deadline()
+{
+    long now = pit_get_millis();
+    long deadline = -1;
+    int runnable = 0;
+    int cpu_id = cpu_current()->id;
+    struct task *current = task_head;
+    while (current != 0)
+    {
+        // Every processor's timer looks after its own tasks
+        if (task_cpu(current) != cpu_id)
+        {
+            goto next;
+        }
+
+        if (current->awake)
+        {
+            runnable++;
+            goto next;
+        }
+
+        if (current->awake_at == -1)
+        {
+            goto next;
+        }
+
+        // Tasks are woken once the time is past "awake_at"
+        long remaining = current->awake_at - now + 1;
+        if (deadline == -1 || remaining < deadline)
+        {
+            deadline = remaining < 1 ? 1 : remaining;
+        }
+    next:
+        current = current->next;
+    }
+
+    // Tasks competing for the processor need the timer to end their timeslice
+    if (runnable > 1 && (deadline == -1 || deadline > PIT_TIMER_AVERAGE_MS))
+    {
+        deadline = PIT_TIMER_AVERAGE_MS;
+    }
+
+    return deadline;
+}
+
+static void task_reap_tasks()
+{
+    struct task *current = task_head;
+    while (current != 0)
+    {
+        struct task *next = current->next;
+        // A task still running on a processor is reaped next time
+        if ((current->flags & TASK_FLAG_REAP) && current->running_cpu == -1)
+        {
+            task_free(current);
+        }
+        current = next;
+    }
+
+    // A process terminated whilst its tasks were running elsewhere goes with the last of them
+    process_reap();
+}
+
+static void task_account_tick()
+{
+    // The registers were saved when the timer interrupted the current task
+    struct task *task = task_current();
+    if ((task->registers.cs & 0x03) == 0x03)
+    {
+        task->statistics.user_ticks++;
+    }
+    else
+    {
+        task->statistics.kernel_ticks++;
+    }
+}
+
+static void task_account_waiting()
+{
+    struct task *current = task_head;
+    while (current != 0)
+    {
+        if (current->awake && current->running_cpu == -1)
+        {
+            current->statistics.wait_ticks++;
+        }
+        current = current->next;
+    }
+}
+
 void task_process()
 {
+    task_account_tick();
+
+    // Each processor's timer is only due for its own sleepers but waking any that are due is harmless
     task_wake_tasks();
+
+    // The boot processor does the rest of the bookkeeping
+    if (cpu_current()->id != 0)
+    {
+        return;
+    }
+
+    task_account_waiting();
+    task_reap_tasks();
 }
 
 int task_switch(struct task *task)
@@ -84,7 +222,16 @@ int task_switch(struct task *task)
         panic("???");
     }
     ASSERT(task->page_directory);
-    current_task = task;
+
+    // Other processors must not pick a task whilst we are running it
+    struct cpu *cpu = cpu_current();
+    fpu_switch(cpu, cpu->task, task);
+    if (cpu->task)
+    {
+        cpu->task->running_cpu = -1;
+    }
+    task->running_cpu = cpu->id;
+    cpu->task = task;
 
     paging_switch(task->page_directory);
     return 0;
@@ -92,21 +239,33 @@ int task_switch(struct task *task)
 
 struct task *task_current()
 {
-    return current_task;
+    return cpu_current()->task;
 }
 
 int task_page()
 {
-    return task_page_task(current_task);
+    return task_page_task(task_current());
 }
 
 int task_page_task(struct task* task)
 {
+    if (task_is_kernel_thread(task))
+    {
+        // Kernel threads have no user space, the kernel page is their page
+        kernel_page();
+        return 0;
+    }
+
     user_registers();
     paging_switch(task->page_directory);
     return 0;
 }
 
+bool task_is_kernel_thread(struct task *task)
+{
+    return task->flags & TASK_FLAG_KERNEL_THREAD;
+}
+
 int copy_integer_to_task(struct task *task, void *address, int val)
 {
     int res = 0;
@@ -194,6 +353,55 @@ out:
     return 0;
 }
 
+int copy_to_task(struct task *task, void *virtual, void *phys, int size)
+{
+    ASSERT(is_kernel_page());
+
+    uint32_t *task_directory = task->page_directory->directory_entry;
+    while (size > 0)
+    {
+        // The memory may not be contiguous in physical memory so we copy a page at a time
+        if (!(paging_get(task_directory, paging_align_to_lower_page(virtual)) & PAGING_ACCESS_FROM_ALL))
+        {
+            return -EINVARG;
+        }
+
+        int left_in_page = COS32_PAGE_SIZE - ((uint32_t)virtual % COS32_PAGE_SIZE);
+        int total = size < left_in_page ? size : left_in_page;
+        memcpy(paging_get_physical_address(task_directory, virtual), phys, total);
+
+        virtual += total;
+        phys += total;
+        size -= total;
+    }
+
+    return 0;
+}
+
+int copy_from_task(struct task *task, void *phys, void *virtual, int size)
+{
+    ASSERT(is_kernel_page());
+
+    uint32_t *task_directory = task->page_directory->directory_entry;
+    while (size > 0)
+    {
+        if (!(paging_get(task_directory, paging_align_to_lower_page(virtual)) & PAGING_ACCESS_FROM_ALL))
+        {
+            return -EINVARG;
+        }
+
+        int left_in_page = COS32_PAGE_SIZE - ((uint32_t)virtual % COS32_PAGE_SIZE);
+        int total = size < left_in_page ? size : left_in_page;
+        memcpy(phys, paging_get_physical_address(task_directory, virtual), total);
+
+        virtual += total;
+        phys += total;
+        size -= total;
+    }
+
+    return 0;
+}
+
 uint32_t task_current_get_stack_item_uint(int index)
 {
     return (uint32_t)task_current_get_stack_item(index);
@@ -285,6 +493,13 @@ int task_save_state(struct task *task, struct interrupt_frame *frame)
     task->registers.flags = frame->flags;
     task->registers.esp = frame->esp;
     task->registers.ss = frame->ss;
+    if ((frame->cs & 0x03) == 0)
+    {
+        // We interrupted ring zero so no privilege change happened, the processor did not push
+        // the stack pointer or stack segment. The stack pointer is where they would have been
+        task->registers.esp = (uint32_t)&frame->esp;
+        task->registers.ss = KERNEL_DATA_SEGMENT;
+    }
     task->registers.eax = frame->eax;
     task->registers.ebp = frame->ebp;
     task->registers.ebx = frame->ebx;
@@ -295,41 +510,90 @@ int task_save_state(struct task *task, struct interrupt_frame *frame)
     return 0;
 }
 
+/**
+ * Switches to the given task and returns into it, we never come back from here
+ */
+static void task_return_to(struct task *task)
+{
+    task_switch(task);
+
+    // Nothing after this point touches shared kernel state, the task's stack is only used by this processor
+    smp_unlock_kernel();
+    if (task_is_kernel_thread(task))
+    {
+        task_return_kernel(&task->registers);
+    }
+
+    task_return(&task->registers);
+}
+
 void task_run_first_ever_task()
 {
-    ASSERT(current_task == 0);
+    ASSERT(task_current() == 0);
     ASSERT(task_head);
-    task_switch(task_head);
-    task_return(&task_head->registers);
+    task_return_to(task_head);
 }
 
-static struct task *task_get_next_to(struct task *task)
+static void task_get_info_for_task(struct task *task, struct task_info *info)
 {
-    if (!task->next)
+    memset(info, 0, sizeof(struct task_info));
+    info->process_id = -1;
+    info->thread_id = task->thread_id;
+    info->awake = task->awake;
+    info->priority = task->priority;
+    info->level = task->level;
+    memcpy(&info->statistics, &task->statistics, sizeof(info->statistics));
+
+    if (!task->process)
     {
-        return task_head;
+        const char *name = task->name ? task->name : "kthread";
+        strncpy(info->name, (task->flags & TASK_FLAG_IDLE) ? "idle" : name, sizeof(info->name) - 1);
+        return;
     }
 
-    return task->next;
+    // We only want the file name, not the whole path
+    const char *name = task->process->filename;
+    for (const char *c = name; *c; c++)
+    {
+        if (*c == '/')
+        {
+            name = c + 1;
+        }
+    }
+    info->process_id = task->process->id;
+    strncpy(info->name, name, sizeof(info->name) - 1);
 }
 
-int task_get_count()
+int task_get_info(struct task_info *info, int max)
 {
-    int i = 0;
+    int total = 0;
     struct task *task = task_head;
-    while (task != 0)
+    while (task != 0 && total < max)
     {
-        i++;
+        task_get_info_for_task(task, &info[total]);
+        total++;
         task = task->next;
     }
-    return i;
+
+    // Each processor has its own idle task
+    for (int i = 0; i < COS32_MAX_CPUS && total < max; i++)
+    {
+        struct cpu *cpu = cpu_get(i);
+        if (cpu && cpu->idle)
+        {
+            task_get_info_for_task(cpu->idle, &info[total]);
+            total++;
+        }
+    }
+
+    return total;
 }
 
-int task_get_awake_count()
+int task_get_count()
 {
     int i = 0;
     struct task *task = task_head;
-    while (task != 0 && task->awake)
+    while (task != 0)
     {
         i++;
         task = task->next;
@@ -337,42 +601,175 @@ int task_get_awake_count()
     return i;
 }
 
-static struct task *task_get_next_active_task(struct task *task)
+bool task_is_runnable(struct task *task)
 {
-    struct task *next_task = task_get_next_to(task);
-    if (task_get_awake_count() == 0)
+    struct cpu *cpu = cpu_current();
+    if (!task->awake || (task->flags & TASK_FLAG_REAP))
     {
-        // At least one task always needs to be awake in our implementation
-        // This means we need to forcefully awaken one of the tasks, in the future maybe we can combat this issue
-        task_wake(next_task);
+        return false;
     }
 
-    if (!next_task->awake)
+    // Already running on another processor
+    if (task->running_cpu != -1 && task->running_cpu != cpu->id)
     {
-        next_task = task_get_next_active_task(next_task);
+        return false;
     }
 
-    return next_task;
+    if (task->flags & TASK_FLAG_PINNED)
+    {
+        return task->cpu == cpu->id;
+    }
+
+    // Each processor runs its own tasks first, it only takes work from the others when it has none
+    return cpu->stealing || task->home_cpu == cpu->id;
 }
 
 static struct task *task_get_next()
 {
-    struct task *task = task_get_next_active_task(current_task);
+    struct cpu *cpu = cpu_current();
+    struct task *task = scheduler->next(cpu->task);
+    if (!task)
+    {
+        cpu->stealing = true;
+        task = scheduler->next(cpu->task);
+        cpu->stealing = false;
+        if (task)
+        {
+            // The task now belongs to us so it keeps its cache warm on this processor
+            task->home_cpu = cpu->id;
+        }
+    }
+
+    if (task)
+    {
+        return task;
+    }
+
+    if (cpu->idle)
+    {
+        // Nobody needs the processor, let's idle until an interrupt wakes someone up
+        return cpu->idle;
+    }
+
+    // At least one task always needs to be awake when we have no idle task
+    // This means we need to forcefully awaken one of the tasks
+    task = (cpu->task && cpu->task->next) ? cpu->task->next : task_head;
+    task_wake(task);
     return task;
 }
 
+struct task *task_list_head()
+{
+    return task_head;
+}
+
+bool task_tick()
+{
+    struct task *task = task_current();
+    if ((task->flags & TASK_FLAG_IDLE) || !task->awake)
+    {
+        return true;
+    }
+
+    return scheduler->tick(task);
+}
+
+void task_wake_interactive(struct task *task)
+{
+    task_wake(task);
+    if (scheduler->boost)
+    {
+        scheduler->boost(task);
+    }
+}
+
+int task_set_priority(struct task *task, int priority)
+{
+    if (priority < 0 || priority >= TASK_PRIORITY_LEVELS)
+    {
+        return -EINVARG;
+    }
+
+    task->priority = priority;
+    if (scheduler->priority_changed)
+    {
+        scheduler->priority_changed(task);
+    }
+    return 0;
+}
+
+void task_scheduler_insert(struct task_scheduler *new_scheduler)
+{
+    for (int i = 0; i < COS32_MAX_SCHEDULERS; i++)
+    {
+        if (schedulers[i] == 0)
+        {
+            schedulers[i] = new_scheduler;
+            return;
+        }
+    }
+
+    panic("No more scheduler slots available, failed to register scheduler\n");
+}
+
+int task_scheduler_set(const char *name)
+{
+    for (int i = 0; i < COS32_MAX_SCHEDULERS; i++)
+    {
+        if (schedulers[i] != 0 && strncmp(schedulers[i]->name, name, sizeof(schedulers[i]->name)) == 0)
+        {
+            scheduler = schedulers[i];
+            return 0;
+        }
+    }
+
+    return -EINVARG;
+}
+
+void task_scheduler_init()
+{
+    memset(schedulers, 0, sizeof(schedulers));
+    task_scheduler_insert(roundrobin_init());
+    task_scheduler_insert(mlfq_init());
+
+    if (task_scheduler_set(COS32_DEFAULT_SCHEDULER) < 0)
+    {
+        panic("The default scheduler does not exist\n");
+    }
+}
+
 /**
- * Switches to the next task, used for multi-tasking purposes, flips back around when it reaches
- * the end of the task queue. No priority is currently implemented
+ * Switches to the next task chosen by the current scheduler
  */
 void task_next()
 {
-
+    struct task *current = task_current();
     struct task *task = task_get_next();
+    if (current && task != current)
+    {
+        // If the task we are leaving still wants to run then it did not choose to leave
+        if (current->awake)
+        {
+            current->statistics.involuntary_switches++;
+        }
+        else
+        {
+            current->statistics.voluntary_switches++;
+        }
+        task->statistics.switches++;
+    }
 
-    // Switch the current task and get straight back into user land
-    task_switch(task);
-    task_return(&task->registers);
+    // Switch the current task and get straight back into the task
+    task_return_to(task);
+}
+
+void task_set_idle(struct task *task)
+{
+    // The idle task never leaves the processor it was created for
+    struct cpu *cpu = cpu_current();
+    task->flags |= TASK_FLAG_IDLE | TASK_FLAG_PINNED;
+    task->cpu = cpu->id;
+    cpu->idle = task;
 }
 
 static void task_list_remove(struct task *task)
@@ -382,6 +779,11 @@ static void task_list_remove(struct task *task)
         task->prev->next = task->next;
     }
 
+    if (task->next)
+    {
+        task->next->prev = task->prev;
+    }
+
     if (task == task_head)
     {
         task_head = task->next;
@@ -392,15 +794,15 @@ static void task_list_remove(struct task *task)
         task_tail = task->prev;
     }
 
-    if (task == current_task)
+    if (task == task_current())
     {
-        current_task = task_get_next();
+        cpu_current()->task = task_get_next();
     }
 }
 
 void task_print(const char *message)
 {
-    video_terminal_writestring(&current_task->process->video->properties, message);
+    video_terminal_writestring(&task_current()->process->video->properties, message);
 }
 
 void task_putchar(char c)
@@ -408,7 +810,7 @@ void task_putchar(char c)
     // This only works because the task can see the entire kernel address space, bare in mind problems will happen
     // if I change this in the future
     task_page();
-    video_terminal_putchar(&current_task->process->video->properties, c);
+    video_terminal_putchar(&task_current()->process->video->properties, c);
     kernel_page();
 }
 
@@ -428,25 +830,56 @@ struct task *task_new(struct process *process)
         goto out;
     }
 
+    task_list_add(task);
+
+out:
+    if (ISERR(res))
+    {
+        task_free(task);
+        return ERROR(res);
+    }
+
+    return task;
+}
+
+/**
+ * New tasks are spread across the online processors in turn
+ */
+static int task_pick_home_cpu()
+{
+    static int next_cpu = 0;
+    for (int i = 0; i < COS32_MAX_CPUS; i++)
+    {
+        next_cpu = (next_cpu + 1) % COS32_MAX_CPUS;
+        struct cpu *cpu = cpu_get(next_cpu);
+        if (cpu && cpu->online)
+        {
+            return next_cpu;
+        }
+    }
+
+    return 0;
+}
+
+void task_list_add(struct task *task)
+{
+    task->running_cpu = -1;
+    task->home_cpu = task_pick_home_cpu();
     if (task_head == 0)
     {
         task_head = task;
         task_tail = task;
-        goto out;
+        return;
     }
 
     task_tail->next = task;
     task->prev = task_tail;
     task_tail = task;
 
-out:
-    if (ISERR(res))
+    if (task->awake)
     {
-        task_free(task);
-        return ERROR(res);
+        task_notify(task);
     }
-
-    return task;
 }
 
 int task_map_video_memory(struct task *task)
@@ -507,6 +940,12 @@ int task_init(struct task *task, struct process *process)
     // Let's map the video memory to the tasks video memory, unless its process is the one in view
     ASSERT(task_map_video_memory(task) == 0);
 
+    int res = info_page_map(task);
+    if (res < 0)
+    {
+        return res;
+    }
+
     // NOTE THE ENTIRE 4GB ADDRESS SPACE IS MAPPED TO ITS SELF AT THIS POINT, KEEP IN MIND WHEN RUNNING UNPRIVILAGED CODE
     // A MALICIOUS PROGRAM COULD INSPECT MEMORY AND READ WHAT IT SHOULDNT BE READING
 
@@ -519,16 +958,73 @@ void task_pause(struct task *task)
     task->awake_at = -1;
 }
 
+bool task_stop_process(struct process *process)
+{
+    int cpu_id = cpu_current()->id;
+    bool running = false;
+    for (struct task *task = task_head; task; task = task->next)
+    {
+        if (task->process == process && task->running_cpu != -1 && task->running_cpu != cpu_id)
+        {
+            running = true;
+        }
+    }
+
+    if (!running)
+    {
+        return false;
+    }
+
+    for (struct task *task = task_head; task; task = task->next)
+    {
+        if (task->process != process)
+        {
+            continue;
+        }
+
+        task_pause(task);
+        task->flags |= TASK_FLAG_REAP;
+        if (task->running_cpu != -1)
+        {
+            smp_reschedule(task->running_cpu);
+        }
+    }
+
+    return true;
+}
+
+bool task_process_has_tasks(struct process *process)
+{
+    for (struct task *task = task_head; task; task = task->next)
+    {
+        if (task->process == process)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 int task_free(struct task *task)
 {
     ASSERT(is_kernel_page());
 
-    // Free the paging directory
-    paging_free_4gb(task->page_directory);
+    // Free the paging directory, kernel threads and process threads share a page directory so we leave it alone.
+    // The main task of a dying process is reaped before its threads may be, the process frees the directory
+    if (!(task->flags & (TASK_FLAG_KERNEL_THREAD | TASK_FLAG_THREAD | TASK_FLAG_REAP)))
+    {
+        paging_free_4gb(task->page_directory);
+    }
 
     // Remove our task from the list
     task_list_remove(task);
 
+    // Threads take the user mapping off their stack before they are freed
+    kfree(task->kernel_stack);
+    kfree(task->stack);
+    fpu_task_free(task);
+
     // Finally delete the task memory
     kfree(task);
 
@@ -20,6 +20,60 @@ struct registers
     uint32_t ss;
 };
 
+// The amount of priority levels a task can be at, zero is the highest
+#define TASK_PRIORITY_LEVELS 4
+
+typedef unsigned char TASK_FLAGS;
+
+// This task runs a kernel function in ring zero, it has no process and shares the kernel page directory
+#define TASK_FLAG_KERNEL_THREAD 0b00000001
+// This task is an additional thread of a process, it shares the page directory of the main task
+#define TASK_FLAG_THREAD 0b00000010
+// This thread has exited and is waiting to be joined
+#define TASK_FLAG_EXITED 0b00000100
+// This task is finished with and should be freed once it is no longer running
+#define TASK_FLAG_REAP 0b00001000
+// The task only ever runs on the processor in "cpu"
+#define TASK_FLAG_PINNED 0b00010000
+// The task is a processor's idle task and is not part of the task queue
+#define TASK_FLAG_IDLE 0b00100000
+
+struct task_statistics
+{
+    // Timer ticks spent running in user space
+    uint32_t user_ticks;
+
+    // Timer ticks spent running in the kernel
+    uint32_t kernel_ticks;
+
+    // The amount of times this task was switched to
+    uint32_t switches;
+
+    // The amount of times this task gave up the processor because it slept, paused or exited
+    uint32_t voluntary_switches;
+
+    // The amount of times this task was switched out whilst it still wanted to run
+    uint32_t involuntary_switches;
+
+    // Timer ticks spent awake but waiting for another task to finish running
+    uint32_t wait_ticks;
+};
+
+#define TASK_INFO_NAME_SIZE 20
+
+// A snapshot of a task, this structure is shared with user space
+struct task_info
+{
+    // The id of the process this task belongs to, below zero for kernel threads
+    int process_id;
+    int thread_id;
+    char name[TASK_INFO_NAME_SIZE];
+    int awake;
+    int priority;
+    int level;
+    struct task_statistics statistics;
+};
+
 struct process;
 struct task
 {
@@ -37,9 +91,57 @@ struct task
     // Timestamp of when this task should awake again. Set to zero and awake to false for a permenant sleep that needs manual interruption.
     long awake_at;
 
-    // The process associated with this task
+    // The process associated with this task, NULL for kernel threads
     struct process* process;
 
+    // Flags relating to this task
+    TASK_FLAGS flags;
+
+    // The kernel stack for kernel threads, user tasks use the process stack instead
+    void* kernel_stack;
+
+    // The physical pointer to the user stack for threads, the main task uses the process stack instead
+    void* stack;
+
+    // The id of this thread within its process, the main task is thread zero
+    int thread_id;
+
+    // The exit code of this thread once it has exited
+    int exit_code;
+
+    // The task waiting for this thread to exit, NULL if nobody is waiting
+    struct task* joiner;
+
+    // Where in the joiner's memory our exit code is written, NULL if the joiner doesn't want it
+    void* joiner_exit_code;
+
+    // The priority requested for this task, zero is the highest. Schedulers may ignore this
+    int priority;
+
+    // The priority level the scheduler currently has this task at, zero is the highest
+    int level;
+
+    // The timer ticks this task has used at its current level
+    int ticks_used;
+
+    // Where this task has been spending its time
+    struct task_statistics statistics;
+
+    // The processor a pinned task must run on
+    int cpu;
+
+    // The processor whose run queue this task belongs to, other processors only take it when they are idle
+    int home_cpu;
+
+    // The processor running this task right now, -1 when it is not running
+    int running_cpu;
+
+    // The saved FPU and SSE registers, NULL until the task first uses the FPU
+    void* fpu_state;
+
+    // The name shown for kernel threads, tasks of a process are shown with its file name
+    const char* name;
+
     // The next task in the linked list
     struct task* next;
 
@@ -51,6 +153,82 @@ struct task
 
 struct interrupt_frame;
 
+/**
+ * Should return the next task to run after the given task, NULL if no task is awake
+ */
+typedef struct task *(*TASK_SCHEDULER_NEXT_FUNCTION)(struct task *current);
+
+/**
+ * Called on every timer tick for the running task. Should return true if the task should be switched out
+ */
+typedef bool (*TASK_SCHEDULER_TICK_FUNCTION)(struct task *current);
+
+/**
+ * Called when something happens to the given task that the scheduler may care about
+ */
+typedef void (*TASK_SCHEDULER_TASK_FUNCTION)(struct task *task);
+
+struct task_scheduler
+{
+    TASK_SCHEDULER_NEXT_FUNCTION next;
+    TASK_SCHEDULER_TICK_FUNCTION tick;
+
+    // Called when a task wakes up after waiting for user input
+    TASK_SCHEDULER_TASK_FUNCTION boost;
+
+    // Called when the priority of a task changes
+    TASK_SCHEDULER_TASK_FUNCTION priority_changed;
+
+    char name[20];
+};
+
+/**
+ * Loads the built in schedulers and selects the default scheduler
+ */
+void task_scheduler_init();
+
+/**
+ * Adds a new scheduler to our system
+ */
+void task_scheduler_insert(struct task_scheduler *scheduler);
+
+/**
+ * Selects the scheduler with the given name, returns below zero if no such scheduler exists
+ */
+int task_scheduler_set(const char *name);
+
+/**
+ * Returns true if the current processor may switch to the given task.
+ * Schedulers must use this rather than checking if the task is awake
+ */
+bool task_is_runnable(struct task *task);
+
+/**
+ * Returns the first task in the task queue
+ */
+struct task *task_list_head();
+
+/**
+ * Called on every timer tick, returns true if the running task should be switched out
+ */
+bool task_tick();
+
+/**
+ * Wakes the given task that was waiting on user input, schedulers may give it a boost
+ */
+void task_wake_interactive(struct task *task);
+
+/**
+ * Sets the priority of the given task, zero is the highest priority
+ */
+int task_set_priority(struct task *task, int priority);
+
+/**
+ * Takes a snapshot of up to "max" tasks including the idle task into the provided array.
+ * Returns the amount of tasks written
+ */
+int task_get_info(struct task_info *info, int max);
+
 
 /**
  * Called frequently by the PIT timer. Should process anything important relating to the task mechnism
@@ -58,6 +236,12 @@ struct interrupt_frame;
  */
 void task_process();
 
+/**
+ * Returns the milliseconds until the timer of the processor we are running on is next needed, either to wake
+ * one of its sleeping tasks or to end its current timeslice. Returns below zero if nothing is waiting on the timer
+ */
+long task_next_deadline();
+
 /**
  * Wakes the given task allowing it to run once again
  */
@@ -74,6 +258,12 @@ void task_pause(struct task* task);
  * They must be initialized correctly!
  */
 void task_return(struct registers* regs);
+
+/**
+ * Returns to the given kernel thread based on the registers provided.
+ * Kernel threads stay in ring zero so the stack pointer is switched manually before returning
+ */
+void task_return_kernel(struct registers* regs);
 void restore_general_purpose_registers(struct registers* regs);
 
 
@@ -96,6 +286,18 @@ int copy_string_to_task(struct task* task, void* virtual_address, const char* va
 int copy_string_from_task(struct task *task, void *virtual, void *phys, int max);
 
 
+/**
+ * Copies "size" bytes from the kernel address provided to the task's virtual address provided.
+ * The virtual memory must be accessible from user space. Returns 0 on success, below zero is an error
+ */
+int copy_to_task(struct task *task, void *virtual, void *phys, int size);
+
+/**
+ * Copies "size" bytes from the task's virtual address provided to the kernel address provided.
+ * The virtual memory must be accessible from user space. Returns 0 on success, below zero is an error
+ */
+int copy_from_task(struct task *task, void *phys, void *virtual, int size);
+
 /**
  * Sets the given stack item index to the given value provided
  */
@@ -153,11 +355,25 @@ int task_page_task(struct task* task);
 void task_run_first_ever_task();
 
 /**
- * Switches to the next task, used for multi-tasking purposes, flips back around when it reaches
- * the end of the task queue. No priority is currently implemented
+ * Switches to the next task chosen by the current scheduler
  */
 void task_next();
 
+/**
+ * Adds the given task to the end of the task queue so that it will be scheduled
+ */
+void task_list_add(struct task* task);
+
+/**
+ * Sets the task to run when no other task is awake. The idle task must not be in the task queue
+ */
+void task_set_idle(struct task* task);
+
+/**
+ * Returns true if the given task is a kernel thread
+ */
+bool task_is_kernel_thread(struct task* task);
+
 /**
  * Resumes the given task allow it to run once again
  */
@@ -205,4 +421,15 @@ void task_usleep(struct task* task, uint32_t milis);
  */
 int task_free(struct task* task);
 
+/**
+ * Pauses every task of the process and marks them to be reaped if any of them is running on another processor,
+ * that processor is told to switch away. Returns true if it did so, the tasks are freed once they have left their processor
+ */
+bool task_stop_process(struct process* process);
+
+/**
+ * Returns true if any task in the task list belongs to the process
+ */
+bool task_process_has_tasks(struct process* process);
+
 #endif
\ No newline at end of file
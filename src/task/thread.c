@@ -0,0 +1,176 @@
+#include "thread.h"
+#include "task.h"
+#include "process.h"
+#include "memory/kheap.h"
+#include "memory/paging/paging.h"
+#include "status.h"
+#include "config.h"
+#include "kernel.h"
+
+static int thread_get_free_slot(struct process *process)
+{
+    // Slot zero is always the main task
+    for (int i = 1; i < COS32_MAX_THREADS_PER_PROCESS; i++)
+    {
+        if (process->threads[i] == 0)
+            return i;
+    }
+
+    return -ENOMEM;
+}
+
+static struct task *thread_get(struct process *process, int thread_id)
+{
+    if (thread_id <= 0 || thread_id >= COS32_MAX_THREADS_PER_PROCESS)
+    {
+        return 0;
+    }
+
+    return process->threads[thread_id];
+}
+
+/**
+ * The stack was mapped for user access, puts it back how paging_new_4gb left it so the process can't
+ * touch the memory once the heap gives it to someone else. Must be done before the stack is freed
+ */
+static void thread_release_stack(struct task *task)
+{
+    struct process *process = task->process;
+    paging_map_to(process->task->page_directory->directory_entry, task->stack, task->stack, paging_align_address(task->stack + COS32_USER_PROGRAM_STACK_SIZE), PAGING_PAGE_PRESENT | PAGING_CACHE_DISABLED);
+}
+
+/**
+ * Frees the given thread, it must not be the current task
+ */
+static void thread_free(struct task *task)
+{
+    struct process *process = task->process;
+    process->threads[task->thread_id] = 0;
+    thread_release_stack(task);
+    task_free(task);
+}
+
+int thread_create(struct process *process, void *entry, void *function, void *arg)
+{
+    int res = 0;
+    struct task *task = 0;
+    int thread_id = thread_get_free_slot(process);
+    if (thread_id < 0)
+    {
+        res = thread_id;
+        goto out;
+    }
+
+    task = kzalloc(sizeof(struct task));
+    if (!task)
+    {
+        res = -ENOMEM;
+        goto out;
+    }
+
+    task->stack = kzalloc(COS32_USER_PROGRAM_STACK_SIZE);
+    if (!task->stack)
+    {
+        res = -ENOMEM;
+        goto out;
+    }
+
+    // The stack is mapped to the same address in the shared page directory so the kernel and thread agree on it
+    res = process_paging_map_to(process, task->stack, task->stack, paging_align_address(task->stack + COS32_USER_PROGRAM_STACK_SIZE), PAGING_ACCESS_FROM_ALL | PAGING_PAGE_PRESENT | PAGING_PAGE_WRITEABLE);
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    task->flags = TASK_FLAG_THREAD;
+    task->page_directory = process->task->page_directory;
+    task->process = process;
+    task->thread_id = thread_id;
+    task->awake = true;
+
+    // The entry point expects the function and its argument on the stack, stack grows downwards
+    uint32_t *sp_ptr = (uint32_t *)(task->stack + COS32_USER_PROGRAM_STACK_SIZE);
+    *--sp_ptr = (uint32_t)arg;
+    *--sp_ptr = (uint32_t)function;
+
+    task->registers.ip = (uint32_t)entry;
+    task->registers.ss = USER_DATA_SEGMENT;
+    task->registers.cs = USER_CODE_SEGMENT;
+    task->registers.esp = (uint32_t)sp_ptr;
+
+    process->threads[thread_id] = task;
+    task_list_add(task);
+    res = thread_id;
+
+out:
+    if (ISERR(res) && task)
+    {
+        kfree(task->stack);
+        kfree(task);
+    }
+    return res;
+}
+
+int thread_exit(struct task *task, int exit_code)
+{
+    if (!(task->flags & TASK_FLAG_THREAD))
+    {
+        return -EINVARG;
+    }
+
+    task_pause(task);
+    task->flags |= TASK_FLAG_EXITED;
+    task->exit_code = exit_code;
+
+    if (task->joiner)
+    {
+        // The join succeeded, the exit code is handed over in the joiner's memory
+        task->joiner->registers.eax = 0;
+        if (task->joiner_exit_code)
+        {
+            copy_to_task(task->joiner, task->joiner_exit_code, &exit_code, sizeof(exit_code));
+        }
+        task_wake(task->joiner);
+
+        // We can't free ourselves whilst running, the task mechanism will do it for us.
+        // We never return to user space so the stack can be taken from the process now
+        task->process->threads[task->thread_id] = 0;
+        thread_release_stack(task);
+        task->flags |= TASK_FLAG_REAP;
+    }
+
+    return 0;
+}
+
+int thread_join(struct task *task, int thread_id, void *exit_code_out)
+{
+    struct task *thread = thread_get(task->process, thread_id);
+    if (!thread || thread == task || thread->joiner)
+    {
+        return -EINVARG;
+    }
+
+    if (thread->flags & TASK_FLAG_EXITED)
+    {
+        int exit_code = thread->exit_code;
+        thread_free(thread);
+        return exit_code_out ? copy_to_task(task, exit_code_out, &exit_code, sizeof(exit_code)) : 0;
+    }
+
+    // We sleep until the thread exits and hands us its exit code
+    thread->joiner = task;
+    thread->joiner_exit_code = exit_code_out;
+    task_pause(task);
+    return 0;
+}
+
+void thread_free_all(struct process *process)
+{
+    for (int i = 1; i < COS32_MAX_THREADS_PER_PROCESS; i++)
+    {
+        if (process->threads[i] != 0)
+        {
+            thread_free(process->threads[i]);
+        }
+    }
+}
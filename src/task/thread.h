@@ -0,0 +1,32 @@
+#ifndef THREAD_H
+#define THREAD_H
+
+struct process;
+struct task;
+
+/**
+ * Creates a new thread for the given process that shares the process address space.
+ * The thread gets its own user stack, execution starts at "entry" with "function" and "arg" pushed to its stack.
+ * Returns the thread id or below zero on error
+ */
+int thread_create(struct process *process, void *entry, void *function, void *arg);
+
+/**
+ * Exits the given thread with the provided exit code. Anyone joining the thread is woken up.
+ * The main thread cannot exit this way, it lives for as long as its process
+ */
+int thread_exit(struct task *task, int exit_code);
+
+/**
+ * Waits for the thread with the given id to exit, its exit code is written to "exit_code_out" in the memory of
+ * the calling task unless it is NULL. If the thread has already exited we return at once, otherwise the calling
+ * task is paused until the thread exits. Returns zero or below zero on error
+ */
+int thread_join(struct task *task, int thread_id, void *exit_code_out);
+
+/**
+ * Frees all the threads of the process except the main task
+ */
+void thread_free_all(struct process *process);
+
+#endif
@@ -0,0 +1,21 @@
+[BITS 32]
+section .asm
+
+global clock_read_tsc
+global clock_divide
+
+; uint64_t clock_read_tsc()
+clock_read_tsc:
+    ; The time stamp counter is returned in edx:eax which is exactly how a 64 bit value is returned
+    rdtsc
+    ret
+
+; uint32_t clock_divide(uint64_t dividend, uint32_t divisor)
+clock_divide:
+    push ebp
+    mov ebp, esp
+    mov eax, [ebp+8]
+    mov edx, [ebp+12]
+    div dword [ebp+16]
+    pop ebp
+    ret
@@ -0,0 +1,84 @@
+#include "clock.h"
+#include "pit.h"
+#include "kernel.h"
+#include "cpu/cpu.h"
+
+// The time stamp counter when the clock was initialized
+static uint64_t tsc_start = 0;
+static uint32_t tsc_khz = 0;
+
+// Nanoseconds per cycle shifted left by CLOCK_SHIFT
+static uint32_t tsc_mult = 0;
+
+/**
+ * Counts the time stamp counter cycles whilst PIT channel 2 counts down CLOCK_CALIBRATION_MS
+ */
+static uint32_t clock_calibrate()
+{
+    uint64_t start = clock_read_tsc();
+    pit_busy_wait(CLOCK_CALIBRATION_MS);
+    uint64_t end = clock_read_tsc();
+
+    return (uint32_t)(end - start);
+}
+
+void clock_init()
+{
+    if (!cpu_has_features_edx(CPU_FEATURE_EDX_TSC))
+    {
+        print("No time stamp counter, the clock will use the PIT\n");
+        return;
+    }
+
+    uint32_t cycles = clock_calibrate();
+    tsc_khz = cycles / CLOCK_CALIBRATION_MS;
+    if (tsc_khz == 0)
+    {
+        print("Failed to calibrate the time stamp counter, the clock will use the PIT\n");
+        return;
+    }
+
+    tsc_mult = clock_divide((uint64_t)1000000 << CLOCK_SHIFT, tsc_khz);
+    tsc_start = clock_read_tsc();
+}
+
+/**
+ * Converts time stamp counter cycles into nanoseconds without 64 bit division.
+ * The upper and lower halves are scaled separately so the multiplication can not overflow
+ */
+static uint64_t clock_cycles_to_ns(uint64_t cycles)
+{
+    uint32_t high = cycles >> 32;
+    uint32_t low = cycles & 0xffffffff;
+    return (((uint64_t)high * tsc_mult) << (32 - CLOCK_SHIFT)) + (((uint64_t)low * tsc_mult) >> CLOCK_SHIFT);
+}
+
+uint64_t clock_ns()
+{
+    if (!tsc_khz)
+    {
+        return (uint64_t)pit_get_millis() * 1000000;
+    }
+
+    return clock_cycles_to_ns(clock_read_tsc() - tsc_start);
+}
+
+uint32_t clock_ms()
+{
+    return clock_divide(clock_ns(), 1000000);
+}
+
+uint32_t clock_tsc_khz()
+{
+    return tsc_khz;
+}
+
+uint32_t clock_tsc_mult()
+{
+    return tsc_khz ? tsc_mult : 0;
+}
+
+uint64_t clock_tsc_start()
+{
+    return tsc_start;
+}
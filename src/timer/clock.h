@@ -0,0 +1,48 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// How long we spend measuring the time stamp counter against the PIT at boot
+#define CLOCK_CALIBRATION_MS 10
+
+// The fixed point shift used when converting time stamp counter cycles to nanoseconds
+#define CLOCK_SHIFT 22
+
+/**
+ * Calibrates the time stamp counter against the PIT, must be called before the PIT is initialized
+ */
+void clock_init();
+
+/**
+ * Returns the nanoseconds since the clock was initialized, this never goes backwards.
+ * Falls back to PIT tick granularity on processors without a time stamp counter
+ */
+uint64_t clock_ns();
+
+/**
+ * Returns the milliseconds since the clock was initialized
+ */
+uint32_t clock_ms();
+
+/**
+ * Returns the frequency of the time stamp counter in kilohertz, zero if we are not using it
+ */
+uint32_t clock_tsc_khz();
+
+/**
+ * The values clock_ns converts with, so others can read the time from the time stamp counter themselves.
+ * The multiplier is zero if we are not using the time stamp counter
+ */
+uint32_t clock_tsc_mult();
+uint64_t clock_tsc_start();
+
+uint64_t clock_read_tsc();
+
+/**
+ * Divides the 64 bit dividend by the divisor, the result must fit into 32 bits
+ */
+uint32_t clock_divide(uint64_t dividend, uint32_t divisor);
+
+#endif
@@ -1,36 +1,177 @@
 
 #include "pit.h"
+#include "clock.h"
 #include "task/task.h"
-#include "video/video.h"
-#include "task/process.h"
 #include "io/io.h"
 #include "kernel.h"
+#include "config.h"
+#include "idt/controller.h"
+#include "cpu/cpu.h"
 static long ticks_since_initialized = 0;
 
+// True if we program the PIT one deadline at a time rather than letting it fire periodically
+static bool tickless = false;
+
+static void pit_set_periodic()
+{
+    if (interrupt_controller_has_timer())
+    {
+        interrupt_controller_timer(PIT_TIMER_AVERAGE_MS, true);
+        return;
+    }
+
+    // A reload value of zero is the slowest rate the PIT supports, roughly every 55 milliseconds
+    outb(PIT_COMMAND_PORT, PIT_COMMAND_CHANNEL_0_PERIODIC);
+    outb(PIT_CHANNEL_0_PORT, 0);
+    outb(PIT_CHANNEL_0_PORT, 0);
+}
+
+/**
+ * Returns the longest one shot deadline the timer in use can hold
+ */
+static long pit_oneshot_max_ms()
+{
+    if (!interrupt_controller_has_timer())
+    {
+        return PIT_ONESHOT_MAX_MS;
+    }
+
+    uint32_t max = interrupt_controller_current()->timer_max_ms;
+    return max < COS32_TIMER_IDLE_MAX_MS ? max : COS32_TIMER_IDLE_MAX_MS;
+}
+
+static void pit_set_oneshot(long millis)
+{
+    if (millis < 1)
+    {
+        millis = 1;
+    }
+
+    if (millis > pit_oneshot_max_ms())
+    {
+        millis = pit_oneshot_max_ms();
+    }
+
+    cpu_current()->timer_expires_at = pit_get_millis() + millis;
+    if (interrupt_controller_has_timer())
+    {
+        interrupt_controller_timer(millis, false);
+        return;
+    }
+
+    // Round up so we never interrupt just before the deadline
+    uint32_t count = (PIT_FREQUENCY * millis) / 1000 + 1;
+    outb(PIT_COMMAND_PORT, PIT_COMMAND_CHANNEL_0_ONESHOT);
+    outb(PIT_CHANNEL_0_PORT, count & 0xff);
+    outb(PIT_CHANNEL_0_PORT, (count >> 8) & 0xff);
+}
+
+/**
+ * Programs the timer of the processor we are running on for whatever it has due next, a sleeping task
+ * or the end of the current timeslice. When nothing is due we still interrupt at the longest interval the timer allows
+ */
+static void pit_program_next()
+{
+    long deadline = task_next_deadline();
+    long idle_max = pit_oneshot_max_ms();
+    pit_set_oneshot(deadline < 0 || deadline > idle_max ? idle_max : deadline);
+}
+
 void pit_init()
 {
     idt_register_interrupt_callback(ISR_TIMER_INTERRUPT, pit_interrupt);
+
+    // The interrupt controller's own timer replaces the PIT when it has one
+    if (!interrupt_controller_has_timer())
+    {
+        interrupt_controller_enable_irq(INTERRUPT_CONTROLLER_IRQ_TIMER);
+    }
+
+    // Without a time stamp counter the timer interrupts are our only way to keep time
+    tickless = COS32_TIMER_TICKLESS && clock_tsc_khz() != 0;
+    if (!tickless)
+    {
+        pit_set_periodic();
+        return;
+    }
+
+    pit_program_next();
 }
 
-void pit_interrupt(int interrupt)
+void pit_init_secondary()
 {
-    ticks_since_initialized += PIT_TIMER_AVERAGE_MS;
+    // Only the boot processor keeps the time, without the clock the rest just need to be preempted
+    if (!tickless)
+    {
+        interrupt_controller_timer(PIT_TIMER_AVERAGE_MS, true);
+        return;
+    }
 
+    pit_program_next();
+}
 
-    // Process paging functionality
-    paging_process(paging_current_chunk());
-    paging_process(kernel_page_get_chunk());
-
+void pit_interrupt(int interrupt)
+{
+    bool boot_processor = cpu_current()->id == 0;
+    if (!tickless && boot_processor)
+    {
+        ticks_since_initialized += PIT_TIMER_AVERAGE_MS;
+    }
 
-    // Process drawing functionality
-    video_process(process_current()->video);
-    
+    // Drawing and paging are processed by kernel threads, we keep the interrupt short
     // Let the task mechnism process some important things
     task_process();
 
-    // Acknowledge the interrupt
-    outb(PIC1, PIC_EOI);
-    task_next();
+    // We only switch task when the scheduler says so, otherwise the interrupt handler returns to the current task
+    bool switch_task = task_tick();
+
+    // The next deadline does not depend on which task we switch to so we can program it now
+    if (tickless)
+    {
+        pit_program_next();
+    }
+
+    if (switch_task)
+    {
+        // Acknowledge the interrupt
+        interrupt_controller_eoi(ISR_TIMER_INTERRUPT);
+        task_next();
+    }
+}
+
+void pit_reschedule()
+{
+    if (!tickless)
+    {
+        return;
+    }
+
+    long deadline = task_next_deadline();
+    if (deadline >= 0 && pit_get_millis() + deadline < cpu_current()->timer_expires_at)
+    {
+        pit_set_oneshot(deadline);
+    }
+}
+
+void pit_busy_wait(uint32_t millis)
+{
+    uint32_t count = (PIT_FREQUENCY * millis) / 1000;
+
+    // Enable the gate for channel 2 but keep the speaker off
+    outb(PIT_CHANNEL_2_GATE_PORT, (insb(PIT_CHANNEL_2_GATE_PORT) & ~0x02) | 0x01);
+    outb(PIT_COMMAND_PORT, PIT_COMMAND_CHANNEL_2_ONESHOT);
+    outb(PIT_CHANNEL_2_PORT, count & 0xff);
+    outb(PIT_CHANNEL_2_PORT, (count >> 8) & 0xff);
+
+    // Bit 5 is the output of channel 2 which goes high once the count reaches zero
+    while (!(insb(PIT_CHANNEL_2_GATE_PORT) & 0x20))
+    {
+    }
+}
+
+bool pit_is_tickless()
+{
+    return tickless;
 }
 
 /**
@@ -38,5 +179,10 @@ void pit_interrupt(int interrupt)
  */
 long pit_get_millis()
 {
+    // Interrupts no longer arrive at a fixed rate so the clock keeps the time
+    if (tickless)
+    {
+        return clock_ms();
+    }
     return ticks_since_initialized;
-}
\ No newline at end of file
+}
@@ -2,17 +2,59 @@
 #define PIT_H
 
 #include <stdint.h>
+#include <stdbool.h>
 #include "idt/idt.h"
 
 // The average miliseconds the PIT timer takes to interrupt us
 #define PIT_TIMER_AVERAGE_MS 55
 
+// The frequency of the PIT's oscillator in hertz
+#define PIT_FREQUENCY 1193182
+
+// The longest one shot deadline the 16 bit counter can hold
+#define PIT_ONESHOT_MAX_MS 54
+
+#define PIT_CHANNEL_0_PORT 0x40
+#define PIT_CHANNEL_2_PORT 0x42
+#define PIT_COMMAND_PORT 0x43
+// Controls the gate of PIT channel 2 and reports its output
+#define PIT_CHANNEL_2_GATE_PORT 0x61
+
+// Channel 0, low byte then high byte, mode 3 square wave generator
+#define PIT_COMMAND_CHANNEL_0_PERIODIC 0x36
+// Channel 0, low byte then high byte, mode 0 interrupt on terminal count
+#define PIT_COMMAND_CHANNEL_0_ONESHOT 0x30
+// Channel 2, low byte then high byte, mode 0 interrupt on terminal count
+#define PIT_COMMAND_CHANNEL_2_ONESHOT 0xB0
+
 void pit_init();
 void pit_interrupt(int interrupt);
 
+/**
+ * Starts the timer of an application processor, the boot processor must have called pit_init
+ */
+void pit_init_secondary();
+
 /**
  * Returns the total miliseconds since the PIT timer has been interrupting us
  */
 long pit_get_millis();
 
-#endif
\ No newline at end of file
+/**
+ * Spins for the given milliseconds using PIT channel 2, this works without interrupts.
+ * Used to calibrate other timers against the PIT, "millis" must be no more than PIT_ONESHOT_MAX_MS
+ */
+void pit_busy_wait(uint32_t millis);
+
+/**
+ * Returns true if the PIT is only interrupting us when a deadline is due
+ */
+bool pit_is_tickless();
+
+/**
+ * Call this when a new deadline of the processor we are running on may be sooner than the one its timer
+ * was programmed with. Does nothing when the timer is periodic
+ */
+void pit_reschedule();
+
+#endif
@@ -42,6 +42,7 @@ int video_rectangle_set_pixel(struct video_rectangle *rect, int x, int y, char c
     int index = (y * rect->width) + x;
     rect->pixels[index] = colour;
     rect->redraw = true;
+    video_request_draw();
 
     return 0;
 }
@@ -199,11 +200,13 @@ void video_rectangle_register(struct video *video, struct video_rectangle *rect)
     {
         video->rectangles = list_item;
         video->rectangle_last = list_item;
+        video_request_draw();
         return;
     }
 
     video->rectangle_last->next = list_item;
     video->rectangle_last = list_item;
+    video_request_draw();
 }
 
 struct video_rectangle *video_rectangle_new(struct video *video, int x, int y, int width, int height)
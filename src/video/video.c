@@ -2,6 +2,9 @@
 #include "memory/memory.h"
 #include "memory/kheap.h"
 #include "task/process.h"
+#include "task/kthread.h"
+#include "timer/pit.h"
+#include "smp/smp.h"
 #include "video/font/font.h"
 #include "io/io.h"
 #include "string/string.h"
@@ -14,6 +17,15 @@
 void *video_default = 0;
 static struct video_font *console_font = 0;
 
+// The compositor kernel thread, it only runs when something visible has changed
+static struct task *compositor = 0;
+
+// True if something visible changed since the compositor last drew
+static bool video_changed = false;
+
+// True whilst the compositor sleeps until the next change
+static bool compositor_waiting = false;
+
 /* Hardware text mode color constants. */
 enum vga_color
 {
@@ -86,6 +98,8 @@ void terminal_backspace(struct terminal_properties *properties)
 }
 void terminal_putchar(struct terminal_properties *properties, char c)
 {
+	video_request_draw();
+
 	// Backspace
 	if (c == 0x08)
 	{
@@ -157,6 +171,7 @@ void video_terminal_set_scroll(struct terminal_properties *properties, int scrol
 		return;
 
 	properties->y_scroll = scroll;
+	video_request_draw();
 }
 
 /**
@@ -219,6 +234,57 @@ void video_process(struct video *video)
 	}
 }
 
+void video_request_draw()
+{
+	video_changed = true;
+
+	// Whilst the compositor waits out a frame it will see the change without being woken
+	if (compositor_waiting)
+	{
+		compositor_waiting = false;
+		task_wake(compositor);
+	}
+}
+
+static void video_compositor(void *arg)
+{
+	while (1)
+	{
+		// The kernel is not re-entrant, we must not be interrupted whilst drawing
+		disable_interrupts();
+		smp_lock_kernel();
+		if (!video_changed)
+		{
+			compositor_waiting = true;
+			kthread_wait();
+			continue;
+		}
+
+		struct process *process = process_current();
+		if (process)
+		{
+			video_process(process->video);
+		}
+
+		// Drawing changes rectangles too, those changes are already on the screen
+		video_changed = false;
+		smp_unlock_kernel();
+		enable_interrupts();
+
+		// Changes made whilst we wait are drawn together in the next frame
+		kthread_sleep(PIT_TIMER_AVERAGE_MS);
+	}
+}
+
+void video_compositor_start()
+{
+	compositor = kthread_create("compositor", video_compositor, 0);
+	if (ISERR(compositor))
+	{
+		panic("Failed to start the video compositor\n");
+	}
+}
+
 void video_init()
 {
 	kernel_terminal_initialize();
@@ -308,4 +374,5 @@ void video_save(struct video *video)
 void video_restore(struct video *video)
 {
 	memcpy((void *)COS32_VIDEO_MEMORY_ADDRESS_START, video->ptr, COS32_VIDEO_MEMORY_SIZE);
+	video_request_draw();
 }
\ No newline at end of file
@@ -72,6 +72,16 @@ void video_init();
  */
 void video_process(struct video* video);
 
+/**
+ * Starts the compositor kernel thread that draws the current process video to the screen
+ */
+void video_compositor_start();
+
+/**
+ * Call this when anything that is drawn to the screen changes, the compositor sleeps until then
+ */
+void video_request_draw();
+
 /**
  * Draws a block of pixels to the screen based on the total rows and pixels per row arguments provided
  */